@@ -19,7 +19,7 @@ precision mediump float;
 in vec2 texCoord;
 out vec4 fragColor;
 
-const vec2 OUT_TEX_SIZE = vec2(1920.0f, 1080.0f);
+uniform vec2 iResolution;    // render target size, see ShaderPlayer::render()
 uniform float iTime;
 
 #define PI 3.14159265359
@@ -184,7 +184,6 @@ vec4 mk_eye(in vec2 vUV, in float b, in float t) {
 
 void main() {
 	vec2 fragCoord = gl_FragCoord.xy;
-	vec2 iResolution = OUT_TEX_SIZE;
 
     vec2 vUV = fragCoord.xy / iResolution.xy;
     vUV.x *= iResolution.x / iResolution.y;
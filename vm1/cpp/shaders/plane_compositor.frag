@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+// All planes of one output in a single full screen pass (see PlaneCompositor).
+// Every plane does what plane_with_effects.frag does without effect modules,
+// the fixed function blending between the planes is done here as well.
+
+#version 310 es
+
+precision mediump float;
+
+in vec4 color;
+in vec2 texCoord;
+in float offset;
+
+out vec4 fragColor;
+
+const int MAX_PLANES = 4;
+
+// blend modes (see PlaneSettings::BlendMode)
+const int BLEND_ALPHA = 0;
+const int BLEND_MULTIPLY = 1;
+const int BLEND_ADD = 2;
+
+// direct sources (see DirectSourceType in MediaPlayer.h)
+const int SOURCE_RGB = 0;
+const int SOURCE_SAND128 = 1;
+const int SOURCE_UYVY = 2;
+const int SOURCE_YUYV = 3;
+
+// two sources and a color LUT per plane
+uniform sampler2D inputTexture0;
+uniform sampler2D inputTexture1;
+uniform sampler2D inputTexture2;
+uniform sampler2D inputTexture3;
+uniform sampler2D inputTexture4;
+uniform sampler2D inputTexture5;
+uniform sampler2D inputTexture6;
+uniform sampler2D inputTexture7;
+uniform mediump sampler3D colorLut0;
+uniform mediump sampler3D colorLut1;
+uniform mediump sampler3D colorLut2;
+uniform mediump sampler3D colorLut3;
+
+// Same layout as CompositorPlane in PlaneCompositor.h
+struct Plane {
+	highp vec4 mapA[2];         // output position -> texture coordinate, triangle 0 1 2 of the quad
+	highp vec4 mapB[2];         // triangle 0 2 3
+	vec4 mixing;                // mixValue, opacity, chroma key enable
+	ivec4 modes;                // blend mode, isTex0Valid, isTex1Valid
+	ivec4 sourceTypes;          // sourceType0, sourceType1
+	highp ivec4 sourceLayout0;  // SAND128: viewWidth, columnHeight, lumaHeight, stripCount
+	highp ivec4 sourceLayout1;
+	highp vec4 sourceSizes;     // sourceSize0, sourceSize1
+};
+
+layout(std140) uniform CompositorPlanes {
+	Plane planes[MAX_PLANES];
+	int planeCount;
+};
+
+// chroma key and color correction baked into a 3D LUT (see ColorLut), rgb: color, a: chroma key mask
+const float LUT_SIZE = 33.0;
+
+vec4 lookupColor(mediump sampler3D colorLut, vec3 color)
+{
+	// Texel centers of the first and the last entry
+	vec3 coord = clamp(color, 0.0, 1.0) * ((LUT_SIZE - 1.0) / LUT_SIZE) + 0.5 / LUT_SIZE;
+	return texture(colorLut, coord);
+}
+
+vec4 yuvToRgb(float y, float u, float v)
+{
+	return vec4(y + (1.403f * v),
+				y - (0.344f * u) - (0.714f * v),
+				y + (1.770f * u),
+				1.0f);
+}
+
+// Same addressing as video_sand.frag: the whole SAND128 buffer as one linear R8 image
+highp float fetchSandByte(sampler2D tex, highp int viewWidth, highp int byteIndex)
+{
+	return texelFetch(tex, ivec2(byteIndex % viewWidth, byteIndex / viewWidth), 0).r;
+}
+
+vec4 sampleSand128(sampler2D tex, highp ivec4 sandLayout, highp vec2 size, highp vec2 coord)
+{
+	highp int viewWidth = sandLayout.x;
+	highp int columnHeight = sandLayout.y;
+	highp int lumaHeight = sandLayout.z;
+	highp int stripCount = sandLayout.w;
+
+	highp int x = clamp(int(coord.x * float(stripCount * 128)), 0, stripCount * 128 - 1);
+	highp int y = clamp(int(coord.y * size.y), 0, lumaHeight - 1);
+
+	highp int strip = x / 128;
+	highp int columnX = x - strip * 128;
+	highp int columnStart = strip * 128 * columnHeight;
+	highp int chromaStart = columnStart + (lumaHeight + y / 2) * 128 + (columnX & ~1);
+
+	float luma = fetchSandByte(tex, viewWidth, columnStart + y * 128 + columnX);
+	float u = fetchSandByte(tex, viewWidth, chromaStart) - 0.5f;
+	float v = fetchSandByte(tex, viewWidth, chromaStart + 1) - 0.5f;
+	return yuvToRgb(luma, u, v);
+}
+
+// Packed 4:2:2 imported as RGBA8 of half width (see camera.frag and webcam.frag)
+vec4 sampleUyvy(sampler2D tex, highp vec2 size, highp vec2 coord)
+{
+	float pixelX = floor(coord.x * size.x);
+	vec4 uyvy = texture(tex, coord);
+	float y = mix(uyvy.g, uyvy.a, floor(mod(pixelX, 2.0)));
+	return yuvToRgb(y, uyvy.b - 0.5f, uyvy.r - 0.5f);
+}
+
+vec4 sampleYuyv(sampler2D tex, highp vec2 size, highp vec2 coord)
+{
+	float pixelX = floor(coord.x * size.x);
+	vec4 yuyv = texture(tex, coord);
+	float y = (mod(pixelX, 2.0) < 1.0) ? yuyv.b : yuyv.r;
+	return yuvToRgb(y, yuyv.g - 0.5f, yuyv.a - 0.5f);
+}
+
+vec4 sampleSource(sampler2D tex, int sourceType, highp ivec4 sandLayout, highp vec2 size, highp vec2 coord)
+{
+	if (sourceType == SOURCE_SAND128) return sampleSand128(tex, sandLayout, size, coord);
+	if (sourceType == SOURCE_UYVY) return sampleUyvy(tex, size, coord);
+	if (sourceType == SOURCE_YUYV) return sampleYuyv(tex, size, coord);
+	return texture(tex, coord);
+}
+
+bool isInside(highp vec2 uv)
+{
+	return all(greaterThanEqual(uv, vec2(0.0))) && all(lessThanEqual(uv, vec2(1.0)));
+}
+
+// Texture coordinate of the plane at an output position, the way the two triangles
+// of the per-plane quad interpolate it. False outside of the quad.
+bool planeUV(int i, highp vec2 position, out highp vec2 uv)
+{
+	highp vec3 p = vec3(position, 1.0);
+	uv = vec2(dot(planes[i].mapA[0].xyz, p), dot(planes[i].mapA[1].xyz, p));
+	if (uv.y <= uv.x && isInside(uv)) return true;
+	uv = vec2(dot(planes[i].mapB[0].xyz, p), dot(planes[i].mapB[1].xyz, p));
+	return uv.x <= uv.y && isInside(uv);
+}
+
+// Samplers can't be indexed dynamically, so every plane gets its own call with its textures
+void compositePlane(inout vec4 dst, int i, sampler2D tex0, sampler2D tex1, mediump sampler3D colorLut, highp vec2 position)
+{
+	if (i >= planeCount) return;
+
+	highp vec2 uv;
+	if (!planeUV(i, position, uv)) return;
+
+	// Mix images
+	highp vec2 coord = vec2(uv.x, 1.0f - uv.y);
+	vec4 col0 = vec4(0.0, 0.0, 0.0, 0.0);
+	vec4 col1 = vec4(0.0, 0.0, 0.0, 0.0);
+	if (planes[i].modes.y > 0) col0 = sampleSource(tex0, planes[i].sourceTypes.x, planes[i].sourceLayout0, planes[i].sourceSizes.xy, coord);
+	if (planes[i].modes.z > 0) col1 = sampleSource(tex1, planes[i].sourceTypes.y, planes[i].sourceLayout1, planes[i].sourceSizes.zw, coord);
+	vec4 color = mix(col0, col1, planes[i].mixing.x);
+
+	// chroma key and color correction
+	vec4 lut = lookupColor(colorLut, color.rgb);
+	float chromaKey_Mask = lut.a;
+	color.a = mix(max(color.a - chromaKey_Mask, 0.0), color.a, 1.0 - planes[i].mixing.z);
+	color.rgb = lut.rgb;
+
+	float opacity = planes[i].mixing.y;
+	int blendMode = planes[i].modes.x;
+	color.rgb = mix(color.rgb, color.rgb * opacity, float(blendMode == BLEND_ADD));
+	color.rgb = mix(color.rgb,
+					mix(vec3(1.0f),
+					    color.rgb,
+						opacity * (1.0 - chromaKey_Mask)),
+					float(blendMode == BLEND_MULTIPLY));
+	color.a *= opacity;
+
+	// Blending as set up by PlaneRenderer::update(), on a normalized framebuffer
+	color = clamp(color, 0.0, 1.0);
+	if (blendMode == BLEND_MULTIPLY) {
+		dst = dst * color;                                  // GL_ZERO, GL_SRC_COLOR
+	}
+	else if (blendMode == BLEND_ADD) {
+		dst = min(dst + color, 1.0);                        // GL_ONE, GL_ONE
+	}
+	else {
+		dst = color * color.a + dst * (1.0 - color.a);      // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+	}
+}
+
+void main() {
+	highp vec2 position = texCoord * 2.0 - 1.0;
+
+	// Clear color of the outputs
+	vec4 dst = vec4(0.0, 0.0, 0.0, 1.0);
+	compositePlane(dst, 0, inputTexture0, inputTexture1, colorLut0, position);
+	compositePlane(dst, 1, inputTexture2, inputTexture3, colorLut1, position);
+	compositePlane(dst, 2, inputTexture4, inputTexture5, colorLut2, position);
+	compositePlane(dst, 3, inputTexture6, inputTexture7, colorLut3, position);
+
+	fragColor = dst;
+}
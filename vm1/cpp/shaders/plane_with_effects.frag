@@ -31,62 +31,118 @@ uniform float opacity;
 uniform int isMultiplication;
 uniform int isAdd;
 
+// direct sources (see DirectSourceType in MediaPlayer.h)
+const int SOURCE_RGB = 0;
+const int SOURCE_SAND128 = 1;
+const int SOURCE_UYVY = 2;
+const int SOURCE_YUYV = 3;
+uniform int sourceType0;
+uniform int sourceType1;
+uniform highp ivec4 sourceLayout0; // SAND128: viewWidth, columnHeight, lumaHeight, stripCount
+uniform highp ivec4 sourceLayout1;
+uniform highp vec2 sourceSize0;
+uniform highp vec2 sourceSize1;
+
 uniform float iTime;
 uniform float analog0;
 uniform float analog1;
 uniform float analog2;
 uniform float analog3;
 
-// color correction
-uniform float ColorCorrection_Brightness; // { "name": "Brightness", "group": "Color Correction", "min": -1.0, "max": 1.0 }
-uniform float ColorCorrection_Contrast;	  // { "name": "Contrast",   "group": "Color Correction", "min": -1.0, "max": 1.0 }
-uniform float ColorCorrection_Saturation; // { "name": "Saturation", "group": "Color Correction", "min": -1.0, "max": 1.0 }
+// effect parameters, packed into one std140 uniform buffer per plane (see UniformBlockBuffer).
+// Color correction and chroma key are applied through colorLut, std140 keeps them active for the menus.
+layout(std140) uniform EffectParams {
+	// color correction
+	float ColorCorrection_Brightness; // { "name": "Brightness", "group": "Color Correction", "min": -1.0, "max": 1.0 }
+	float ColorCorrection_Contrast;	  // { "name": "Contrast",   "group": "Color Correction", "min": -1.0, "max": 1.0 }
+	float ColorCorrection_Saturation; // { "name": "Saturation", "group": "Color Correction", "min": -1.0, "max": 1.0 }
+
+	// chroma key
+	int ChromaKey_Enable;      // { "name": "Enable", 	 "group": "Chroma Key", "min": 0,     "max": 1,     "default": 0 }
+	float ChromaKey_RangeLow;  // { "name": "Range Low", "group": "Chroma Key", "min": 0.001, "max": 0.999, "default": 0.005, "step": 0.001 }
+	float ChromaKey_RangeHigh; // { "name": "Range Low", "group": "Chroma Key", "min": 0.001, "max": 0.999, "default": 0.26, "step": 0.001 }
+	float ChromaKey_ColorR;    // { "name": "Red", 		 "group": "Chroma Key", "min": 0.0,   "max": 1.0,   "default": 0.05, "step": 0.01 }
+	float ChromaKey_ColorG;    // { "name": "Green", 	 "group": "Chroma Key", "min": 0.0,   "max": 1.0,   "default": 0.63, "step": 0.01 }
+	float ChromaKey_ColorB;    // { "name": "Blue", 	 "group": "Chroma Key", "min": 0.0,   "max": 1.0,   "default": 0.14, "step": 0.01 }
+};
+
+// chroma key and color correction baked into a 3D LUT (see ColorLut), rgb: color, a: chroma key mask
+uniform mediump sampler3D colorLut;
+const float LUT_SIZE = 33.0;
+
+vec4 lookupColor(vec3 color)
+{
+	// Texel centers of the first and the last entry
+	vec3 coord = clamp(color, 0.0, 1.0) * ((LUT_SIZE - 1.0) / LUT_SIZE) + 0.5 / LUT_SIZE;
+	return texture(colorLut, coord);
+}
 
-vec3 adjustBrightness(vec3 color, float value) {
-  return color + value;
+vec4 yuvToRgb(float y, float u, float v)
+{
+	return vec4(y + (1.403f * v),
+				y - (0.344f * u) - (0.714f * v),
+				y + (1.770f * u),
+				1.0f);
 }
 
-vec3 adjustContrast(vec3 color, float value) {
-  return 0.5 + (1.0 + value) * (color - 0.5);
+// Same addressing as video_sand.frag: the whole SAND128 buffer as one linear R8 image
+highp float fetchSandByte(sampler2D tex, highp int viewWidth, highp int byteIndex)
+{
+	return texelFetch(tex, ivec2(byteIndex % viewWidth, byteIndex / viewWidth), 0).r;
 }
 
-vec3 adjustSaturation(vec3 color, float value) {
-  // https://www.w3.org/TR/WCAG21/#dfn-relative-luminance
-  const vec3 luminosityFactor = vec3(0.2126, 0.7152, 0.0722);
-  vec3 grayscale = vec3(dot(color, luminosityFactor));
-  return mix(grayscale, color, 1.0 + value);
+vec4 sampleSand128(sampler2D tex, highp ivec4 sandLayout, highp vec2 size, highp vec2 coord)
+{
+	highp int viewWidth = sandLayout.x;
+	highp int columnHeight = sandLayout.y;
+	highp int lumaHeight = sandLayout.z;
+	highp int stripCount = sandLayout.w;
+
+	highp int x = clamp(int(coord.x * float(stripCount * 128)), 0, stripCount * 128 - 1);
+	highp int y = clamp(int(coord.y * size.y), 0, lumaHeight - 1);
+
+	highp int strip = x / 128;
+	highp int columnX = x - strip * 128;
+	highp int columnStart = strip * 128 * columnHeight;
+	highp int chromaStart = columnStart + (lumaHeight + y / 2) * 128 + (columnX & ~1);
+
+	float luma = fetchSandByte(tex, viewWidth, columnStart + y * 128 + columnX);
+	float u = fetchSandByte(tex, viewWidth, chromaStart) - 0.5f;
+	float v = fetchSandByte(tex, viewWidth, chromaStart + 1) - 0.5f;
+	return yuvToRgb(luma, u, v);
 }
 
-// chroma key (from https://www.shadertoy.com/view/MlVXWD)
-uniform int ChromaKey_Enable;      // { "name": "Enable", 	 "group": "Chroma Key", "min": 0,     "max": 1,     "default": 0 }
-uniform float ChromaKey_RangeLow;  // { "name": "Range Low", "group": "Chroma Key", "min": 0.001, "max": 0.999, "default": 0.005, "step": 0.001 }
-uniform float ChromaKey_RangeHigh; // { "name": "Range Low", "group": "Chroma Key", "min": 0.001, "max": 0.999, "default": 0.26, "step": 0.001 }
-uniform float ChromaKey_ColorR;    // { "name": "Red", 		 "group": "Chroma Key", "min": 0.0,   "max": 1.0,   "default": 0.05, "step": 0.01 }
-uniform float ChromaKey_ColorG;    // { "name": "Green", 	 "group": "Chroma Key", "min": 0.0,   "max": 1.0,   "default": 0.63, "step": 0.01 }
-uniform float ChromaKey_ColorB;    // { "name": "Blue", 	 "group": "Chroma Key", "min": 0.0,   "max": 1.0,   "default": 0.14, "step": 0.01 }
+// Packed 4:2:2 imported as RGBA8 of half width (see camera.frag and webcam.frag)
+vec4 sampleUyvy(sampler2D tex, highp vec2 size, highp vec2 coord)
+{
+	float pixelX = floor(coord.x * size.x);
+	vec4 uyvy = texture(tex, coord);
+	float y = mix(uyvy.g, uyvy.a, floor(mod(pixelX, 2.0)));
+	return yuvToRgb(y, uyvy.b - 0.5f, uyvy.r - 0.5f);
+}
 
-mat4 RGBtoYUV = mat4(0.257,  0.439, -0.148, 0.0,
-                     0.504, -0.368, -0.291, 0.0,
-                     0.098, -0.071,  0.439, 0.0,
-                     0.0625, 0.500,  0.500, 1.0 );
+vec4 sampleYuyv(sampler2D tex, highp vec2 size, highp vec2 coord)
+{
+	float pixelX = floor(coord.x * size.x);
+	vec4 yuyv = texture(tex, coord);
+	float y = (mod(pixelX, 2.0) < 1.0) ? yuyv.b : yuyv.r;
+	return yuvToRgb(y, yuyv.g - 0.5f, yuyv.a - 0.5f);
+}
 
-float colorclose(vec3 yuv, vec3 keyYuv, vec2 tol)
+vec4 sampleSource(sampler2D tex, int sourceType, highp ivec4 sandLayout, highp vec2 size, highp vec2 coord)
 {
-    float tmp = sqrt(pow(keyYuv.g - yuv.g, 2.0) + pow(keyYuv.b - yuv.b, 2.0));
-    if (tmp < tol.x)
-      return 0.0;
-   	else if (tmp < tol.y)
-      return (tmp - tol.x)/(tol.y - tol.x);
-   	else
-      return 1.0;
+	if (sourceType == SOURCE_SAND128) return sampleSand128(tex, sandLayout, size, coord);
+	if (sourceType == SOURCE_UYVY) return sampleUyvy(tex, size, coord);
+	if (sourceType == SOURCE_YUYV) return sampleYuyv(tex, size, coord);
+	return texture(tex, coord);
 }
 
 vec4 colorAtUV(vec2 coord)
 {
 	vec4 col0 = vec4(0.0, 0.0, 0.0, 0.0);
 	vec4 col1 = vec4(0.0, 0.0, 0.0, 0.0);
-	if (isTex0Valid > 0) col0 = texture(inputTexture0, coord);
-	if (isTex1Valid > 0) col1 = texture(inputTexture1, coord);
+	if (isTex0Valid > 0) col0 = sampleSource(inputTexture0, sourceType0, sourceLayout0, sourceSize0, coord);
+	if (isTex1Valid > 0) col1 = sampleSource(inputTexture1, sourceType1, sourceLayout1, sourceSize1, coord);
 	return mix(col0, col1, mixValue);
 }
 
@@ -114,19 +170,11 @@ void main() {
 	//###EXT_MAIN_USE###
 	// extMain(color, coord); 
 
-	// chroma key
-	float chromaKey_Mask = 0.0;
-	vec4 chromaKey = vec4(ChromaKey_ColorR, ChromaKey_ColorG, ChromaKey_ColorB, 1);
-	vec2 chromaKey_MaskRange = vec2(ChromaKey_RangeLow, ChromaKey_RangeHigh);
-	vec4 keyYUV =  RGBtoYUV * chromaKey;
-	vec4 yuv = RGBtoYUV * color;
-	chromaKey_Mask = 1.0 - colorclose(yuv.rgb, keyYUV.rgb, chromaKey_MaskRange);
-	color = mix(max(color - chromaKey_Mask * chromaKey, 0.0), color, float(1 - ChromaKey_Enable));
-
-	// color correction
-	color.rgb = adjustSaturation(color.rgb, ColorCorrection_Saturation);
-	color.rgb = adjustContrast(color.rgb, ColorCorrection_Contrast);
-	color.rgb = adjustBrightness(color.rgb, ColorCorrection_Brightness);
+	// chroma key and color correction
+	vec4 lut = lookupColor(color.rgb);
+	float chromaKey_Mask = lut.a;
+	color.a = mix(max(color.a - chromaKey_Mask, 0.0), color.a, float(1 - ChromaKey_Enable));
+	color.rgb = lut.rgb;
 
 	color.rgb = mix(color.rgb, color.rgb * opacity, float(isAdd));
 	color.rgb = mix(color.rgb, 
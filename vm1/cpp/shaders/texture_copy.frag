@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#version 310 es
+precision highp float;
+
+out vec4 fragColor;
+
+// Texel exact copy of an R8 plane, the viewport has the size of the source
+uniform highp sampler2D inputTexture;
+
+void main() {
+    fragColor = texelFetch(inputTexture, ivec2(gl_FragCoord.xy), 0);
+}
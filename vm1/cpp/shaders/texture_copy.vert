@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#version 310 es
+
+// One triangle covering the viewport, drawn without vertex buffers (see LoopFrameCache)
+void main() {
+	vec2 pos = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+	gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
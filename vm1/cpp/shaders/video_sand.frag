@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+ 
+#version 310 es
+precision highp float;
+precision highp int;
+
+in vec2 texCoord;
+out vec4 fragColor;
+
+// The whole SAND128 buffer imported once as a linear R8 image of viewWidth bytes per row
+uniform highp sampler2D inputTexture;
+uniform int viewWidth;      // e.g. 2048
+uniform int columnHeight;   // rows per 128 byte column (luma + chroma), e.g. 1632
+uniform int lumaHeight;     // luma rows per column, e.g. 1088
+uniform float videoHeight;  // e.g. 1080
+uniform int stripCount;     // e.g. 15
+
+float fetchByte(int byteIndex) {
+    return texelFetch(inputTexture, ivec2(byteIndex % viewWidth, byteIndex / viewWidth), 0).r;
+}
+
+void main() {
+    // Same pixel mapping as the strip draws in video.vert/video.frag
+    int x = int(texCoord.x * float(stripCount * 128));
+    int y = min(int(texCoord.y * videoHeight), lumaHeight - 1);
+
+    int strip = x / 128;
+    int columnX = x - strip * 128;
+    int columnStart = strip * 128 * columnHeight;
+
+    // Chroma is interleaved UV at half vertical resolution below the luma rows
+    int chromaRow = lumaHeight + y / 2;
+    int chromaX = columnX & ~1;
+
+    float yValue = fetchByte(columnStart + y * 128 + columnX);
+    float u = fetchByte(columnStart + chromaRow * 128 + chromaX) - 0.5f;
+    float v = fetchByte(columnStart + chromaRow * 128 + chromaX + 1) - 0.5f;
+
+	float r = yValue + (1.403f * v);
+	float g = yValue - (0.344f * u) - (0.714f * v);
+	float b = yValue + (1.770f * u);
+
+    fragColor = vec4(r, g, b, 1.0f);
+}
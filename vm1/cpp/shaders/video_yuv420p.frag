@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#version 310 es
+precision mediump float;
+
+in vec2 texCoord;
+out vec4 fragColor;
+
+// Software decoded planar YUV 4:2:0, one R8 texture per plane (see VideoPlayer::uploadSoftwareFrame)
+uniform sampler2D textureY;
+uniform sampler2D textureU;
+uniform sampler2D textureV;
+
+void main() {
+    // Same orientation as video_sand.frag: the first image row ends up at the bottom of the target
+    vec2 coord = texCoord;
+
+    float yValue = texture(textureY, coord).r;
+    float u = texture(textureU, coord).r - 0.5f;
+    float v = texture(textureV, coord).r - 0.5f;
+
+    float r = yValue + (1.403f * v);
+    float g = yValue - (0.344f * u) - (0.714f * v);
+    float b = yValue + (1.770f * u);
+
+    fragColor = vec4(r, g, b, 1.0f);
+}
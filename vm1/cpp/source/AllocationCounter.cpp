@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef VM1_ALLOCATION_COUNTER
+
+static thread_local uint64_t s_threadAllocations = 0;
+
+static void* countedAlloc(std::size_t size)
+{
+    ++s_threadAllocations;
+    if (size == 0) size = 1;
+    void* ptr = std::malloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+bool alloccounter::isEnabled()
+{
+    return true;
+}
+
+uint64_t alloccounter::threadAllocations()
+{
+    return s_threadAllocations;
+}
+
+#else
+
+bool alloccounter::isEnabled()
+{
+    return false;
+}
+
+uint64_t alloccounter::threadAllocations()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Counts heap allocations per thread. Only active in debug builds
+// (VM1_ALLOCATION_COUNTER, set by meson when 'debug' is enabled),
+// in release builds all counts stay zero.
+namespace alloccounter {
+    bool isEnabled();
+    uint64_t threadAllocations();
+
+    // Counts the allocations done by the current thread while the scope is alive
+    class Scope {
+    public:
+        Scope() : m_start(threadAllocations()) {}
+        uint64_t count() const { return threadAllocations() - m_start; }
+
+    private:
+        uint64_t m_start = 0;
+    };
+
+    // Accumulates allocations per frame for a steady-state loop,
+    // ignoring the first frames that are expected to warm up buffers
+    class FrameStats {
+    public:
+        void add(uint64_t allocations) {
+            if (++m_frames > WARM_UP_FRAMES) m_allocations += allocations;
+        }
+        void reset() {
+            m_frames = 0;
+            m_allocations = 0;
+        }
+        uint64_t frames() const { return m_frames; }
+        uint64_t allocations() const { return m_allocations; }
+
+    private:
+        static constexpr uint64_t WARM_UP_FRAMES = 30;
+        std::atomic<uint64_t> m_frames = 0;
+        std::atomic<uint64_t> m_allocations = 0;
+    };
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "ColorLut.h"
+
+#include <SDL3/SDL.h>
+#include <GLES3/gl31.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+static float configValue(const ShaderConfig& shaderConfig, const std::string& name, float defaultValue)
+{
+    int index = shaderConfig.indexOf(name);
+    if (index < 0) return defaultValue;
+    const ShaderParamValue& value = shaderConfig.values[index];
+    return (value.type == ShaderParamType::Int) ? float(value.intValue) : value.floatValue.x;
+}
+
+ColorLutParams ColorLutParams::fromShaderConfig(const ShaderConfig& shaderConfig, const std::string& cubeFilename)
+{
+    ColorLutParams params;
+    params.brightness = configValue(shaderConfig, "ColorCorrection_Brightness", params.brightness);
+    params.contrast = configValue(shaderConfig, "ColorCorrection_Contrast", params.contrast);
+    params.saturation = configValue(shaderConfig, "ColorCorrection_Saturation", params.saturation);
+    params.isChromaKeyEnabled = configValue(shaderConfig, "ChromaKey_Enable", 0.0f) != 0.0f;
+    params.chromaKeyRangeLow = configValue(shaderConfig, "ChromaKey_RangeLow", params.chromaKeyRangeLow);
+    params.chromaKeyRangeHigh = configValue(shaderConfig, "ChromaKey_RangeHigh", params.chromaKeyRangeHigh);
+    params.chromaKeyColor = glm::vec3(configValue(shaderConfig, "ChromaKey_ColorR", 0.0f),
+                                      configValue(shaderConfig, "ChromaKey_ColorG", 0.0f),
+                                      configValue(shaderConfig, "ChromaKey_ColorB", 0.0f));
+    params.cubeFilename = cubeFilename;
+    return params;
+}
+
+bool ColorLutParams::operator==(const ColorLutParams& other) const
+{
+    return brightness == other.brightness &&
+           contrast == other.contrast &&
+           saturation == other.saturation &&
+           isChromaKeyEnabled == other.isChromaKeyEnabled &&
+           chromaKeyRangeLow == other.chromaKeyRangeLow &&
+           chromaKeyRangeHigh == other.chromaKeyRangeHigh &&
+           chromaKeyColor.x == other.chromaKeyColor.x &&
+           chromaKeyColor.y == other.chromaKeyColor.y &&
+           chromaKeyColor.z == other.chromaKeyColor.z &&
+           cubeFilename == other.cubeFilename;
+}
+
+glm::vec3 CubeLut::sample(const glm::vec3& color) const
+{
+    int i0[3];
+    int i1[3];
+    float f[3];
+    for (int c = 0; c < 3; ++c) {
+        float range = domainMax[c] - domainMin[c];
+        float t = (range > 0.0f) ? (color[c] - domainMin[c]) / range : 0.0f;
+        t = std::clamp(t, 0.0f, 1.0f) * float(size - 1);
+        i0[c] = std::min(int(t), size - 1);
+        i1[c] = std::min(i0[c] + 1, size - 1);
+        f[c] = t - float(i0[c]);
+    }
+
+    auto at = [this](int r, int g, int b) -> const glm::vec3& { return values[r + (g + b * size) * size]; };
+    glm::vec3 result(0.0f);
+    for (int c = 0; c < 3; ++c) {
+        float c00 = at(i0[0], i0[1], i0[2])[c] * (1.0f - f[0]) + at(i1[0], i0[1], i0[2])[c] * f[0];
+        float c10 = at(i0[0], i1[1], i0[2])[c] * (1.0f - f[0]) + at(i1[0], i1[1], i0[2])[c] * f[0];
+        float c01 = at(i0[0], i0[1], i1[2])[c] * (1.0f - f[0]) + at(i1[0], i0[1], i1[2])[c] * f[0];
+        float c11 = at(i0[0], i1[1], i1[2])[c] * (1.0f - f[0]) + at(i1[0], i1[1], i1[2])[c] * f[0];
+        float c0 = c00 * (1.0f - f[1]) + c10 * f[1];
+        float c1 = c01 * (1.0f - f[1]) + c11 * f[1];
+        result[c] = c0 * (1.0f - f[2]) + c1 * f[2];
+    }
+    return result;
+}
+
+bool loadCubeFile(const std::string& filename, CubeLut& cubeLut)
+{
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        SDL_Log("Couldn't open LUT: %s", filename.c_str());
+        return false;
+    }
+
+    cubeLut = CubeLut();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        std::istringstream stream(line.substr(start));
+        if (std::isdigit(static_cast<unsigned char>(line[start])) || line[start] == '-' || line[start] == '.') {
+            glm::vec3 value(0.0f);
+            if (!(stream >> value.x >> value.y >> value.z)) {
+                SDL_Log("Invalid LUT entry in %s, line %d", filename.c_str(), lineNumber);
+                return false;
+            }
+            cubeLut.values.push_back(value);
+            continue;
+        }
+
+        std::string keyword;
+        stream >> keyword;
+        if (keyword == "LUT_3D_SIZE") {
+            stream >> cubeLut.size;
+        }
+        else if (keyword == "DOMAIN_MIN") {
+            stream >> cubeLut.domainMin.x >> cubeLut.domainMin.y >> cubeLut.domainMin.z;
+        }
+        else if (keyword == "DOMAIN_MAX") {
+            stream >> cubeLut.domainMax.x >> cubeLut.domainMax.y >> cubeLut.domainMax.z;
+        }
+        else if (keyword == "LUT_1D_SIZE") {
+            SDL_Log("1D LUTs are not supported: %s", filename.c_str());
+            return false;
+        }
+        // TITLE and unknown keywords are ignored
+    }
+
+    if (cubeLut.size < 2 || cubeLut.size > 256) {
+        SDL_Log("Invalid LUT_3D_SIZE %d in %s", cubeLut.size, filename.c_str());
+        return false;
+    }
+    size_t expected = size_t(cubeLut.size) * cubeLut.size * cubeLut.size;
+    if (cubeLut.values.size() != expected) {
+        SDL_Log("LUT %s has %zu entries instead of %zu", filename.c_str(), cubeLut.values.size(), expected);
+        return false;
+    }
+    return true;
+}
+
+ColorLut::~ColorLut()
+{
+    if (m_texture) glDeleteTextures(1, &m_texture);
+}
+
+float ColorLut::process(const ColorLutParams& params, const CubeLut* cubeLut, glm::vec3& color)
+{
+    // Chroma key (from https://www.shadertoy.com/view/MlVXWD), distance of the U and V
+    // components of RGBtoYUV in plane_with_effects.frag
+    auto chroma = [](const glm::vec3& c, float& u, float& v) {
+        u = 0.439f * c.x - 0.368f * c.y - 0.071f * c.z + 0.5f;
+        v = -0.148f * c.x - 0.291f * c.y + 0.439f * c.z + 0.5f;
+    };
+    float u, v, keyU, keyV;
+    chroma(color, u, v);
+    chroma(params.chromaKeyColor, keyU, keyV);
+    float distance = std::sqrt((keyU - u) * (keyU - u) + (keyV - v) * (keyV - v));
+    float close = 1.0f;
+    if (distance < params.chromaKeyRangeLow) close = 0.0f;
+    else if (distance < params.chromaKeyRangeHigh) close = (distance - params.chromaKeyRangeLow) / (params.chromaKeyRangeHigh - params.chromaKeyRangeLow);
+    float mask = 1.0f - close;
+
+    for (int c = 0; c < 3; ++c) {
+        if (params.isChromaKeyEnabled) color[c] = std::max(color[c] - mask * params.chromaKeyColor[c], 0.0f);
+    }
+
+    // Color correction: saturation, contrast, brightness
+    // https://www.w3.org/TR/WCAG21/#dfn-relative-luminance
+    float grayscale = 0.2126f * color.x + 0.7152f * color.y + 0.0722f * color.z;
+    for (int c = 0; c < 3; ++c) {
+        float value = grayscale + (color[c] - grayscale) * (1.0f + params.saturation);
+        value = 0.5f + (1.0f + params.contrast) * (value - 0.5f);
+        color[c] = value + params.brightness;
+    }
+
+    if (cubeLut) color = cubeLut->sample(color);
+    return mask;
+}
+
+void ColorLut::update(const ColorLutParams& params)
+{
+    if (m_isBaked && params == m_params) return;
+
+    if (params.cubeFilename != m_cubeFilename) {
+        m_cubeFilename = params.cubeFilename;
+        m_cubeLut = CubeLut();
+        if (!m_cubeFilename.empty() && !loadCubeFile(m_cubeFilename, m_cubeLut)) m_cubeLut = CubeLut();
+    }
+
+    Uint64 startTime = SDL_GetTicksNS();
+    bake(params);
+    m_params = params;
+    m_isBaked = true;
+    m_stats.bakes++;
+    m_stats.lastBakeMs = double(SDL_GetTicksNS() - startTime) / 1000000.0;
+}
+
+void ColorLut::bake(const ColorLutParams& params)
+{
+    const CubeLut* cubeLut = (m_cubeLut.size > 0) ? &m_cubeLut : nullptr;
+    const float scale = 1.0f / float(SIZE - 1);
+    m_data.resize(size_t(SIZE) * SIZE * SIZE * 4);
+    float* data = m_data.data();
+    for (int b = 0; b < SIZE; ++b) {
+        for (int g = 0; g < SIZE; ++g) {
+            for (int r = 0; r < SIZE; ++r) {
+                glm::vec3 color(float(r) * scale, float(g) * scale, float(b) * scale);
+                float mask = process(params, cubeLut, color);
+                *data++ = color.x;
+                *data++ = color.y;
+                *data++ = color.z;
+                *data++ = mask;
+            }
+        }
+    }
+
+    // Half floats keep values outside of [0, 1] for the blend modes
+    bool isNew = (m_texture == 0);
+    if (isNew) glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_3D, m_texture);
+    if (isNew) {
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, SIZE, SIZE, SIZE, 0, GL_RGBA, GL_FLOAT, m_data.data());
+    }
+    else {
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, SIZE, SIZE, SIZE, GL_RGBA, GL_FLOAT, m_data.data());
+    }
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
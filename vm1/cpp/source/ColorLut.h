@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include "ShaderConfig.h"
+
+#include <GLES3/gl3.h>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Parameters baked into a plane's color LUT
+struct ColorLutParams {
+    float brightness = 0.0f;
+    float contrast = 0.0f;
+    float saturation = 0.0f;
+    bool isChromaKeyEnabled = false;
+    float chromaKeyRangeLow = 0.005f;
+    float chromaKeyRangeHigh = 0.26f;
+    glm::vec3 chromaKeyColor = glm::vec3(0.0f);
+    std::string cubeFilename;       // applied after the color correction, empty for none
+
+    // Color correction and chroma key values of a plane shader config
+    static ColorLutParams fromShaderConfig(const ShaderConfig& shaderConfig, const std::string& cubeFilename);
+    bool operator==(const ColorLutParams& other) const;
+};
+
+// 3D table of a .cube file, red changes fastest
+struct CubeLut {
+    int size = 0;
+    glm::vec3 domainMin = glm::vec3(0.0f);
+    glm::vec3 domainMax = glm::vec3(1.0f);
+    std::vector<glm::vec3> values;
+
+    // Trilinear lookup, the color is clamped to the domain
+    glm::vec3 sample(const glm::vec3& color) const;
+};
+
+bool loadCubeFile(const std::string& filename, CubeLut& cubeLut);
+
+struct ColorLutStats {
+    uint64_t bakes = 0;
+    double lastBakeMs = 0.0;
+};
+
+// The per-pixel color processing of a plane (chroma key, color correction and an
+// optional .cube file) baked into one SIZE^3 RGBA16F 3D texture, so the plane
+// shader needs a single texture fetch. RGB is the processed color, alpha the chroma
+// key mask (also needed for the alpha and the multiply blend mode).
+// The chroma key is evaluated on the opaque color, only the alpha keying itself
+// still depends on the source alpha.
+class ColorLut
+{
+public:
+    static constexpr int SIZE = 33;
+
+    ColorLut() = default;
+    ~ColorLut();
+
+    ColorLut(const ColorLut&) = delete;
+    ColorLut& operator=(const ColorLut&) = delete;
+
+public:
+    // Bakes and uploads the table when the parameters changed
+    void update(const ColorLutParams& params);
+    GLuint texture() const { return m_texture; }
+    const ColorLutStats& stats() const { return m_stats; }
+
+    // Processes one color the way the old per-pixel shader code did, returns the chroma key mask
+    static float process(const ColorLutParams& params, const CubeLut* cubeLut, glm::vec3& color);
+
+private:
+    void bake(const ColorLutParams& params);
+
+private:
+    GLuint m_texture = 0;
+    ColorLutParams m_params;
+    bool m_isBaked = false;
+    std::string m_cubeFilename;     // file m_cubeLut was loaded from
+    CubeLut m_cubeLut;
+    std::vector<float> m_data;
+    ColorLutStats m_stats;
+};
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "DemuxThread.h"
+
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+DemuxThread::~DemuxThread()
+{
+    stop();
+}
+
+void DemuxThread::start(AVFormatContext* formatContext)
+{
+    stop();
+
+    m_formatContext = formatContext;
+    m_isStopping = false;
+    m_isEndOfFile = false;
+    m_isRefilling = true;
+    m_stats.packets = 0;
+    m_stats.queuedBytes = 0;
+    m_stats.underruns = 0;
+    m_stats.slowestReadMs = 0.0;
+    m_stats.longestWaitMs = 0.0;
+    m_thread = std::thread(&DemuxThread::run, this);
+}
+
+void DemuxThread::stop()
+{
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    clearQueue();
+    for (AVPacket* packet : m_freePackets) {
+        av_packet_free(&packet);
+    }
+    m_freePackets.clear();
+    m_formatContext = nullptr;
+}
+
+void DemuxThread::clearQueue()
+{
+    for (AVPacket* packet : m_queue) {
+        av_packet_unref(packet);
+        m_freePackets.push_back(packet);
+    }
+    m_queue.clear();
+    m_queuedBytes = 0;
+    m_stats.queuedBytes = 0;
+}
+
+void DemuxThread::run()
+{
+    AVPacket* packet = av_packet_alloc();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_isStopping) {
+        if (m_seek) {
+            clearQueue();
+            lock.unlock();
+            int result = (*m_seek)(m_formatContext);
+            lock.lock();
+
+            m_seekResult = result;
+            m_seek = nullptr;
+            m_isSeekDone = true;
+            m_isEndOfFile = false;
+            m_isRefilling = true;
+            m_condition.notify_all();
+            continue;
+        }
+
+        bool isFull = m_queue.size() >= MAX_QUEUED_PACKETS || m_queuedBytes >= MAX_QUEUED_BYTES;
+        if (isFull || m_isEndOfFile) {
+            m_condition.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        auto start = Clock::now();
+        int result = av_read_frame(m_formatContext, packet);
+        double readMs = millisecondsSince(start);
+        if (readMs > m_stats.slowestReadMs) m_stats.slowestReadMs = readMs;
+        lock.lock();
+
+        // Read from before a seek that came in meanwhile
+        if (m_seek) {
+            if (result >= 0) av_packet_unref(packet);
+            continue;
+        }
+        if (result == AVERROR(EAGAIN)) {
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            lock.lock();
+            continue;
+        }
+        if (result < 0) {
+            m_isEndOfFile = true;
+            m_condition.notify_all();
+            continue;
+        }
+
+        AVPacket* queuedPacket = nullptr;
+        if (!m_freePackets.empty()) {
+            queuedPacket = m_freePackets.back();
+            m_freePackets.pop_back();
+        }
+        else {
+            queuedPacket = av_packet_alloc();
+        }
+        av_packet_move_ref(queuedPacket, packet);
+        m_queuedBytes += size_t(queuedPacket->size);
+        m_queue.push_back(queuedPacket);
+        m_stats.packets++;
+        m_stats.queuedBytes = m_queuedBytes;
+        m_condition.notify_all();
+    }
+    av_packet_free(&packet);
+}
+
+int DemuxThread::readPacket(AVPacket* packet, const std::atomic<bool>& isRunning)
+{
+    if (!m_thread.joinable()) return av_read_frame(m_formatContext, packet);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    bool hasWaited = false;
+    auto waitStart = Clock::now();
+    while (m_queue.empty()) {
+        if (m_isEndOfFile) return AVERROR_EOF;
+        if (!isRunning || m_isStopping) return AVERROR_EXIT;
+        if (!hasWaited) {
+            hasWaited = true;
+            waitStart = Clock::now();
+            if (!m_isRefilling) m_stats.underruns++;
+        }
+        // Polls isRunning, nobody notifies when it turns false
+        m_condition.wait_for(lock, std::chrono::milliseconds(5));
+    }
+    if (hasWaited && !m_isRefilling) {
+        double waitMs = millisecondsSince(waitStart);
+        if (waitMs > m_stats.longestWaitMs) m_stats.longestWaitMs = waitMs;
+    }
+    m_isRefilling = false;
+
+    AVPacket* queuedPacket = m_queue.front();
+    m_queue.pop_front();
+    m_queuedBytes -= size_t(queuedPacket->size);
+    m_stats.queuedBytes = m_queuedBytes;
+    av_packet_move_ref(packet, queuedPacket);
+    m_freePackets.push_back(queuedPacket);
+    m_condition.notify_all();
+    return 0;
+}
+
+int DemuxThread::seek(const std::function<int(AVFormatContext*)>& seek)
+{
+    if (!m_thread.joinable()) return seek(m_formatContext);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_seek = &seek;
+    m_isSeekDone = false;
+    m_condition.notify_all();
+    // The demux thread finishes its current read first
+    m_condition.wait(lock, [this]() { return m_isSeekDone; });
+    return m_seekResult;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+struct DemuxStats {
+    std::atomic<uint64_t> packets = 0;
+    std::atomic<size_t> queuedBytes = 0;
+    std::atomic<uint64_t> underruns = 0;        // the decoder found the queue empty
+    std::atomic<double> slowestReadMs = 0.0;    // av_read_frame() on the demux thread
+    std::atomic<double> longestWaitMs = 0.0;    // the decoder waited for a packet
+};
+
+// Reads the packets of a format context on its own thread into a bounded queue,
+// so a stall of the storage only stalls decoding once the queue ran dry. While it
+// runs, only the demux thread touches the format context: seeks are handed over
+// with seek() and block the caller until they are done.
+class DemuxThread
+{
+public:
+    static constexpr size_t MAX_QUEUED_PACKETS = 1024;
+    static constexpr size_t MAX_QUEUED_BYTES = 8 * 1024 * 1024;
+
+    DemuxThread() = default;
+    ~DemuxThread();
+
+    DemuxThread(const DemuxThread&) = delete;
+    DemuxThread& operator=(const DemuxThread&) = delete;
+
+public:
+    void start(AVFormatContext* formatContext);
+    void stop();
+    bool isStarted() const { return m_thread.joinable(); }
+
+    // Consumer side. Moves the next packet into packet and returns 0, AVERROR_EOF
+    // at the end of the file or AVERROR_EXIT once isRunning turned false.
+    int readPacket(AVPacket* packet, const std::atomic<bool>& isRunning);
+    // Runs seek on the demux thread and drops the queued packets, returns its result
+    int seek(const std::function<int(AVFormatContext*)>& seek);
+
+    const DemuxStats& stats() const { return m_stats; }
+
+private:
+    void run();
+    void clearQueue();
+
+private:
+    AVFormatContext* m_formatContext = nullptr;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_isStopping = false;
+    bool m_isEndOfFile = false;
+    bool m_isRefilling = false;     // started or seeked, the first wait is no underrun
+    std::deque<AVPacket*> m_queue;
+    std::vector<AVPacket*> m_freePackets;
+    size_t m_queuedBytes = 0;
+
+    // Pending seek, owned by the caller of seek() while it waits
+    const std::function<int(AVFormatContext*)>* m_seek = nullptr;
+    int m_seekResult = 0;
+    bool m_isSeekDone = false;
+
+    DemuxStats m_stats;
+};
@@ -90,6 +90,7 @@ void DirectoryCache::startAsyncLoad(const std::string& path, std::shared_ptr<Dir
             for (auto &it : fs::directory_iterator(p)) {
                 std::string fileName = it.path().filename().string();
                 if (fileName.ends_with(".preview")) continue;
+                if (fileName.ends_with(".keyframes") || fileName.ends_with(".keyframes.tmp")) continue;
                 DirectoryEntry entry;
                 entry.name = fileName;
                 entry.absolutePath = it.path().string();
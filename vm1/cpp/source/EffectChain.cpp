@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "EffectChain.h"
+#include "StringHelper.h"
+
+#include <SDL3/SDL.h>
+
+#include <map>
+#include <set>
+#include <string_view>
+#include <unordered_set>
+
+namespace {
+
+struct Token {
+    enum Type {
+        Space,
+        Comment,
+        Identifier,
+        Number,
+        Symbol
+    };
+
+    Type type = Symbol;
+    std::string_view text;
+    bool isDirective = false;       // part of a preprocessor line
+};
+
+// Builtin names a declaration may end on, they are never renamed
+const std::unordered_set<std::string_view> s_keywords = {
+    "void", "bool", "int", "uint", "float", "double",
+    "vec2", "vec3", "vec4", "ivec2", "ivec3", "ivec4", "uvec2", "uvec3", "uvec4", "bvec2", "bvec3", "bvec4",
+    "mat2", "mat3", "mat4", "mat2x2", "mat2x3", "mat2x4", "mat3x2", "mat3x3", "mat3x4", "mat4x2", "mat4x3", "mat4x4",
+    "sampler2D", "sampler3D", "samplerCube", "sampler2DArray", "isampler2D", "usampler2D", "samplerExternalOES",
+    "in", "out", "inout", "uniform", "buffer", "shared", "const", "highp", "mediump", "lowp", "precision",
+    "struct", "layout", "flat", "smooth", "centroid", "invariant", "return", "if", "else", "for", "while", "do",
+    "break", "continue", "discard", "true", "false", "main"
+};
+
+// Keywords in front of the type of a declaration
+const std::unordered_set<std::string_view> s_qualifiers = {
+    "in", "out", "inout", "uniform", "buffer", "shared", "const", "highp", "mediump", "lowp", "precision",
+    "layout", "flat", "smooth", "centroid", "invariant"
+};
+
+bool isIdentifierStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool isIdentifierChar(char c)
+{
+    return isIdentifierStart(c) || (c >= '0' && c <= '9');
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+std::vector<Token> tokenize(std::string_view source)
+{
+    std::vector<Token> tokens;
+    bool isLineStart = true;
+    bool isDirective = false;
+    size_t i = 0;
+    while (i < source.size()) {
+        size_t begin = i;
+        char c = source[i];
+        Token::Type type = Token::Symbol;
+
+        if (c == '\n') {
+            tokens.push_back({Token::Space, source.substr(i, 1), isDirective});
+            // A trailing backslash continues the directive
+            if (i == 0 || source[i - 1] != '\\') isDirective = false;
+            isLineStart = true;
+            ++i;
+            continue;
+        }
+        else if (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+            while (i < source.size() && (source[i] == ' ' || source[i] == '\t' || source[i] == '\r' || source[i] == '\v' || source[i] == '\f')) ++i;
+            tokens.push_back({Token::Space, source.substr(begin, i - begin), isDirective});
+            continue;
+        }
+        else if (c == '/' && i + 1 < source.size() && source[i + 1] == '/') {
+            while (i < source.size() && source[i] != '\n') ++i;
+            type = Token::Comment;
+        }
+        else if (c == '/' && i + 1 < source.size() && source[i + 1] == '*') {
+            size_t end = source.find("*/", i + 2);
+            i = (end == std::string_view::npos) ? source.size() : end + 2;
+            type = Token::Comment;
+        }
+        else if (isIdentifierStart(c)) {
+            while (i < source.size() && isIdentifierChar(source[i])) ++i;
+            type = Token::Identifier;
+        }
+        else if (isDigit(c) || (c == '.' && i + 1 < source.size() && isDigit(source[i + 1]))) {
+            // Includes suffixes and exponents (1.0f, 2e-3, 0xFFu)
+            while (i < source.size() && (isIdentifierChar(source[i]) || source[i] == '.' ||
+                   ((source[i] == '+' || source[i] == '-') && (source[i - 1] == 'e' || source[i - 1] == 'E')))) ++i;
+            type = Token::Number;
+        }
+        else {
+            if (c == '#' && isLineStart) isDirective = true;
+            ++i;
+        }
+
+        tokens.push_back({type, source.substr(begin, i - begin), isDirective});
+        isLineStart = false;
+    }
+    return tokens;
+}
+
+// Declaration state of one statement (top level or inside a uniform block)
+struct Statement {
+    std::string_view lastIdentifier;
+    int parenDepth = 0;
+    bool isInitializer = false;
+    bool isUniform = false;
+    bool isStruct = false;
+    bool isPrecision = false;
+    bool isFunction = false;
+};
+
+class NameCollector {
+public:
+    std::set<std::string, std::less<>> collect(const std::vector<Token>& tokens)
+    {
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            const Token& token = tokens[i];
+            if (token.type == Token::Space || token.type == Token::Comment) continue;
+            if (token.isDirective) {
+                collectDefine(tokens, i);
+                continue;
+            }
+
+            if (m_braceDepth == 0) {
+                process(m_statement, token, true);
+            }
+            else if (m_braceDepth == 1 && m_block == Block::UniformBlock) {
+                process(m_member, token, false);
+            }
+            else {
+                trackBraces(token);
+            }
+        }
+        return m_names;
+    }
+
+private:
+    enum class Block {
+        None,
+        Function,
+        UniformBlock,
+        Other
+    };
+
+    void declare(Statement& statement)
+    {
+        std::string_view name = statement.lastIdentifier;
+        statement.lastIdentifier = {};
+        if (name.empty() || statement.isPrecision || s_keywords.contains(name)) return;
+        m_names.insert(std::string(name));
+    }
+
+    // "#define NAME ..." declares NAME
+    void collectDefine(const std::vector<Token>& tokens, size_t i)
+    {
+        if (tokens[i].text != "#") return;
+        std::vector<std::string_view> words;
+        for (size_t j = i + 1; j < tokens.size() && tokens[j].isDirective && words.size() < 2; ++j) {
+            if (tokens[j].type == Token::Identifier) words.push_back(tokens[j].text);
+            else if (tokens[j].type != Token::Space) break;
+        }
+        if (words.size() == 2 && words[0] == "define") m_names.insert(std::string(words[1]));
+    }
+
+    void trackBraces(const Token& token)
+    {
+        if (token.text == "{") {
+            m_braceDepth++;
+        }
+        else if (token.text == "}") {
+            m_braceDepth--;
+            if (m_braceDepth == 0) closeBlock();
+        }
+    }
+
+    void closeBlock()
+    {
+        // Functions end without a semicolon, blocks and structs may still name an instance
+        if (m_block == Block::Function) {
+            m_statement = Statement();
+        }
+        else {
+            m_statement.lastIdentifier = {};
+        }
+        m_member = Statement();
+        m_block = Block::None;
+    }
+
+    void process(Statement& statement, const Token& token, bool isTopLevel)
+    {
+        bool isOuter = statement.parenDepth == 0;
+        if (token.type == Token::Identifier) {
+            if (!isOuter || statement.isInitializer) return;
+            if (token.text == "uniform") statement.isUniform = true;
+            else if (token.text == "struct") statement.isStruct = true;
+            else if (token.text == "precision") statement.isPrecision = true;
+            statement.lastIdentifier = token.text;
+            return;
+        }
+        if (token.type != Token::Symbol) return;
+
+        char c = token.text[0];
+        if (c == '(' || c == '[') {
+            if (isOuter && !statement.isInitializer && statement.lastIdentifier != "layout") {
+                if (c == '(') statement.isFunction = true;
+                declare(statement);
+            }
+            statement.parenDepth++;
+        }
+        else if (c == ')' || c == ']') {
+            if (statement.parenDepth > 0) statement.parenDepth--;
+        }
+        else if (!isOuter) {
+            return;
+        }
+        else if (c == '=') {
+            if (!statement.isInitializer) declare(statement);
+            statement.isInitializer = true;
+        }
+        else if (c == ',') {
+            if (!statement.isInitializer) declare(statement);
+            statement.isInitializer = false;
+            statement.lastIdentifier = {};
+        }
+        else if (c == ';') {
+            if (!statement.isInitializer) declare(statement);
+            statement = Statement();
+        }
+        else if (c == '{' && isTopLevel) {
+            if (statement.isFunction) {
+                m_block = Block::Function;
+            }
+            else if (statement.isUniform || statement.isStruct) {
+                // Members of structs are only used qualified, members of uniform blocks are globals
+                m_block = statement.isUniform ? Block::UniformBlock : Block::Other;
+                declare(statement);
+            }
+            else {
+                m_block = Block::Other;
+            }
+            m_braceDepth++;
+        }
+        else if (c == '}' && !isTopLevel) {
+            m_braceDepth--;
+            closeBlock();
+        }
+        else if (c == '{') {
+            m_braceDepth++;
+        }
+    }
+
+private:
+    std::set<std::string, std::less<>> m_names;
+    Statement m_statement;
+    Statement m_member;
+    Block m_block = Block::None;
+    int m_braceDepth = 0;
+};
+
+// Appends suffix to the value of "group" in an annotation comment
+std::string suffixAnnotationGroup(std::string_view comment, const std::string& suffix)
+{
+    std::string result(comment);
+    size_t key = result.find("\"group\"");
+    if (key == std::string::npos) return result;
+
+    size_t i = key + 7;
+    while (i < result.size() && (result[i] == ' ' || result[i] == '\t' || result[i] == ':')) ++i;
+    if (i >= result.size() || result[i] != '"') return result;
+    size_t end = result.find('"', i + 1);
+    if (end == std::string::npos) return result;
+
+    result.insert(end, suffix);
+    return result;
+}
+
+} // namespace
+
+std::string effectChainSignature(const std::vector<std::string>& filenames)
+{
+    std::string signature;
+    for (const std::string& filename : filenames) {
+        if (!signature.empty()) signature += " > ";
+        signature += filename;
+    }
+    return signature;
+}
+
+std::string namespaceEffectModule(const std::string& source, const std::string& prefix, const std::string& groupSuffix)
+{
+    std::vector<Token> tokens = tokenize(source);
+    std::set<std::string, std::less<>> names = NameCollector().collect(tokens);
+
+    std::string result;
+    result.reserve(source.size() + names.size() * prefix.size() * 4);
+    std::string_view previous;
+    int braceDepth = 0;
+    int bracketDepth = 0;
+    bool isStructHeader = false;
+    bool isInStruct = false;
+    bool hasMemberType = false;
+    for (const Token& token : tokens) {
+        bool isRenamed = token.type == Token::Identifier && names.contains(token.text) && previous != ".";
+
+        if (!token.isDirective && token.type == Token::Identifier) {
+            if (braceDepth == 0 && token.text == "struct") isStructHeader = true;
+            // Struct members are only used qualified, only their types are renamed
+            if (isInStruct && bracketDepth == 0 && !s_qualifiers.contains(token.text)) {
+                if (hasMemberType) isRenamed = false;
+                hasMemberType = true;
+            }
+        }
+        else if (!token.isDirective && token.type == Token::Symbol) {
+            char c = token.text[0];
+            if (c == '{') {
+                if (braceDepth == 0 && isStructHeader) {
+                    isInStruct = true;
+                    hasMemberType = false;
+                }
+                isStructHeader = false;
+                braceDepth++;
+            }
+            else if (c == '}') {
+                if (braceDepth > 0) braceDepth--;
+                if (braceDepth == 0) isInStruct = false;
+            }
+            else if (c == '[') {
+                bracketDepth++;
+            }
+            else if (c == ']') {
+                if (bracketDepth > 0) bracketDepth--;
+            }
+            else if (c == ';') {
+                hasMemberType = false;
+                if (braceDepth == 0) isStructHeader = false;
+            }
+        }
+
+        if (isRenamed) {
+            result += prefix;
+            result += token.text;
+        }
+        else if (token.type == Token::Comment && !groupSuffix.empty()) {
+            result += suffixAnnotationGroup(token.text, groupSuffix);
+        }
+        else {
+            result += token.text;
+        }
+
+        if (token.type != Token::Space && token.type != Token::Comment) previous = token.text;
+    }
+    return result;
+}
+
+bool composeEffectChain(std::string& hostSource, const std::vector<EffectModule>& modules)
+{
+    if (modules.empty()) return true;
+
+    std::string definitions;
+    std::string calls;
+    std::map<std::string, int> occurrences;
+    for (size_t i = 0; i < modules.size(); ++i) {
+        const EffectModule& module = modules[i];
+        if (!NameCollector().collect(tokenize(module.source)).contains("extMain")) {
+            SDL_Log("Effect %s has no extMain()", module.filename.c_str());
+            return false;
+        }
+
+        if (modules.size() == 1) {
+            definitions = module.source;
+            calls = "extMain(color, coord);";
+            break;
+        }
+
+        std::string prefix = "fx" + std::to_string(i) + "_";
+        int occurrence = ++occurrences[module.filename];
+        std::string groupSuffix = (occurrence > 1) ? " " + std::to_string(occurrence) : "";
+        definitions += "// " + module.filename + "\n";
+        definitions += namespaceEffectModule(module.source, prefix, groupSuffix);
+        definitions += "\n\n";
+        calls += prefix + "extMain(color, coord);\n\t";
+    }
+
+    strhlpr::searchAndReplace(hostSource, "//###EXT_MAIN_DEF###", definitions);
+    strhlpr::searchAndReplace(hostSource, "//###EXT_MAIN_USE###", calls);
+    return true;
+}
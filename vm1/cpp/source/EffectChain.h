@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Effect modules of a plane are fused into the plane shader, so a chain of N effects
+// is still drawn in one pass. Every module defines extMain(inout vec4 color, in vec2 coord)
+// and the fused shader calls them in chain order on the same color.
+// Modules that resample the plane via colorAtUV() read the plane's source, not the
+// output of the modules before them.
+static constexpr size_t MAX_EFFECT_MODULES = 4;
+
+struct EffectModule {
+    std::string filename;
+    std::string source;
+};
+
+// Identifies a chain by its module files and their order
+std::string effectChainSignature(const std::vector<std::string>& filenames);
+
+// Prefixes every global name a module declares (uniforms, uniform blocks and their members,
+// functions, constants, structs and macros) so modules can be combined with each other.
+// Annotation comments are kept, groupSuffix is appended to their "group" to tell repeated
+// modules apart.
+std::string namespaceEffectModule(const std::string& source, const std::string& prefix, const std::string& groupSuffix = "");
+
+// Splices the modules into the //###EXT_MAIN_DEF### and //###EXT_MAIN_USE### markers of the
+// plane shader. A single module is spliced unchanged, so its uniform names stay the same.
+// Returns false when a module has no extMain().
+bool composeEffectChain(std::string& hostSource, const std::vector<EffectModule>& modules);
@@ -50,7 +50,8 @@ struct PlaybackEvent {
         NoDisplay,
         NoMedia,
         FileNotSupported,
-        InputNotReady
+        InputNotReady,
+        ShaderCompileFailed
     };
 
     PlaybackEvent() = delete;
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Bounded single-producer/single-consumer ring used for the decoder -> render handoff.
+// Frames live in preallocated slots and are moved in and out, never copied.
+// Only the producer ever blocks and only while the ring is full. The consumer
+// never blocks: peekFrame() gives access to the front slot in place and
+// popFrame() moves it out.
+template<typename T, size_t Capacity = 3>
+class FrameRing
+{
+public:
+    FrameRing() = default;
+    ~FrameRing() = default;
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+public:
+    void setActive(bool active) {
+        m_isActive = active;
+        // Wake up a producer waiting for a free slot
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_all();
+    }
+
+    // Must only be called while no producer is running (e.g. after joining the decoder thread)
+    void clearFrames() {
+        size_t writeIndex = m_writeIndex.load(std::memory_order_acquire);
+        size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+        while (readIndex != writeIndex) {
+            m_slots[readIndex % Capacity] = T();
+            ++readIndex;
+        }
+        m_readIndex.store(readIndex, std::memory_order_release);
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_all();
+    }
+
+    // Producer side. Blocks while the ring is full and the ring is active.
+    // Returns false when the frame was dropped because the ring got deactivated.
+    bool pushFrame(T&& frame) {
+        size_t writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t signal = m_signal.load(std::memory_order_acquire);
+            size_t readIndex = m_readIndex.load(std::memory_order_acquire);
+            if (writeIndex - readIndex < Capacity) break;
+            if (!m_isActive) return false;
+            m_signal.wait(signal, std::memory_order_acquire);
+        }
+        if (!m_isActive) return false;
+
+        m_slots[writeIndex % Capacity] = std::move(frame);
+        m_writeIndex.store(writeIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pushFrame(T& frame) {
+        return pushFrame(std::move(frame));
+    }
+
+    // Consumer side. Moves the front frame out of its slot.
+    bool popFrame(T& frame) {
+        size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+        if (readIndex == m_writeIndex.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        frame = std::move(m_slots[readIndex % Capacity]);
+        m_readIndex.store(readIndex + 1, std::memory_order_release);
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_one();
+        return true;
+    }
+
+    // Consumer side. Returns the front frame in place or nullptr when empty.
+    // The pointer stays valid until the next popFrame()/clearFrames().
+    const T* peekFrame() const {
+        size_t readIndex = m_readIndex.load(std::memory_order_relaxed);
+        if (readIndex == m_writeIndex.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_slots[readIndex % Capacity];
+    }
+
+    bool isFrameReady() const {
+        return m_readIndex.load(std::memory_order_acquire) != m_writeIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<bool> m_isActive = true;
+    std::array<T, Capacity> m_slots;
+
+    // Monotonic counters, slot = index % Capacity. Kept on separate cache lines
+    // since one is written by the producer and the other by the consumer.
+    alignas(64) std::atomic<size_t> m_writeIndex = 0;
+    alignas(64) std::atomic<size_t> m_readIndex = 0;
+
+    // Bumped on every pop and on deactivation, the producer sleeps on it while the ring is full
+    std::atomic<uint32_t> m_signal = 0;
+};
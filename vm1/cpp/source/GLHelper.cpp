@@ -11,6 +11,8 @@
 bool GLHelper::has_EGL_EXT_image_dma_buf_import = false;
 PFNGLACTIVETEXTUREARBPROC GLHelper::glActiveTextureARBFunc = nullptr;
 PFNGLEGLIMAGETARGETTEXTURE2DOESPROC GLHelper::glEGLImageTargetTexture2DOESFunc = nullptr;
+bool GLHelper::has_GL_EXT_disjoint_timer_query = false;
+PFNGLGETQUERYOBJECTUI64VEXTPROC GLHelper::glGetQueryObjectui64vEXTFunc = nullptr;
 
 bool GLHelper::init()
 {
@@ -25,6 +27,12 @@ bool GLHelper::init()
 
     glActiveTextureARBFunc = (PFNGLACTIVETEXTUREARBPROC)SDL_GL_GetProcAddress("glActiveTextureARB");
 
+    // Optional, only used for the GPU timings in the development UI
+    if (SDL_GL_ExtensionSupported("GL_EXT_disjoint_timer_query")) {
+        glGetQueryObjectui64vEXTFunc = (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress("glGetQueryObjectui64vEXT");
+        has_GL_EXT_disjoint_timer_query = (glGetQueryObjectui64vEXTFunc != nullptr);
+    }
+
     if (!glEGLImageTargetTexture2DOESFunc || !glActiveTextureARBFunc) {
         return false;
     }
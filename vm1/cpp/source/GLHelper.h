@@ -22,4 +22,6 @@ public:
     static bool has_EGL_EXT_image_dma_buf_import;
     static PFNGLACTIVETEXTUREARBPROC glActiveTextureARBFunc;
     static PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOESFunc;
+    static bool has_GL_EXT_disjoint_timer_query;
+    static PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXTFunc;
 };
\ No newline at end of file
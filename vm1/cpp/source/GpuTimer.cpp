@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "GpuTimer.h"
+#include "GLHelper.h"
+
+GpuTimer::~GpuTimer()
+{
+    if (m_isInitialized) {
+        glDeleteQueries(QUERY_COUNT, m_queries.data());
+    }
+}
+
+bool GpuTimer::usesTimerQuery() const
+{
+    return GLHelper::has_GL_EXT_disjoint_timer_query;
+}
+
+void GpuTimer::begin()
+{
+    if (m_isRunning) return;
+
+    if (!usesTimerQuery()) {
+        glFinish();
+        m_startTicks = SDL_GetTicksNS();
+        m_isRunning = true;
+        return;
+    }
+
+    if (!m_isInitialized) {
+        glGenQueries(QUERY_COUNT, m_queries.data());
+        m_isInitialized = true;
+    }
+
+    collectResults();
+
+    // All queries still in flight, skip this measurement
+    if (m_isPending[m_nextQuery]) return;
+
+    glBeginQuery(GL_TIME_ELAPSED_EXT, m_queries[m_nextQuery]);
+    m_isRunning = true;
+}
+
+void GpuTimer::end()
+{
+    if (!m_isRunning) return;
+    m_isRunning = false;
+
+    if (!usesTimerQuery()) {
+        glFinish();
+        addSample(double(SDL_GetTicksNS() - m_startTicks) / 1000000.0);
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    m_isPending[m_nextQuery] = true;
+    m_nextQuery = (m_nextQuery + 1) % QUERY_COUNT;
+}
+
+void GpuTimer::reset()
+{
+    m_averageMs = 0.0;
+    m_samples = 0;
+}
+
+void GpuTimer::collectResults()
+{
+    // Results of a disjoint period (e.g. frequency change) are meaningless
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    for (int i = 0; i < QUERY_COUNT; ++i) {
+        if (!m_isPending[i]) continue;
+
+        GLuint available = 0;
+        glGetQueryObjectuiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 elapsed = 0;
+        GLHelper::glGetQueryObjectui64vEXTFunc(m_queries[i], GL_QUERY_RESULT, &elapsed);
+        m_isPending[i] = false;
+        if (!disjoint) addSample(double(elapsed) / 1000000.0);
+    }
+}
+
+void GpuTimer::addSample(double ms)
+{
+    // Exponential moving average, the first sample initializes it
+    m_averageMs = (m_samples == 0) ? ms : (m_averageMs * 0.95 + ms * 0.05);
+    m_samples++;
+}
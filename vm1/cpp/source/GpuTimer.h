@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <array>
+#include <cstdint>
+
+// Measures the GPU time of a block of GL commands.
+// Uses GL_EXT_disjoint_timer_query when available and reads the results a few
+// frames later so the pipeline never stalls. Without the extension it falls back
+// to glFinish() around the block, which does stall, so only enable it while
+// actually looking at the numbers.
+class GpuTimer
+{
+public:
+    GpuTimer() = default;
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+public:
+    void begin();
+    void end();
+    void reset();
+
+    // Smoothed duration in milliseconds, 0.0 until the first result arrived
+    double averageMs() const { return m_averageMs; }
+    uint64_t samples() const { return m_samples; }
+    bool usesTimerQuery() const;
+
+private:
+    void collectResults();
+    void addSample(double ms);
+
+private:
+    static constexpr int QUERY_COUNT = 4;
+    std::array<GLuint, QUERY_COUNT> m_queries = {};
+    std::array<bool, QUERY_COUNT> m_isPending = {};
+    bool m_isInitialized = false;
+    bool m_isRunning = false;
+    int m_nextQuery = 0;
+    uint64_t m_startTicks = 0;
+
+    double m_averageMs = 0.0;
+    uint64_t m_samples = 0;
+};
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "KeyframeIndex.h"
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+struct KeyframeIndex::Header {
+    char magic[4] = { 'V', 'M', '1', 'K' };
+    uint32_t version = 1;
+    int32_t streamIndex = -1;
+    int32_t reserved = 0;
+    int64_t frameDuration = 0;
+    uint64_t fileSize = 0;
+    int64_t modificationTime = 0;
+    uint64_t entryCount = 0;
+};
+
+bool KeyframeIndex::readFileStamp(const std::string& videoFile, uint64_t& size, int64_t& modificationTime)
+{
+    std::error_code error;
+    size = fs::file_size(videoFile, error);
+    if (error) return false;
+    auto writeTime = fs::last_write_time(videoFile, error);
+    if (error) return false;
+    modificationTime = int64_t(writeTime.time_since_epoch().count());
+    return true;
+}
+
+bool KeyframeIndex::isSidecarCurrent(const std::string& videoFile)
+{
+    uint64_t size = 0;
+    int64_t modificationTime = 0;
+    if (!readFileStamp(videoFile, size, modificationTime)) return false;
+
+    std::ifstream file(sidecarPath(videoFile), std::ios::binary);
+    Header header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    return std::memcmp(header.magic, Header().magic, sizeof(header.magic)) == 0 &&
+           header.version == Header().version &&
+           header.fileSize == size &&
+           header.modificationTime == modificationTime;
+}
+
+void KeyframeIndex::clear()
+{
+    m_streamIndex = -1;
+    m_frameDuration = 0;
+    m_fileSize = 0;
+    m_modificationTime = 0;
+    m_entries.clear();
+}
+
+bool KeyframeIndex::build(const std::string& videoFile)
+{
+    clear();
+    if (!readFileStamp(videoFile, m_fileSize, m_modificationTime)) return false;
+
+    AVFormatContext* formatContext = nullptr;
+    if (avformat_open_input(&formatContext, videoFile.c_str(), nullptr, nullptr) < 0) return false;
+    if (avformat_find_stream_info(formatContext, nullptr) < 0) {
+        avformat_close_input(&formatContext);
+        return false;
+    }
+
+    m_streamIndex = av_find_best_stream(formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (m_streamIndex < 0) {
+        avformat_close_input(&formatContext);
+        clear();
+        return false;
+    }
+
+    AVStream* stream = formatContext->streams[m_streamIndex];
+    if (stream->avg_frame_rate.num > 0 && stream->avg_frame_rate.den > 0) {
+        m_frameDuration = av_rescale_q(1, av_inv_q(stream->avg_frame_rate), stream->time_base);
+    }
+
+    // Demux only, the packets of the other streams are skipped
+    AVPacket* packet = av_packet_alloc();
+    while (av_read_frame(formatContext, packet) >= 0) {
+        if (packet->stream_index == m_streamIndex && (packet->flags & AV_PKT_FLAG_KEY)) {
+            int64_t pts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+            if (pts != AV_NOPTS_VALUE) {
+                m_entries.push_back({ pts, packet->pos });
+            }
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&formatContext);
+
+    std::sort(m_entries.begin(), m_entries.end(), [](const KeyframeEntry& a, const KeyframeEntry& b) {
+        return a.pts < b.pts;
+    });
+    return isValid();
+}
+
+bool KeyframeIndex::load(const std::string& videoFile)
+{
+    clear();
+
+    uint64_t size = 0;
+    int64_t modificationTime = 0;
+    if (!readFileStamp(videoFile, size, modificationTime)) return false;
+
+    std::ifstream file(sidecarPath(videoFile), std::ios::binary);
+    Header header;
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, Header().magic, sizeof(header.magic)) != 0 || header.version != Header().version) return false;
+    if (header.fileSize != size || header.modificationTime != modificationTime) return false;
+
+    // Sanity limit, a keyframe per frame of a few hours of 60 fps
+    if (header.entryCount == 0 || header.entryCount > 1000000) return false;
+
+    m_entries.resize(header.entryCount);
+    if (!file.read(reinterpret_cast<char*>(m_entries.data()), std::streamsize(m_entries.size() * sizeof(KeyframeEntry)))) {
+        clear();
+        return false;
+    }
+
+    m_streamIndex = header.streamIndex;
+    m_frameDuration = header.frameDuration;
+    m_fileSize = header.fileSize;
+    m_modificationTime = header.modificationTime;
+    return true;
+}
+
+bool KeyframeIndex::save(const std::string& videoFile) const
+{
+    if (!isValid()) return false;
+
+    Header header;
+    header.streamIndex = m_streamIndex;
+    header.frameDuration = m_frameDuration;
+    header.fileSize = m_fileSize;
+    header.modificationTime = m_modificationTime;
+    header.entryCount = m_entries.size();
+
+    // Written next to it and renamed, so a player never reads a partial sidecar
+    std::string path = sidecarPath(videoFile);
+    std::string temporaryPath = path + ".tmp";
+    bool isWritten = false;
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(m_entries.data()), std::streamsize(m_entries.size() * sizeof(KeyframeEntry)));
+        file.close();
+        isWritten = !file.fail();
+    }
+
+    std::error_code error;
+    if (isWritten) fs::rename(temporaryPath, path, error);
+    if (!isWritten || error) {
+        fs::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+const KeyframeEntry* KeyframeIndex::find(int64_t pts) const
+{
+    auto it = std::upper_bound(m_entries.begin(), m_entries.end(), pts, [](int64_t value, const KeyframeEntry& entry) {
+        return value < entry.pts;
+    });
+    if (it == m_entries.begin()) return nullptr;
+    return &*(it - 1);
+}
+
+int KeyframeIndex::framesToDiscard(const KeyframeEntry& keyframe, int64_t pts) const
+{
+    if (m_frameDuration <= 0 || pts <= keyframe.pts) return 0;
+    return int((pts - keyframe.pts + m_frameDuration - 1) / m_frameDuration);
+}
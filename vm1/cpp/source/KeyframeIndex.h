@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct KeyframeEntry {
+    int64_t pts = 0;        // in the stream's time base
+    int64_t position = -1;  // byte offset of the packet in the file, -1 if unknown
+};
+
+// Keyframes of the video stream of a clip, stored in a "<clip>.keyframes" sidecar
+// next to it (see MediaPool). Built by demuxing only, no frame gets decoded.
+// The sidecar remembers size and modification time of the clip and is ignored
+// once the clip changed.
+class KeyframeIndex
+{
+public:
+    static constexpr const char* SIDECAR_EXTENSION = ".keyframes";
+
+    static std::string sidecarPath(const std::string& videoFile) { return videoFile + SIDECAR_EXTENSION; }
+    // The sidecar exists and matches the clip
+    static bool isSidecarCurrent(const std::string& videoFile);
+    // Size and modification time, a sidecar belongs to the clip with the same ones
+    static bool readFileStamp(const std::string& videoFile, uint64_t& size, int64_t& modificationTime);
+
+    bool build(const std::string& videoFile);
+    bool load(const std::string& videoFile);
+    bool save(const std::string& videoFile) const;
+    void clear();
+
+    bool isValid() const { return !m_entries.empty(); }
+    int streamIndex() const { return m_streamIndex; }
+    size_t size() const { return m_entries.size(); }
+
+    // Last keyframe at or before pts, nullptr if pts is before the first one
+    const KeyframeEntry* find(int64_t pts) const;
+    // Frames between the keyframe and pts that are decoded and dropped
+    int framesToDiscard(const KeyframeEntry& keyframe, int64_t pts) const;
+
+private:
+    struct Header;
+
+private:
+    int m_streamIndex = -1;
+    int64_t m_frameDuration = 0;    // in the stream's time base, 0 if the frame rate is unknown
+    uint64_t m_fileSize = 0;
+    int64_t m_modificationTime = 0;
+    std::vector<KeyframeEntry> m_entries;
+};
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "LoopFrameCache.h"
+#include "ShaderLibrary.h"
+
+#include <SDL3/SDL.h>
+
+LoopCacheBudget& LoopCacheBudget::instance()
+{
+    static LoopCacheBudget s_instance;
+    return s_instance;
+}
+
+bool LoopCacheBudget::acquire(size_t bytes)
+{
+    if (m_usedBytes + bytes > m_limit) return false;
+    m_usedBytes += bytes;
+    return true;
+}
+
+void LoopCacheBudget::release(size_t bytes)
+{
+    m_usedBytes = (bytes < m_usedBytes) ? m_usedBytes - bytes : 0;
+}
+
+LoopFrameCache::LoopFrameCache()
+{
+    glGenFramebuffers(1, &m_frameBuffer);
+    m_copyShader = ShaderLibrary::instance().load("shaders/texture_copy.vert", "shaders/texture_copy.frag");
+}
+
+LoopFrameCache::~LoopFrameCache()
+{
+    clear();
+    if (m_frameBuffer) {
+        glDeleteFramebuffers(1, &m_frameBuffer);
+        m_frameBuffer = 0;
+    }
+}
+
+bool LoopFrameCache::begin(const LoopPlaneSize* planes, int planeCount, size_t maxFrames)
+{
+    clear();
+    if (planeCount < 1 || planeCount > LoopFrame::MAX_PLANES || maxFrames == 0) return false;
+    if (!m_copyShader || !m_copyShader->isLinked()) return false;
+
+    size_t frameBytes = 0;
+    for (int i = 0; i < planeCount; ++i) {
+        frameBytes += size_t(planes[i].width) * size_t(planes[i].height);
+    }
+    if (!LoopCacheBudget::instance().acquire(frameBytes * maxFrames)) return false;
+
+    for (int i = 0; i < planeCount; ++i) {
+        m_planes[i] = planes[i];
+    }
+    m_planeCount = planeCount;
+    m_maxFrames = maxFrames;
+    m_frameBytes = frameBytes;
+    m_reservedBytes = frameBytes * maxFrames;
+    m_frames.reserve(maxFrames);
+    m_state = State::Recording;
+    return true;
+}
+
+bool LoopFrameCache::record(const GLuint* planes, double pts, double absolutePts)
+{
+    if (m_state != State::Recording || m_frames.size() >= m_maxFrames) return false;
+
+    // Errors of earlier GL calls must not count as ours
+    while (glGetError() != GL_NO_ERROR) {}
+
+    LoopFrame frame;
+    frame.pts = pts;
+    frame.absolutePts = absolutePts;
+    glGenTextures(m_planeCount, frame.textures.data());
+    for (int i = 0; i < m_planeCount; ++i) {
+        glBindTexture(GL_TEXTURE_2D, frame.textures[i]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, m_planes[i].width, m_planes[i].height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // The budget is ours, but the GPU may still run out of memory first
+    if (glGetError() == GL_OUT_OF_MEMORY) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of GPU memory after %zu cached loop frames", m_frames.size());
+        glDeleteTextures(m_planeCount, frame.textures.data());
+        return false;
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    glBindVertexArray(0);
+    m_copyShader->activate();
+    m_copyShader->bindUniformLocation("inputTexture", 0);
+    for (int i = 0; i < m_planeCount; ++i) {
+        copyPlane(planes[i], frame.textures[i], m_planes[i]);
+    }
+    m_copyShader->deactivate();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    m_frames.push_back(frame);
+    return true;
+}
+
+void LoopFrameCache::copyPlane(GLuint source, GLuint target, const LoopPlaneSize& size)
+{
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+    glViewport(0, 0, size.width, size.height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void LoopFrameCache::finish(double passDuration)
+{
+    if (m_state != State::Recording || m_frames.empty()) {
+        clear();
+        return;
+    }
+    m_passDuration = passDuration;
+    m_state = State::Complete;
+}
+
+void LoopFrameCache::clear()
+{
+    for (auto& frame : m_frames) {
+        glDeleteTextures(m_planeCount, frame.textures.data());
+    }
+    m_frames.clear();
+    m_frames.shrink_to_fit();
+
+    LoopCacheBudget::instance().release(m_reservedBytes);
+    m_reservedBytes = 0;
+    m_frameBytes = 0;
+    m_maxFrames = 0;
+    m_planeCount = 0;
+    m_passDuration = 0.0;
+    m_state = State::Empty;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include "Shader.h"
+
+#include <GLES3/gl31.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bytes all loop caches may keep resident together (main thread only)
+class LoopCacheBudget
+{
+public:
+    static LoopCacheBudget& instance();
+
+    LoopCacheBudget(const LoopCacheBudget&) = delete;
+    LoopCacheBudget& operator=(const LoopCacheBudget&) = delete;
+
+public:
+    // Caches that are already resident keep their memory
+    void setLimit(size_t bytes) { m_limit = bytes; }
+    size_t limit() const { return m_limit; }
+    size_t usedBytes() const { return m_usedBytes; }
+
+    bool acquire(size_t bytes);
+    void release(size_t bytes);
+
+private:
+    LoopCacheBudget() = default;
+
+private:
+    size_t m_limit = 256 * 1024 * 1024;
+    size_t m_usedBytes = 0;
+};
+
+struct LoopPlaneSize {
+    int width = 0;
+    int height = 0;
+};
+
+// One decoded frame of the loop, a copy of each R8 plane of the source
+struct LoopFrame {
+    static constexpr int MAX_PLANES = 3;
+
+    std::array<GLuint, MAX_PLANES> textures = {};
+    double pts = 0.0;           // relative to the first frame of the loop
+    double absolutePts = 0.0;
+};
+
+// Decoded frames of a short loop region kept on the GPU, so the following passes
+// can be played without the decoder (see VideoPlayer). The frames keep the layout
+// of the source textures: one SAND128 view for the hardware route, three YUV 4:2:0
+// planes for the software route. The memory of the whole loop is reserved from
+// the LoopCacheBudget when recording begins.
+class LoopFrameCache
+{
+public:
+    enum class State {
+        Empty,
+        Recording,
+        Complete
+    };
+
+    LoopFrameCache();
+    ~LoopFrameCache();
+
+    LoopFrameCache(const LoopFrameCache&) = delete;
+    LoopFrameCache& operator=(const LoopFrameCache&) = delete;
+
+public:
+    // Reserves maxFrames frames of the given planes, false when they don't fit into the budget
+    bool begin(const LoopPlaneSize* planes, int planeCount, size_t maxFrames);
+    // Copies the planes into the next frame, false when the reserved frames are used up
+    bool record(const GLuint* planes, double pts, double absolutePts);
+    // passDuration is the time from the first frame to the first frame of the next pass
+    void finish(double passDuration);
+    void clear();
+
+    State state() const { return m_state; }
+    bool isRecording() const { return m_state == State::Recording; }
+    bool isComplete() const { return m_state == State::Complete; }
+    size_t frameCount() const { return m_frames.size(); }
+    size_t capacity() const { return m_maxFrames; }
+    const LoopFrame& frame(size_t index) const { return m_frames[index]; }
+    double passDuration() const { return m_passDuration; }
+    size_t reservedBytes() const { return m_reservedBytes; }
+    size_t residentBytes() const { return m_frames.size() * m_frameBytes; }
+
+private:
+    void copyPlane(GLuint source, GLuint target, const LoopPlaneSize& size);
+
+private:
+    State m_state = State::Empty;
+    std::array<LoopPlaneSize, LoopFrame::MAX_PLANES> m_planes = {};
+    int m_planeCount = 0;
+    size_t m_maxFrames = 0;
+    size_t m_frameBytes = 0;
+    size_t m_reservedBytes = 0;
+    double m_passDuration = 0.0;
+    std::vector<LoopFrame> m_frames;
+
+    GLuint m_frameBuffer = 0;
+    std::shared_ptr<Shader> m_copyShader;
+};
@@ -19,6 +19,7 @@ MediaPlayer::MediaPlayer()
 
 MediaPlayer::~MediaPlayer()
 {
+    releaseRenderTarget();
     if (m_vbo) {
         glDeleteBuffers(1, &m_vbo);
         m_vbo = 0;
@@ -44,7 +45,45 @@ bool MediaPlayer::isFrameReady() {
 
 GLuint MediaPlayer::texture()
 {
-    return m_rgbTexture;
+    return m_renderTarget ? m_renderTarget->texture : 0;
+}
+
+void MediaPlayer::setRenderTargetWanted(bool wanted)
+{
+    m_isRenderTargetWanted = wanted;
+    if (!wanted) releaseRenderTarget();
+}
+
+bool MediaPlayer::acquireRenderTarget(int width, int height)
+{
+    if (m_renderTarget) {
+        if (m_renderTarget->width == width && m_renderTarget->height == height) return true;
+        releaseRenderTarget();
+    }
+    if (!m_renderTargetPool || !m_isRenderTargetWanted) return false;
+
+    m_renderTarget = m_renderTargetPool->acquire(width, height);
+    m_isRgbOutputValid = false;
+    return m_renderTarget != nullptr;
+}
+
+void MediaPlayer::releaseRenderTarget()
+{
+    if (!m_renderTarget) return;
+
+    if (m_renderTargetPool) m_renderTargetPool->release(m_renderTarget);
+    m_renderTarget = nullptr;
+}
+
+bool MediaPlayer::isDirectOutput() const
+{
+    return !m_isRgbOutputRequired && nativeSource().type != DirectSourceType::None;
+}
+
+DirectSource MediaPlayer::directSource() const
+{
+    if (!isDirectOutput()) return DirectSource();
+    return nativeSource();
 }
 
 void MediaPlayer::close()
@@ -71,6 +110,8 @@ void MediaPlayer::close()
 
     m_videoQueue.clearFrames();
     m_audioQueue.clearFrames();
+    releaseRenderTarget();
+    m_isRgbOutputValid = false;
 }
 
 void MediaPlayer::reset()
@@ -111,35 +152,15 @@ void MediaPlayer::createVertexBuffers()
     glBindVertexArray(0);
 }
 
-void MediaPlayer::initializeFramebufferAndTextures()
+void MediaPlayer::initializeInputTextures()
 {
-    // Generate input buffer (SAND128 NV12 / YUV)
+    // Generate input buffer (SAND128 NV12 / YUV), the RGB output comes from the render target pool
     for (int i = 0; i < m_numberOfInputImages; ++i) {
         GLuint texId;
         glGenTextures(1, &texId);
         m_yuvTextures.push_back(texId);
         m_yuvImages.push_back(EGL_NO_IMAGE);
     }
-    
-    // Generate and bind the output framebuffer (RGB)
-    glGenFramebuffers(1, &m_frameBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
-
-    // Create output texture (RGB)
-    glGenTextures(1, &m_rgbTexture);
-    glBindTexture(GL_TEXTURE_2D, m_rgbTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); 
-    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, 1920, 1080);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_rgbTexture, 0);
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 // void MediaPlayer::setPlaneId(int planeId)
@@ -9,9 +9,11 @@
 #pragma once
 
 #include "Shader.h"
-#include "ThreadableQueue.h"
+#include "ShaderLibrary.h"
+#include "FrameRing.h"
 #include "AudioDevice.h"
 #include "Buffer.h"
+#include "RenderTargetPool.h"
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_render.h>
@@ -24,8 +26,32 @@
 #include <mutex>
 #include <atomic>
 #include <queue>
+#include <array>
+#include <type_traits>
 #include <condition_variable>
 
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+extern "C"
+{
+#include <libavutil/hwcontext_drm.h>
+}
+
+constexpr int VIDEO_FRAME_MAX_PLANES = AV_DRM_MAX_PLANES;
+
+// Description of one DRM PRIME plane of a decoded frame
+struct VideoPlane {
+    uint32_t format = 0;
+    int width = 0;
+    int height = 0;
+    int fd = -1;
+    uint32_t offset = 0;
+    uint32_t pitch = 0;
+    uint64_t bufferId = 0; // inode of the dma-buf, stays the same while the decoder recycles the buffer
+};
+
+// Trivially copyable, so passing frames from the decoder to the main thread never touches the heap
 struct VideoFrame {
     EGLImage image = EGL_NO_IMAGE;
 
@@ -34,13 +60,34 @@ struct VideoFrame {
     double absolutePts = 0.0; // absolute position in the video file, used for display
     int index = -1;
     Buffer* buffer = nullptr;
+    uint32_t framesContextId = 0; // changes whenever the decoder's hw_frames_ctx changes
     
-    std::vector<uint32_t> formats;
-    std::vector<int> widths;
-    std::vector<int> heights;
-    std::vector<int> fds;
-    std::vector<uint32_t> offsets;
-    std::vector<uint32_t> pitches;
+    int planeCount = 0;
+    std::array<VideoPlane, VIDEO_FRAME_MAX_PLANES> planes{};
+
+    bool addPlane(const VideoPlane& plane) {
+        if (planeCount >= VIDEO_FRAME_MAX_PLANES) return false;
+        planes[planeCount++] = plane;
+        return true;
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<VideoFrame>, "VideoFrame must stay trivially copyable");
+
+// Native image a plane can sample directly instead of the player's RGB framebuffer.
+// The values match the source types in plane_with_effects.frag.
+enum class DirectSourceType {
+    None = 0,
+    Sand128 = 1,
+    Uyvy = 2,
+    Yuyv = 3
+};
+
+struct DirectSource {
+    DirectSourceType type = DirectSourceType::None;
+    GLuint texture = 0;
+    glm::ivec4 layout = glm::ivec4(0);  // Sand128: viewWidth, columnHeight, lumaHeight, stripCount
+    glm::vec2 size = glm::vec2(0.0f);   // visible width and height in pixels
 };
 
 struct AudioFrame {
@@ -66,15 +113,33 @@ public:
     virtual void update() = 0;
     virtual bool isFrameReady();
     GLuint texture();
+
+    // Invisible players keep consuming their frames but skip all GPU work
+    void setVisible(bool visible) { m_isVisible = visible; }
+    bool isVisible() const { return m_isVisible; }
+
+    // Render targets are leased from the pool only while a plane mixer shows the player
+    void setRenderTargetPool(RenderTargetPool* renderTargetPool) { m_renderTargetPool = renderTargetPool; }
+    void setRenderTargetWanted(bool wanted);
+    void releaseRenderTarget();
+    bool hasRenderTarget() const { return m_renderTarget != nullptr; }
+
+    // Without a required RGB output, players that have a native source skip their framebuffer pass
+    void setRgbOutputRequired(bool required) { m_isRgbOutputRequired = required; }
+    bool isDirectOutput() const;
+    DirectSource directSource() const;
     //void setPlaneId(int planeId);
     //int planeId();
 
 protected:
     void createVertexBuffers();
-    void initializeFramebufferAndTextures();
+    void initializeInputTextures();
+    // Swaps the leased target for one of the new size when the size changed
+    bool acquireRenderTarget(int width = 1920, int height = 1080);
     virtual void loadShaders() = 0;
     virtual void run() = 0;
     virtual void reset();
+    virtual DirectSource nativeSource() const { return DirectSource(); }
 
 private: 
     void clearFrames();
@@ -90,13 +155,17 @@ protected:
     AudioStream* m_audio = nullptr;
 
     std::thread m_decoderThread;
-    ThreadableQueue<VideoFrame> m_videoQueue;
-    ThreadableQueue<AudioFrame> m_audioQueue;
+    FrameRing<VideoFrame> m_videoQueue;
+    FrameRing<AudioFrame> m_audioQueue;
     EGLSyncKHR m_fence = EGL_NO_SYNC;
     
-    GLuint m_frameBuffer = 0;
-    GLuint m_rgbTexture = 0;
-    Shader m_shader;
+    RenderTargetPool* m_renderTargetPool = nullptr;
+    RenderTarget* m_renderTarget = nullptr;
+    bool m_isRenderTargetWanted = true;
+    bool m_isVisible = true;
+    std::shared_ptr<Shader> m_shader = std::make_shared<Shader>();
+    bool m_isRgbOutputRequired = true;
+    bool m_isRgbOutputValid = false;
 
     std::vector<GLuint> m_yuvTextures;
     std::vector<EGLImage> m_yuvImages;
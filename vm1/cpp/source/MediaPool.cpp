@@ -11,6 +11,7 @@
 #include <functional>
 
 #include "MediaPool.h"
+#include "KeyframeIndex.h"
 
 MediaPool::MediaPool()
 {
@@ -61,6 +62,10 @@ void MediaPool::updateVideoFilePreviews()
             {
                 previewFiles.push_back(filePath);
             }
+            else if (entry.path().extension() == KeyframeIndex::SIDECAR_EXTENSION || filePath.ends_with(".keyframes.tmp"))
+            {
+                continue;
+            }
             else
             {
                 files.push_back(filePath);
@@ -68,6 +73,20 @@ void MediaPool::updateVideoFilePreviews()
         }
     }
 
+    // Keyframe indices first, they are quick to build and make seeking exact (see KeyframeIndex)
+    for (const auto& videoFile : files)
+    {
+        auto unindexable = m_unindexableFiles.find(videoFile);
+        if (unindexable != m_unindexableFiles.end()) {
+            std::pair<uint64_t, int64_t> stamp;
+            KeyframeIndex::readFileStamp(videoFile, stamp.first, stamp.second);
+            if (stamp == unindexable->second) continue;
+            m_unindexableFiles.erase(unindexable);
+        }
+        if (KeyframeIndex::isSidecarCurrent(videoFile)) continue;
+        generateKeyframeIndex(videoFile);
+    }
+
     // compare m_videoFilesPreviews with m_videoFiles
     std::vector<std::string> pendingPreviewFiles;
     for(const auto& videoFile : files) 
@@ -105,6 +124,16 @@ std::vector<DirectoryEntry> MediaPool::getEffectShaderFiles(const std::string& p
     return m_directoryCache.getEntries(getEffectShaderFilePath(path));
 }
 
+std::string MediaPool::getColorLutFilePath(const std::string& fileName)
+{
+    return m_colorLutPath + fileName;
+}
+
+std::vector<DirectoryEntry> MediaPool::getColorLutFiles(const std::string& path)
+{
+    return m_directoryCache.getEntries(getColorLutFilePath(path));
+}
+
 const ImageBuffer& MediaPool::getPreview(const std::string& path)
 {
     return m_previewCache.getEntry(getVideoFilePath(path));
@@ -197,6 +226,20 @@ void MediaPool::generateVideoFilePreview(std::string filename)
     }
 }
 
+void MediaPool::generateKeyframeIndex(const std::string& filename)
+{
+    KeyframeIndex index;
+    if (!index.build(filename) || !index.save(filename))
+    {
+        printf("No keyframe index for: %s\n", filename.c_str());
+        std::pair<uint64_t, int64_t> stamp;
+        KeyframeIndex::readFileStamp(filename, stamp.first, stamp.second);
+        m_unindexableFiles[filename] = stamp;
+        return;
+    }
+    printf("Keyframe index for %s: %zu keyframes\n", filename.c_str(), index.size());
+}
+
 void MediaPool::startDirectoryWatcher() 
 {
     stopDirectoryWatcher();
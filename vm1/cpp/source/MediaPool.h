@@ -12,6 +12,8 @@
 #include <string>
 #include <thread>
 #include <mutex>
+#include <map>
+#include <cstdint>
 
 #include "ImageBuffer.h"
 #include "DirectoryCache.h"
@@ -35,6 +37,9 @@ public:
     std::string getEffectShaderFilePath(const std::string& fileName);
     std::vector<DirectoryEntry> getEffectShaderFiles(const std::string& path = "");
 
+    std::string getColorLutFilePath(const std::string& fileName);
+    std::vector<DirectoryEntry> getColorLutFiles(const std::string& path = "");
+
     const ImageBuffer& getPreview(const std::string& path);
 
     void loadQrCodeImageBuffer();
@@ -49,12 +54,14 @@ private:
     void stopDirectoryWatcher();
     void updateVideoFilePreviews();
     void generateVideoFilePreview(std::string filename);
+    void generateKeyframeIndex(const std::string& filename);
 
 private:
     ImageBuffer m_logo = ImageBuffer("media/splash-screen.png");
     std::string m_videoFilePath = "../videos/";
     std::string m_generativeShaderPath = "../shaders/generative/";
     std::string m_effectShaderPath = "../shaders/effect/";
+    std::string m_colorLutPath = "../luts/";
 
     DirectoryCache m_directoryCache;
     PreviewCache m_previewCache;
@@ -63,5 +70,8 @@ private:
     ImageBuffer m_qrCodeTFMImageBuffer;
     std::thread m_thread;
     bool m_isWatcherRunning;
+    // File -> size and modification time it failed to index with, watcher thread only.
+    // Retried once the file changes (e.g. it was still being copied).
+    std::map<std::string, std::pair<uint64_t, int64_t>> m_unindexableFiles;
 
 };
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "NetworkTools.h"
 #include "VM1DeviceDefinitions.h"
 #include "ImageBuffer.h"
+#include "EffectChain.h"
 
 #include <imgui.h>
 #include <vector>
@@ -291,6 +292,9 @@ void MenuSystem::FileManagerDialog()
             if (std::filesystem::exists(oldAbsFilename + ".preview")) {
                 std::filesystem::rename(oldAbsFilename + ".preview", newAbsFilename + ".preview");
             }
+            if (std::filesystem::exists(oldAbsFilename + ".keyframes")) {
+                std::filesystem::rename(oldAbsFilename + ".keyframes", newAbsFilename + ".keyframes");
+            }
             
         };
     }
@@ -315,6 +319,8 @@ void MenuSystem::FileManagerDialog()
             std::filesystem::copy_file(sourceFile + ".preview", destinationFile + ".preview");
             std::filesystem::remove(sourceFile);
             std::filesystem::remove(sourceFile + ".preview");
+            // The copy is a new file, its keyframe index gets rebuilt by the media pool
+            std::filesystem::remove(sourceFile + ".keyframes");
             goUpHierachy();
         };
     }
@@ -350,6 +356,7 @@ void MenuSystem::FileManagerDialog()
             printf("Deleting %s\n", filePath.c_str());
             std::filesystem::remove(filePath);
             std::filesystem::remove(filePath + ".preview");
+            std::filesystem::remove(filePath + ".keyframes");
             goUpHierachy();
         };
     }
@@ -1085,22 +1092,27 @@ void MenuSystem::ControlMenu()
         m_ui.Label(shaderName);
         m_ui.Spacer();
 
-        for (auto& kv : shaderInputConfig->shaderConfig.params) {
-            auto& param = kv.second;
+        ShaderConfig& shaderConfig = shaderInputConfig->shaderConfig;
+        for (size_t i = 0; i < shaderConfig.params.size(); ++i) {
+            auto& param = shaderConfig.params[i];
+            auto& value = shaderConfig.values[i];
             if (std::holds_alternative<IntParameter>(param)) {
                 auto& intParam = std::get<IntParameter>(param);  
-                m_ui.SpinBoxInt(intParam.name, intParam.value, intParam.min, intParam.max, intParam.step);
+                m_ui.SpinBoxInt(intParam.name, value.intValue, intParam.min, intParam.max, intParam.step);
             } 
             else if (std::holds_alternative<FloatParameter>(param)) {
                 auto& floatParam = std::get<FloatParameter>(param); 
-                m_ui.SpinBoxFloat(floatParam.name, floatParam.value, floatParam.min, floatParam.max, floatParam.step);
+                m_ui.SpinBoxFloat(floatParam.name, value.floatValue.x, floatParam.min, floatParam.max, floatParam.step);
             }
             else if (std::holds_alternative<Vec2Parameter>(param)) {
                 auto& vec2Param = std::get<Vec2Parameter>(param); 
-                m_ui.SpinBoxVec2(vec2Param.name, vec2Param.value, vec2Param.min, vec2Param.max, vec2Param.step);
+                m_ui.SpinBoxVec2(vec2Param.name, value.floatValue, vec2Param.min, vec2Param.max, vec2Param.step);
             }
         }
         m_ui.Spacer();
+        m_ui.SpinBoxInt("Resolution", (int&)shaderInputConfig->renderScale, 0, 3, 1, {"Full", "1/2", "1/3", "Auto"});
+        m_ui.Label("Render size: " + std::to_string(int(1920 * shaderInputConfig->currentRenderScale + 0.5f)) + "x"
+                   + std::to_string(int(1080 * shaderInputConfig->currentRenderScale + 0.5f)));
         m_ui.SpinBoxInt("Output Plane", shaderInputConfig->planeId, 0, 3, 1, {"1", "2", "3", "4"});
     }
     
@@ -1139,12 +1151,13 @@ void MenuSystem::FxMenu()
     m_ui.Spacer();
     // m_ui.Label("---Custom FX---");
     SubMenu("Add Custom FX", [this](){ CustomEffectShaderSelection(); });
-    if(plane.shaderConfig.groups.size() > 2) {  // todo: '2' is temp value for the two build-in effects (chroma key, color correction)
+    if (!plane.effectChain.empty()) {
         if (m_ui.Action("Clear Custom FX")) {
-            plane.extShaderFilename = "";
+            plane.effectChain.clear();
             m_eventBus.publish(EffectShaderEvent(m_activeOutputPlane.planeId));
         }
     }
+    SubMenu("Color LUT", [this](){ ColorLutSelection(); });
     m_ui.EndList();
     m_ui.PopTranslate();
 }
@@ -1171,9 +1184,56 @@ void MenuSystem::CustomEffectShaderSelection()
         if (entry.isDir) {
             SubDir(entry.name, [this]() { CustomEffectShaderSelection(); });
         }
-        else if (m_ui.RadioButton(entry.name.c_str(), (plane.extShaderFilename == entry.absolutePath))) {
-            plane.extShaderFilename = entry.absolutePath;
-            m_eventBus.publish(EffectShaderEvent(m_activeOutputPlane.planeId));
+        else {
+            // Selecting an effect appends it to the chain, selecting it again removes it
+            auto it = std::find(plane.effectChain.begin(), plane.effectChain.end(), entry.absolutePath);
+            bool isInChain = (it != plane.effectChain.end());
+            if (m_ui.RadioButton(entry.name.c_str(), isInChain)) {
+                if (isInChain) {
+                    plane.effectChain.erase(it);
+                }
+                else if (plane.effectChain.size() < MAX_EFFECT_MODULES) {
+                    plane.effectChain.push_back(entry.absolutePath);
+                }
+                else {
+                    continue;
+                }
+                m_eventBus.publish(EffectShaderEvent(m_activeOutputPlane.planeId));
+            }
+        }
+    }
+    m_ui.EndList();
+    m_ui.PopTranslate();
+}
+
+void MenuSystem::ColorLutSelection()
+{
+    m_ui.MenuTitleWidget("COLOR LUT", TextAlign::CENTER);
+    m_ui.NewLine();
+
+    m_ui.PlanePreviewWidget(m_registry.planes(), m_activeOutputPlane.planeId, UI::PlanePreviewStyle::PLANE_PREVIEW_SMALL);
+    m_ui.NewLine();
+
+    m_ui.PushTranslate(0, 20);
+
+    PlaneSettings& plane = m_registry.planes()[m_activeOutputPlane.planeId];
+
+    std::string lutPath = currentDirectoryPath();
+    std::vector<DirectoryEntry> entries = m_registry.mediaPool().getColorLutFiles(lutPath);
+
+    m_ui.BeginList(&m_currentMenuPath.back().fIdx);
+    m_ui.TextStyle(BDF::TEXTSTYLE::MENU_ITEM_MONOSPACED);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const DirectoryEntry& entry = entries[i];
+        if (entry.isDir) {
+            SubDir(entry.name, [this]() { ColorLutSelection(); });
+        }
+        else {
+            // Selecting the active LUT again removes it, the plane re-bakes its color LUT on the next frame
+            bool isSelected = (plane.colorLutFilename == entry.absolutePath);
+            if (m_ui.RadioButton(entry.name.c_str(), isSelected)) {
+                plane.colorLutFilename = isSelected ? std::string() : entry.absolutePath;
+            }
         }
     }
     m_ui.EndList();
@@ -1195,43 +1255,28 @@ void MenuSystem::EffectControl()
     m_ui.BeginList(&m_currentMenuPath.back().fIdx);
     m_ui.TextStyle(BDF::TEXTSTYLE::MENU_ITEM);
     for (const auto& paramName : group) {
-        if (!shaderConfig.params.contains(paramName)) continue;
-        auto& param = shaderConfig.params[paramName];
+        int paramIndex = shaderConfig.indexOf(paramName);
+        if (paramIndex < 0) continue;
+        auto& param = shaderConfig.params[paramIndex];
+        auto& value = shaderConfig.values[paramIndex];
         if (std::holds_alternative<IntParameter>(param)) {
             auto& intParam = std::get<IntParameter>(param);  
-            m_ui.SpinBoxInt(intParam.name, intParam.value, intParam.min, intParam.max, intParam.step);
+            m_ui.SpinBoxInt(intParam.name, value.intValue, intParam.min, intParam.max, intParam.step);
         } 
         else if (std::holds_alternative<FloatParameter>(param)) {
             auto& floatParam = std::get<FloatParameter>(param); 
-            m_ui.SpinBoxFloat(floatParam.name, floatParam.value, floatParam.min, floatParam.max, floatParam.step);
+            m_ui.SpinBoxFloat(floatParam.name, value.floatValue.x, floatParam.min, floatParam.max, floatParam.step);
         }
         else if (std::holds_alternative<Vec2Parameter>(param)) {
             auto& vec2Param = std::get<Vec2Parameter>(param); 
-            glm::vec2 value(vec2Param.value.x, vec2Param.value.y);
-            glm::vec2 min(vec2Param.min.x, vec2Param.min.y);
-            glm::vec2 max(vec2Param.max.x, vec2Param.max.y);
-            glm::vec2 step(vec2Param.step.x, vec2Param.step.y);
-            m_ui.SpinBoxVec2(vec2Param.name, vec2Param.value, vec2Param.min, vec2Param.max, vec2Param.step);
+            m_ui.SpinBoxVec2(vec2Param.name, value.floatValue, vec2Param.min, vec2Param.max, vec2Param.step);
         } 
     }
     m_ui.Spacer();
     if(m_ui.Action("Reset"))
     {
         for (const auto& paramName : group) {
-            if (!shaderConfig.params.contains(paramName)) continue;
-            auto& param = shaderConfig.params[paramName];
-            if (std::holds_alternative<IntParameter>(param)) {
-                auto& intParam = std::get<IntParameter>(param);
-                intParam.reset();
-            } 
-            else if (std::holds_alternative<FloatParameter>(param)) {
-                auto& floatParam = std::get<FloatParameter>(param); 
-                floatParam.reset();
-            }
-            else if (std::holds_alternative<Vec2Parameter>(param)) {
-                auto& vec2Param = std::get<Vec2Parameter>(param);
-                vec2Param.reset();
-            } 
+            shaderConfig.resetValue(shaderConfig.indexOf(paramName));
         }
     }
     m_ui.EndList(); 
@@ -108,6 +108,7 @@ private:
     // FX
     void FxMenu();
     void CustomEffectShaderSelection();
+    void ColorLutSelection();
     void EffectSelection();
     void EffectControl();
   
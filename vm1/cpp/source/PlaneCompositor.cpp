@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "PlaneCompositor.h"
+#include "ShaderLibrary.h"
+
+#include <SDL3/SDL.h>
+#include <GLES3/gl31.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+
+static_assert(sizeof(CompositorPlane) == 160, "CompositorPlane must match the std140 layout of Plane");
+
+static float configFloat(const ShaderConfig& shaderConfig, const std::string& name, float defaultValue)
+{
+    int index = shaderConfig.indexOf(name);
+    if (index < 0) return defaultValue;
+    const ShaderParamValue& value = shaderConfig.values[index];
+    return (value.type == ShaderParamType::Int) ? float(value.intValue) : value.floatValue.x;
+}
+
+// Affine map from output positions to texture coordinates of one triangle, as two rows
+// of (x, y, 1) factors. Degenerate triangles map everything outside of [0, 1].
+static void triangleMap(const glm::vec2 positions[3], const glm::vec2 uvs[3], glm::vec4 rows[2])
+{
+    glm::mat2 p(positions[1] - positions[0], positions[2] - positions[0]);
+    if (std::abs(glm::determinant(p)) < 1e-8f) {
+        rows[0] = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+        rows[1] = glm::vec4(0.0f, 0.0f, -1.0f, 0.0f);
+        return;
+    }
+
+    glm::mat2 u(uvs[1] - uvs[0], uvs[2] - uvs[0]);
+    glm::mat2 m = u * glm::inverse(p);
+    glm::vec2 offset = uvs[0] - m * positions[0];
+    rows[0] = glm::vec4(m[0][0], m[1][0], offset.x, 0.0f);
+    rows[1] = glm::vec4(m[0][1], m[1][1], offset.y, 0.0f);
+}
+
+PlaneCompositor::~PlaneCompositor()
+{
+    finalize();
+}
+
+bool PlaneCompositor::initialize()
+{
+    finalize();
+
+    m_shader = ShaderLibrary::instance().load(PlaneRenderer::VERTEX_SHADER, FRAGMENT_SHADER);
+    if (!m_shader->isLinked()) {
+        SDL_Log("Couldn't load the plane compositor, planes are drawn one by one");
+        return false;
+    }
+
+    // The driver reports the block size with or without the padding after planeCount
+    const std::vector<UniformBlockInfo>& blocks = m_shader->uniformBlocks();
+    GLuint blockIndex = 0;
+    GLint planeCountOffset = 0;
+    if (blocks.size() != 1 || blocks[0].dataSize > GLint(sizeof(Block)) ||
+        !m_shader->uniformBlockMember("planeCount", blockIndex, planeCountOffset) ||
+        planeCountOffset != GLint(offsetof(Block, planeCount))) {
+        SDL_Log("Plane compositor block has an unexpected layout, planes are drawn one by one");
+        return false;
+    }
+
+    m_blockBinding = blocks[0].index;
+    m_shader->setUniformBlockBinding(blocks[0].index, m_blockBinding);
+    glGenBuffers(1, &m_blockBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_blockBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Sources on units 0 to 7, the color LUTs behind them
+    m_shader->activate();
+    for (int i = 0; i < MAX_PLANES * 2; ++i) {
+        m_shader->setValue("inputTexture" + std::to_string(i), GLint(i));
+    }
+    for (int i = 0; i < MAX_PLANES; ++i) {
+        m_shader->setValue("colorLut" + std::to_string(i), GLint(MAX_PLANES * 2 + i));
+    }
+    m_shader->deactivate();
+
+    createVertexBuffers();
+    m_isInitialized = true;
+    return true;
+}
+
+void PlaneCompositor::finalize()
+{
+    if (m_vao) glDeleteVertexArrays(1, &m_vao);
+    if (m_posVbo) glDeleteBuffers(1, &m_posVbo);
+    if (m_uvVbo) glDeleteBuffers(1, &m_uvVbo);
+    if (m_ibo) glDeleteBuffers(1, &m_ibo);
+    if (m_blockBuffer) glDeleteBuffers(1, &m_blockBuffer);
+    m_vao = m_posVbo = m_uvVbo = m_ibo = m_blockBuffer = 0;
+    m_shader.reset();
+    m_isInitialized = false;
+}
+
+void PlaneCompositor::createVertexBuffers()
+{
+    // Full screen quad, pass.vert hands the texture coordinates through
+    std::vector<glm::vec2> positions = {glm::vec2(-1.0f, -1.0f),
+                                        glm::vec2(1.0f, -1.0f),
+                                        glm::vec2(1.0f, 1.0f),
+                                        glm::vec2(-1.0f, 1.0f)};
+    std::vector<glm::vec2> uvs = {glm::vec2(0.0f, 0.0f),
+                                  glm::vec2(1.0f, 0.0f),
+                                  glm::vec2(1.0f, 1.0f),
+                                  glm::vec2(0.0f, 1.0f)};
+    unsigned int indices[] = { 0, 1, 2, 0, 2, 3 };
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_posVbo);
+    glGenBuffers(1, &m_uvVbo);
+    glGenBuffers(1, &m_ibo);
+
+    glBindVertexArray(m_vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_posVbo);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec2), positions.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_uvVbo);
+    glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void PlaneCompositor::setPlane(CompositorPlane& plane, const Layer& layer) const
+{
+    const PlaneSettings& planeSettings = *layer.planeSettings;
+    const ShaderConfig& shaderConfig = planeSettings.shaderConfig;
+    const PlaneRenderer::InternalShaderParams& params = layer.params;
+
+    // The per-plane quad is drawn as the triangles 0 1 2 and 0 2 3
+    const glm::vec2 uvs[4] = {glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f)};
+    const glm::vec2 positionsA[3] = {layer.quad[0], layer.quad[1], layer.quad[2]};
+    const glm::vec2 uvsA[3] = {uvs[0], uvs[1], uvs[2]};
+    const glm::vec2 positionsB[3] = {layer.quad[0], layer.quad[2], layer.quad[3]};
+    const glm::vec2 uvsB[3] = {uvs[0], uvs[2], uvs[3]};
+    triangleMap(positionsA, uvsA, plane.mapA);
+    triangleMap(positionsB, uvsB, plane.mapB);
+
+    // Chroma key and color correction are in the plane's color LUT
+    plane.mixing = glm::vec4(params.mixValue, planeSettings.opacity, configFloat(shaderConfig, "ChromaKey_Enable", 0.0f), 0.0f);
+    plane.modes = glm::ivec4(int(planeSettings.blendMode), int(params.isTex0Valid), int(params.isTex1Valid), 0);
+    plane.sourceTypes = glm::ivec4(int(params.source0.type), int(params.source1.type), 0, 0);
+    plane.sourceLayout0 = params.source0.layout;
+    plane.sourceLayout1 = params.source1.layout;
+    plane.sourceSizes = glm::vec4(params.source0.size, params.source1.size);
+}
+
+void PlaneCompositor::render(const std::vector<Layer>& layers)
+{
+    if (!m_isInitialized) return;
+
+    int planeCount = std::min(int(layers.size()), MAX_PLANES);
+    for (int i = 0; i < planeCount; ++i) {
+        setPlane(m_block.planes[i], layers[i]);
+    }
+    m_block.planeCount = glm::ivec4(planeCount, 0, 0, 0);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_blockBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &m_block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, m_blockBinding, m_blockBuffer);
+
+    for (int i = 0; i < planeCount; ++i) {
+        const PlaneRenderer::InternalShaderParams& params = layers[i].params;
+        bool isDirect0 = params.source0.type != DirectSourceType::None;
+        bool isDirect1 = params.source1.type != DirectSourceType::None;
+        glActiveTexture(GL_TEXTURE0 + i * 2);
+        glBindTexture(GL_TEXTURE_2D, isDirect0 ? params.source0.texture : params.texture0);
+        glActiveTexture(GL_TEXTURE0 + i * 2 + 1);
+        glBindTexture(GL_TEXTURE_2D, isDirect1 ? params.source1.texture : params.texture1);
+        glActiveTexture(GL_TEXTURE0 + MAX_PLANES * 2 + i);
+        glBindTexture(GL_TEXTURE_3D, layers[i].colorLut);
+    }
+
+    m_shader->activate();
+    glBindVertexArray(m_vao);
+    glDisable(GL_BLEND);
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+    m_shader->deactivate();
+
+    // Unbind textures
+    for (int i = 0; i < planeCount; ++i) {
+        glActiveTexture(GL_TEXTURE0 + MAX_PLANES * 2 + i);
+        glBindTexture(GL_TEXTURE_3D, 0);
+    }
+    for (int i = planeCount * 2 - 1; i >= 0; --i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    m_stats.passes++;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include "PlaneRenderer.h"
+#include "Registry.h"
+#include "Shader.h"
+
+#include <GLES3/gl3.h>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include <memory>
+#include <vector>
+
+// Same layout as Plane in plane_compositor.frag (std140)
+struct CompositorPlane {
+    glm::vec4 mapA[2];
+    glm::vec4 mapB[2];
+    glm::vec4 mixing;
+    glm::ivec4 modes;
+    glm::ivec4 sourceTypes;
+    glm::ivec4 sourceLayout0;
+    glm::ivec4 sourceLayout1;
+    glm::vec4 sourceSizes;
+};
+
+struct CompositorStats {
+    uint64_t passes = 0;            // single pass draws
+    int compositedPlanes = 0;       // last frame
+    int fallbackPlanes = 0;         // last frame, drawn by their PlaneRenderer
+};
+
+// Draws the planes of one output in a single full screen pass. Every fragment
+// evaluates the quad mapping, color LUT (see ColorLut), opacity and blend mode
+// of all planes in plane order and writes the blended result, so the output is
+// neither cleared nor blended by the GPU. Planes with effect modules are not
+// supported, they are drawn by their PlaneRenderer on top.
+class PlaneCompositor
+{
+public:
+    static constexpr int MAX_PLANES = 4;    // two sources and a color LUT each, 12 texture units
+    static constexpr const char* FRAGMENT_SHADER = "shaders/plane_compositor.frag";
+
+    struct Layer {
+        const PlaneSettings* planeSettings = nullptr;
+        std::vector<glm::vec2> quad;        // see PlaneRenderer::transformPlane()
+        GLuint colorLut = 0;                // see PlaneRenderer::updateColorLut()
+        PlaneRenderer::InternalShaderParams params;
+    };
+
+    PlaneCompositor() = default;
+    ~PlaneCompositor();
+
+    PlaneCompositor(const PlaneCompositor&) = delete;
+    PlaneCompositor& operator=(const PlaneCompositor&) = delete;
+
+public:
+    bool initialize();
+    void finalize();
+    bool isInitialized() const { return m_isInitialized; }
+
+    // Replaces the whole viewport, at most MAX_PLANES layers
+    void render(const std::vector<Layer>& layers);
+
+    CompositorStats& stats() { return m_stats; }
+    const CompositorStats& stats() const { return m_stats; }
+
+private:
+    struct Block {
+        CompositorPlane planes[MAX_PLANES];
+        glm::ivec4 planeCount;
+    };
+
+    void createVertexBuffers();
+    void setPlane(CompositorPlane& plane, const Layer& layer) const;
+
+private:
+    std::shared_ptr<Shader> m_shader;
+    GLuint m_vao = 0;
+    GLuint m_posVbo = 0;
+    GLuint m_uvVbo = 0;
+    GLuint m_ibo = 0;
+    GLuint m_blockBuffer = 0;
+    GLuint m_blockBinding = 0;
+    Block m_block = {};
+    bool m_isInitialized = false;
+    CompositorStats m_stats;
+};
@@ -76,6 +76,14 @@ void PlaneRenderer::createVertexBuffers()
 }
 
 void PlaneRenderer::updateVertexBuffers(ScreenRotation rotation, PlaneSettings& planeSettings) {
+    transformPlane(rotation, planeSettings, m_rotatedPlane);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_posVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, m_rotatedPlane.size() * sizeof(glm::vec2), m_rotatedPlane.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void PlaneRenderer::transformPlane(ScreenRotation rotation, const PlaneSettings& planeSettings, std::vector<glm::vec2>& plane) const {
     float degrees = float(int(rotation) * 90) + planeSettings.rotation;
     float angle = glm::radians(degrees);
     // printf("degrees: %f\n", degrees);
@@ -92,12 +100,39 @@ void PlaneRenderer::updateVertexBuffers(ScreenRotation rotation, PlaneSettings&
         v = scaleMatrix * v;
         v += translation;
         v = screenRotationMatrix * v;
-        m_rotatedPlane[i] = v;
+        plane[i] = v;
     }
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_posVbo);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, m_rotatedPlane.size() * sizeof(glm::vec2), m_rotatedPlane.data());
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+bool PlaneRenderer::coversOutput(const PlaneSettings& planeSettings, ScreenRotation rotation) const
+{
+    std::vector<glm::vec2> plane = m_plane;
+    transformPlane(rotation, planeSettings, plane);
+
+    // The quad covers the output when all four screen corners lie inside it.
+    // Only convex quads are handled, everything else never counts as covering.
+    const glm::vec2 corners[] = { glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 1.0f), glm::vec2(-1.0f, 1.0f) };
+    const float epsilon = 1e-4f;
+    float orientation = 0.0f;
+    for (size_t i = 0; i < plane.size(); ++i) {
+        const glm::vec2& a = plane[i];
+        const glm::vec2& b = plane[(i + 1) % plane.size()];
+        const glm::vec2& c = plane[(i + 2) % plane.size()];
+        float turn = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+        if (std::abs(turn) < epsilon) return false;
+        if (orientation == 0.0f) orientation = turn;
+        if ((turn > 0.0f) != (orientation > 0.0f)) return false;
+    }
+
+    for (const auto& corner : corners) {
+        for (size_t i = 0; i < plane.size(); ++i) {
+            const glm::vec2& a = plane[i];
+            const glm::vec2& b = plane[(i + 1) % plane.size()];
+            float side = (b.x - a.x) * (corner.y - a.y) - (b.y - a.y) * (corner.x - a.x);
+            if (orientation > 0.0f ? side < -epsilon : side > epsilon) return false;
+        }
+    }
+    return true;
 }
 
 bool PlaneRenderer::initialize()
@@ -109,62 +144,113 @@ bool PlaneRenderer::initialize()
     return true;
 }
 
-bool PlaneRenderer::loadShader(const std::string& extFilename)
+bool PlaneRenderer::loadShader(const std::vector<std::string>& effectChain)
 {
-    return m_shader.load("shaders/pass.vert", "shaders/plane_with_effects.frag", extFilename);
+    return setShader(ShaderLibrary::instance().load(VERTEX_SHADER, FRAGMENT_SHADER, effectChain), !effectChain.empty());
+}
+
+bool PlaneRenderer::setShader(std::shared_ptr<Shader> shader, bool hasEffect)
+{
+    m_shader = shader;
+    bool result = m_shader->isLinked();
+    m_hasEffect = result && hasEffect;
+    resolveUniformHandles();
+    m_paramBlocks.initialize(*m_shader);
+    m_paramLayoutId = 0;
+    return result;
+}
+
+void PlaneRenderer::resolveUniformHandles()
+{
+    m_uniforms.inputTexture0 = m_shader->uniformHandle("inputTexture0");
+    m_uniforms.inputTexture1 = m_shader->uniformHandle("inputTexture1");
+    m_uniforms.colorLut = m_shader->uniformHandle("colorLut");
+    m_uniforms.isTex0Valid = m_shader->uniformHandle("isTex0Valid");
+    m_uniforms.isTex1Valid = m_shader->uniformHandle("isTex1Valid");
+    m_uniforms.sourceType0 = m_shader->uniformHandle("sourceType0");
+    m_uniforms.sourceType1 = m_shader->uniformHandle("sourceType1");
+    m_uniforms.sourceLayout0 = m_shader->uniformHandle("sourceLayout0");
+    m_uniforms.sourceLayout1 = m_shader->uniformHandle("sourceLayout1");
+    m_uniforms.sourceSize0 = m_shader->uniformHandle("sourceSize0");
+    m_uniforms.sourceSize1 = m_shader->uniformHandle("sourceSize1");
+    m_uniforms.mixValue = m_shader->uniformHandle("mixValue");
+    m_uniforms.iTime = m_shader->uniformHandle("iTime");
+    m_uniforms.analog0 = m_shader->uniformHandle("analog0");
+    m_uniforms.analog1 = m_shader->uniformHandle("analog1");
+    m_uniforms.analog2 = m_shader->uniformHandle("analog2");
+    m_uniforms.analog3 = m_shader->uniformHandle("analog3");
+    m_uniforms.opacity = m_shader->uniformHandle("opacity");
+    m_uniforms.isMultiplication = m_shader->uniformHandle("isMultiplication");
+    m_uniforms.isAdd = m_shader->uniformHandle("isAdd");
 }
 
 const ShaderConfig& PlaneRenderer::shaderConfig()
 {
-    return m_shader.shaderConfig();
+    return m_shader->shaderConfig();
+}
+
+void PlaneRenderer::updateColorLut(const PlaneSettings& planeSettings)
+{
+    m_colorLut.update(ColorLutParams::fromShaderConfig(planeSettings.shaderConfig, planeSettings.colorLutFilename));
 }
 
 void PlaneRenderer::update(PlaneSettings& planeSettings, ScreenRotation rotation, InternalShaderParams internalShaderParams)
 {   
     const ShaderConfig& shaderConfig = planeSettings.shaderConfig;
     updateVertexBuffers(rotation, planeSettings);
+    updateColorLut(planeSettings);
 
-    m_shader.activate();
+    m_shader->activate();
     glBindVertexArray(m_vao);
 
     // Set external shader parameters
-    for (auto& kv : shaderConfig.params) {
-        const std::string& uniformName = kv.first;
-        auto& param = kv.second;
-        if (std::holds_alternative<IntParameter>(param)) {
-            auto& intParam = std::get<IntParameter>(param);
-            m_shader.setValue(uniformName.c_str(), intParam.value);
-        } 
-        else if (std::holds_alternative<FloatParameter>(param)) {
-            auto& floatParam = std::get<FloatParameter>(param);
-            m_shader.setValue(uniformName.c_str(), floatParam.value);
-        }
-        else if (std::holds_alternative<Vec2Parameter>(param)) {
-            auto& vec2Param = std::get<Vec2Parameter>(param);
-            glm::vec2 value(vec2Param.value.x, vec2Param.value.y);
-            m_shader.setValue(uniformName.c_str(), value);
-        }
-        
+    if (shaderConfig.layoutId != m_paramLayoutId) {
+        m_paramHandles = m_shader->uniformHandles(shaderConfig.names);
+        m_paramLayoutId = shaderConfig.layoutId;
     }
+    // Members of uniform blocks have no handle, they are packed into the block buffers instead
+    m_shader->setValues(m_paramHandles, shaderConfig.values);
+    m_paramBlocks.update(*m_shader, shaderConfig);
+    m_paramBlocks.bind();
 
     // Set internal shader parameters
+    const DirectSource& source0 = internalShaderParams.source0;
+    const DirectSource& source1 = internalShaderParams.source1;
+    bool isDirect0 = source0.type != DirectSourceType::None;
+    bool isDirect1 = source1.type != DirectSourceType::None;
+
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, internalShaderParams.texture0);
-    m_shader.bindUniformLocation("inputTexture0", 0);
+    glBindTexture(GL_TEXTURE_2D, isDirect0 ? source0.texture : internalShaderParams.texture0);
+    m_shader->setValue(m_uniforms.inputTexture0, 0);
 
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, internalShaderParams.texture1);
-    m_shader.bindUniformLocation("inputTexture1", 1);
+    glBindTexture(GL_TEXTURE_2D, isDirect1 ? source1.texture : internalShaderParams.texture1);
+    m_shader->setValue(m_uniforms.inputTexture1, 1);
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_3D, m_colorLut.texture());
+    m_shader->setValue(m_uniforms.colorLut, 2);
+
+    m_shader->setValue(m_uniforms.sourceType0, int(source0.type));
+    m_shader->setValue(m_uniforms.sourceType1, int(source1.type));
+    if (isDirect0) {
+        m_shader->setValue(m_uniforms.sourceLayout0, source0.layout);
+        m_shader->setValue(m_uniforms.sourceSize0, source0.size);
+    }
+    if (isDirect1) {
+        m_shader->setValue(m_uniforms.sourceLayout1, source1.layout);
+        m_shader->setValue(m_uniforms.sourceSize1, source1.size);
+    }
     
-    m_shader.setValue("isTex0Valid", int(internalShaderParams.isTex0Valid));
-    m_shader.setValue("isTex1Valid", int(internalShaderParams.isTex1Valid));
+    m_shader->setValue(m_uniforms.isTex0Valid, int(internalShaderParams.isTex0Valid));
+    m_shader->setValue(m_uniforms.isTex1Valid, int(internalShaderParams.isTex1Valid));
 
-    m_shader.setValue("mixValue", internalShaderParams.mixValue);
-    m_shader.setValue("iTime", internalShaderParams.iTime);
-    m_shader.setValue("analog0", internalShaderParams.analog0);
-    m_shader.setValue("analog1", internalShaderParams.analog1);
-    m_shader.setValue("analog2", internalShaderParams.analog2);
-    m_shader.setValue("analog3", internalShaderParams.analog3);
+    m_shader->setValue(m_uniforms.mixValue, internalShaderParams.mixValue);
+    m_shader->setValue(m_uniforms.iTime, internalShaderParams.iTime);
+    m_shader->setValue(m_uniforms.analog0, internalShaderParams.analog0);
+    m_shader->setValue(m_uniforms.analog1, internalShaderParams.analog1);
+    m_shader->setValue(m_uniforms.analog2, internalShaderParams.analog2);
+    m_shader->setValue(m_uniforms.analog3, internalShaderParams.analog3);
 
     // Set blend mode
     int isMultiplication = 0;
@@ -189,9 +275,9 @@ void PlaneRenderer::update(PlaneSettings& planeSettings, ScreenRotation rotation
             glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
             break;
     }
-    m_shader.setValue("opacity", planeSettings.opacity);
-    m_shader.setValue("isMultiplication", isMultiplication);
-    m_shader.setValue("isAdd", isAdd);
+    m_shader->setValue(m_uniforms.opacity, planeSettings.opacity);
+    m_shader->setValue(m_uniforms.isMultiplication, isMultiplication);
+    m_shader->setValue(m_uniforms.isAdd, isAdd);
 
 
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
@@ -199,13 +285,16 @@ void PlaneRenderer::update(PlaneSettings& planeSettings, ScreenRotation rotation
     glDisable(GL_BLEND);
 
     glBindVertexArray(0);
-    m_shader.deactivate();
+    m_shader->deactivate();
 
     // Unbind textures
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, 0);
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glActiveTexture(GL_TEXTURE0);
 }
 
 
@@ -9,9 +9,13 @@
 #pragma once
 
 #include "Shader.h"
+#include "ShaderLibrary.h"
 #include "ShaderConfig.h"
+#include "ColorLut.h"
+#include "UniformBlockBuffer.h"
 #include "ScreenOptions.h"
 #include "Registry.h"
+#include "MediaPlayer.h"
 
 #include <SDL3/SDL_opengl.h>
 #include <SDL3/SDL_opengles2.h>
@@ -27,6 +31,8 @@ public:
         GLuint texture1 = 0;
         bool isTex0Valid = false;
         bool isTex1Valid = false;
+        DirectSource source0;   // sampled instead of texture0 unless the type is None
+        DirectSource source1;
         float mixValue = 0.0f;
         float iTime = 0.0f;
         float analog0 = 0.0f;
@@ -35,6 +41,10 @@ public:
         float analog3 = 0.0f;
     };
 
+public:
+    static constexpr const char* VERTEX_SHADER = "shaders/pass.vert";
+    static constexpr const char* FRAGMENT_SHADER = "shaders/plane_with_effects.frag";
+
 public: 
     PlaneRenderer();
     ~PlaneRenderer();
@@ -42,13 +52,49 @@ public:
 public:
     bool initialize();
     const ShaderConfig& shaderConfig();
-    bool loadShader(const std::string& extFilename = "");
+    bool loadShader(const std::vector<std::string>& effectChain = {});
+    // Takes over a program built from VERTEX_SHADER and FRAGMENT_SHADER (e.g. by the ShaderCompiler)
+    bool setShader(std::shared_ptr<Shader> shader, bool hasEffect);
+    bool hasEffect() const { return m_hasEffect; }
+    const UniformBlockStats& uniformBlockStats() const { return m_paramBlocks.stats(); }
+    // Re-bakes the color LUT when the plane's color correction, chroma key or LUT file changed
+    void updateColorLut(const PlaneSettings& planeSettings);
+    GLuint colorLutTexture() const { return m_colorLut.texture(); }
+    const ColorLutStats& colorLutStats() const { return m_colorLut.stats(); }
+    bool coversOutput(const PlaneSettings& planeSettings, ScreenRotation rotation) const;
+    // Output positions of the quad corners (bottom left, bottom right, top right, top left)
+    void transformPlane(ScreenRotation rotation, const PlaneSettings& planeSettings, std::vector<glm::vec2>& plane) const;
     //void update(GLuint texture0, GLuint texture1, float mixValue, PlaneSettings& planeSettings, ScreenRotation rotation);
     void update(PlaneSettings& planeSettings, ScreenRotation rotation, InternalShaderParams internalShaderParams);
     
 
 private:
+    // Uniforms set for every plane on every frame
+    struct UniformHandles {
+        UniformHandle inputTexture0;
+        UniformHandle inputTexture1;
+        UniformHandle colorLut;
+        UniformHandle isTex0Valid;
+        UniformHandle isTex1Valid;
+        UniformHandle sourceType0;
+        UniformHandle sourceType1;
+        UniformHandle sourceLayout0;
+        UniformHandle sourceLayout1;
+        UniformHandle sourceSize0;
+        UniformHandle sourceSize1;
+        UniformHandle mixValue;
+        UniformHandle iTime;
+        UniformHandle analog0;
+        UniformHandle analog1;
+        UniformHandle analog2;
+        UniformHandle analog3;
+        UniformHandle opacity;
+        UniformHandle isMultiplication;
+        UniformHandle isAdd;
+    };
+
     void createVertexBuffers();
+    void resolveUniformHandles();
     void updateVertexBuffers(ScreenRotation rotation, PlaneSettings& PlaneSettings);
 
 private:
@@ -56,7 +102,13 @@ private:
     GLuint m_posVbo;
     GLuint m_uvVbo;
     GLuint m_ibo;
-    Shader m_shader;
+    std::shared_ptr<Shader> m_shader = std::make_shared<Shader>();
+    UniformHandles m_uniforms;
+    std::vector<UniformHandle> m_paramHandles;
+    UniformBlockBuffer m_paramBlocks;
+    uint64_t m_paramLayoutId = 0;
+    ColorLut m_colorLut;
+    bool m_hasEffect = false;
 
     std::vector<glm::vec2> m_plane = { glm::vec2(-1.0f, -1.0f), 
                                        glm::vec2(1.0f, -1.0f), 
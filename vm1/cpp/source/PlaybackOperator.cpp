@@ -9,6 +9,11 @@
 #include "PlaybackOperator.h"
 #include "VM1DeviceDefinitions.h"
 
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
 PlaybackOperator::PlaybackOperator(Registry& registry, EventBus& eventBus, DeviceController& deviceController) : 
     m_registry(registry),
     m_eventBus(eventBus),
@@ -24,16 +29,124 @@ PlaybackOperator::~PlaybackOperator()
 
 void PlaybackOperator::reloadPlaneShader(int planeId)
 {
-    const std::string& extShaderFilename = m_registry.planes()[planeId].extShaderFilename;
-    std::string completeFilePath;
-    if (!extShaderFilename.empty()) {
-        completeFilePath = extShaderFilename;
-    }
     PlaneRenderer* planeRenderer = m_planeRenderers[planeId];
-    planeRenderer->loadShader(completeFilePath);
+    planeRenderer->loadShader(m_registry.planes()[planeId].effectChain);
     m_registry.planes()[planeId].shaderConfig.update(planeRenderer->shaderConfig());
 }
 
+void PlaybackOperator::requestPlaneShader(int planeId, const ShaderFileChange& change)
+{
+    // The current effects keep rendering until the new program is linked
+    std::vector<std::string> effectChain = m_registry.planes()[planeId].effectChain;
+    m_planeShaderRequests[planeId] = m_shaderCompiler.request(PlaneRenderer::VERTEX_SHADER, PlaneRenderer::FRAGMENT_SHADER, effectChain,
+        [this, planeId, hasEffect = !effectChain.empty(), change](const ShaderCompileResult& result) {
+            auto it = m_planeShaderRequests.find(planeId);
+            if (it == m_planeShaderRequests.end() || it->second != result.requestId) return;
+            m_planeShaderRequests.erase(it);
+
+            bool isLinked = result.shader->isLinked();
+            if (change.changeTimeNs > 0) finishShaderReload(change, isLinked);
+            if (!isLinked) {
+                publishShaderError(*result.shader);
+                return;
+            }
+
+            PlaneRenderer* planeRenderer = m_planeRenderers[planeId];
+            planeRenderer->setShader(result.shader, hasEffect);
+            m_registry.planes()[planeId].shaderConfig.update(planeRenderer->shaderConfig());
+        });
+}
+
+void PlaybackOperator::reloadShaderPlayer(int mediaSlotId, int playerId, const ShaderFileChange& change)
+{
+    ShaderInputConfig* shaderInputConfig = m_registry.inputMappings().getShaderInputConfig(mediaSlotId);
+    if (!shaderInputConfig) return;
+
+    m_shaderPlayerRequests[playerId] = m_shaderCompiler.request("shaders/pass.vert", shaderInputConfig->fileName, {},
+        [this, mediaSlotId, playerId, change](const ShaderCompileResult& result) {
+            auto it = m_shaderPlayerRequests.find(playerId);
+            if (it == m_shaderPlayerRequests.end() || it->second != result.requestId) return;
+            m_shaderPlayerRequests.erase(it);
+
+            // The slot may have stopped while compiling
+            ShaderInputConfig* shaderInputConfig = m_registry.inputMappings().getShaderInputConfig(mediaSlotId);
+            ShaderPlayer* shaderPlayer = dynamic_cast<ShaderPlayer*>(m_mediaPlayers[playerId]);
+            if (!shaderInputConfig || shaderInputConfig->playerId != playerId || !shaderPlayer) return;
+
+            bool isLinked = result.shader->isLinked();
+            finishShaderReload(change, isLinked);
+            if (!isLinked) {
+                publishShaderError(*result.shader);
+                return;
+            }
+
+            // Swapped in place without a fade, parameters that still exist keep their values
+            shaderPlayer->setShader(result.shader);
+            shaderInputConfig->shaderConfig.update(shaderPlayer->shaderConfig());
+            if (ShaderInputConfig* stagedInputConfig = m_registry.inputMappings().getShaderInputConfig(mediaSlotId, true)) {
+                stagedInputConfig->shaderConfig.update(shaderPlayer->shaderConfig());
+            }
+        });
+}
+
+// Registry filenames are relative or absolute, watcher paths are canonical
+static bool isSameShaderFile(const std::string& filename, const std::string& canonicalPath)
+{
+    if (filename.empty()) return false;
+    std::error_code error;
+    return fs::weakly_canonical(filename, error).string() == canonicalPath;
+}
+
+void PlaybackOperator::reloadChangedShaders()
+{
+    if (m_isShaderWatcherEnabled != m_registry.settings().useShaderHotReload) {
+        m_isShaderWatcherEnabled = m_registry.settings().useShaderHotReload;
+        if (m_isShaderWatcherEnabled) {
+            MediaPool& mediaPool = m_registry.mediaPool();
+            m_shaderWatcher.start({mediaPool.getEffectShaderFilePath(""), mediaPool.getGenerativeShaderFilePath("")});
+        }
+        else {
+            m_shaderWatcher.stop();
+        }
+    }
+
+    for (const ShaderFileChange& change : m_shaderWatcher.poll()) {
+        SDL_Log("Shader changed: %s", change.path.c_str());
+        for (int planeId = 0; planeId < int(m_planeRenderers.size()); ++planeId) {
+            const std::vector<std::string>& effectChain = m_registry.planes()[planeId].effectChain;
+            bool isInChain = std::any_of(effectChain.begin(), effectChain.end(), [&change](const std::string& filename) {
+                return isSameShaderFile(filename, change.path);
+            });
+            if (isInChain) requestPlaneShader(planeId, change);
+        }
+
+        for (int activeSlotId : m_registry.inputMappings().activeSlotIds()) {
+            ShaderInputConfig* shaderInputConfig = m_registry.inputMappings().getShaderInputConfig(activeSlotId);
+            if (shaderInputConfig && shaderInputConfig->playerId >= 0 && isSameShaderFile(shaderInputConfig->fileName, change.path)) {
+                reloadShaderPlayer(activeSlotId, shaderInputConfig->playerId, change);
+            }
+        }
+    }
+}
+
+void PlaybackOperator::finishShaderReload(const ShaderFileChange& change, bool isLinked)
+{
+    if (!isLinked) {
+        m_shaderReloadStats.failed++;
+        return;
+    }
+    // Latency is taken once renderPlane() drew the next frame
+    m_reloadsAwaitingFrame.push_back(change);
+}
+
+void PlaybackOperator::publishShaderError(const Shader& shader)
+{
+    // Only the first line fits the popup, the full log went to SDL_Log
+    std::string message = shader.errorLog().substr(0, shader.errorLog().find('\n'));
+    if (message.empty()) message = "Shader not supported";
+    m_eventBus.publish(PlaybackEvent(PlaybackEvent::Type::ShaderCompileFailed, message));
+}
+
 void PlaybackOperator::subscribeToEvents()
 {
     m_eventBus.subscribe<MediaSlotEvent>([this](const MediaSlotEvent& event) {
@@ -54,7 +167,7 @@ void PlaybackOperator::subscribeToEvents()
     });
 
     m_eventBus.subscribe<EffectShaderEvent>([this](const EffectShaderEvent& event) {
-        reloadPlaneShader(event.planeId);
+        requestPlaneShader(event.planeId);
     });
 
     m_eventBus.subscribe<PlaneEvent>([this](const PlaneEvent& event) {
@@ -95,6 +208,9 @@ void PlaybackOperator::initialize()
         m_planeMixers.push_back(PlaneMixer());
     } 
 
+    // Shaders selected later on are compiled in the background, the initial ones below are needed right away
+    m_shaderCompiler.initialize();
+
     for (size_t i = 0; i < planeCount; ++i) {
         PlaneRenderer* planeRenderer = new PlaneRenderer();
         m_planeRenderers.push_back(planeRenderer);
@@ -103,12 +219,14 @@ void PlaybackOperator::initialize()
         //m_registry.planes()[i].shaderConfig.update(planeRenderer->shaderConfig());
         reloadPlaneShader(i);
     }
+    m_planeCompositor.initialize();
 
     for (size_t i = 0; i < videoPlayerCount; ++i) {
         m_videoPlayers.push_back(new VideoPlayer());
         MediaPlayer* mediaPlayer = m_videoPlayers[i];
         m_mediaPlayers.push_back(mediaPlayer);
     }
+    m_prerolls.resize(videoPlayerCount);
 
     for (size_t i = 0; i < cameraPlayerCount; ++i) {
         WebcamPlayer* webcamPlayer = new WebcamPlayer();
@@ -124,6 +242,10 @@ void PlaybackOperator::initialize()
         m_mediaPlayers.push_back(mediaPlayer);
     }
 
+    for (auto mediaPlayer : m_mediaPlayers) {
+        mediaPlayer->setRenderTargetPool(&m_renderTargetPool);
+    }
+
     m_audioSystem.initialize();
     for (size_t i = 0; i < m_mediaPlayers.size(); ++i) {
         AudioDevice* audioDevice = m_audioSystem.audioDevice(0);
@@ -141,6 +263,17 @@ void PlaybackOperator::finalize()
 {
     m_isInitialized = false;
 
+    m_shaderCompiler.finalize();
+    m_planeCompositor.finalize();
+    m_planeShaderRequests.clear();
+    m_shaderPlayerRequests.clear();
+    m_shaderWatcher.stop();
+    m_isShaderWatcherEnabled = false;
+    m_reloadsAwaitingFrame.clear();
+    m_prerolls.clear();
+    m_failedPrerolls.clear();
+    m_triggersAwaitingFrame.clear();
+
     for (auto videoPlayer : m_videoPlayers) {
         delete videoPlayer;
     }
@@ -164,6 +297,7 @@ void PlaybackOperator::finalize()
     m_mediaPlayers.clear(); 
     m_planeMixers.clear();
     m_audioStreams.clear();
+    m_renderTargetPool.clear();
 
     m_audioSystem.finalize();
 }
@@ -183,28 +317,171 @@ bool PlaybackOperator::getFreeVideoPlayerId(int& id, int planeId)
         }
         else {
             //printf("looking for empty videoplayerId...\n");
-            for (size_t i = 0; i < m_videoPlayers.size(); ++i) {
-                //printf("videoplayerId: %d isPlayerIdActive: %d \n", i, isPlayerIdActive(i));
-                if(!isPlayerIdActive(i) && dynamic_cast<VideoPlayer *>(m_mediaPlayers[i])) {
-                    //printf("id = %d\n", i);
-                    id = int(i);
-                    return true;
-                }
-            }
+            return getIdleVideoPlayerId(id);
         }
         return false;
     }
     else {        
-        for (size_t i = 0; i < m_videoPlayers.size(); ++i) {
-            if(!isPlayerIdActive(i) && dynamic_cast<VideoPlayer *>(m_mediaPlayers[i])) {
-                id = i;
-                return true;
-            }
+        return getIdleVideoPlayerId(id);
+    }
+    return false;
+}
+
+bool PlaybackOperator::getIdleVideoPlayerId(int& id)
+{
+    // Pre-rolled players are only given up when no other player is idle. Players
+    // still opening their pre-roll come last, closing them waits for the open.
+    int prerolledId = -1;
+    int openingId = -1;
+    for (size_t i = 0; i < m_videoPlayers.size(); ++i) {
+        if (isPlayerIdActive(int(i))) continue;
+        if (m_videoPlayers[i]->isOpeningPreroll()) {
+            if (openingId < 0) openingId = int(i);
+        }
+        else if (m_prerolls[i].mediaSlotId < 0) {
+            id = int(i);
+            return true;
+        }
+        else if (prerolledId < 0) {
+            prerolledId = int(i);
         }
     }
+    if (prerolledId < 0) prerolledId = openingId;
+    if (prerolledId < 0) return false;
+
+    m_prerolls[prerolledId] = Preroll();
+    id = prerolledId;
+    return true;
+}
+
+bool PlaybackOperator::getPrerolledVideoPlayerId(int& id, int mediaSlotId, const VideoInputConfig& videoInputConfig)
+{
+    for (size_t i = 0; i < m_prerolls.size(); ++i) {
+        const Preroll& preroll = m_prerolls[i];
+        if (preroll.mediaSlotId != mediaSlotId) continue;
+        if (preroll.fileName != videoInputConfig.fileName || preroll.inPoint != videoInputConfig.inPoint) return false;
+        if (!m_videoPlayers[i]->isPrerollReady()) return false;
+        id = int(i);
+        return true;
+    }
     return false;
 }
 
+void PlaybackOperator::updatePreroll(const std::vector<int>& activePlayerIds)
+{
+    InputMappings& inputMappings = m_registry.inputMappings();
+    int budget = std::clamp(m_registry.settings().prerollSlots, 0, int(m_videoPlayers.size()) / 2);
+
+    // Video slots of the focused bank that aren't playing, the focused button first
+    int firstSlotId = inputMappings.focusedBank * MEDIA_BUTTON_COUNT;
+    int focusedSlotId = inputMappings.getFocusedMediaSlot();
+    std::vector<int> candidateSlotIds;
+    if (focusedSlotId >= firstSlotId && focusedSlotId < firstSlotId + MEDIA_BUTTON_COUNT) {
+        candidateSlotIds.push_back(focusedSlotId);
+    }
+    for (int slotId = firstSlotId; slotId < firstSlotId + MEDIA_BUTTON_COUNT; ++slotId) {
+        if (slotId != focusedSlotId) candidateSlotIds.push_back(slotId);
+    }
+
+    std::vector<int> wantedSlotIds;
+    for (int slotId : candidateSlotIds) {
+        if (int(wantedSlotIds.size()) >= budget) break;
+
+        VideoInputConfig* videoInputConfig = inputMappings.getVideoInputConfig(slotId, true);
+        if (!videoInputConfig || videoInputConfig->fileName.empty()) continue;
+        InputConfig* activeInputConfig = inputMappings.getInputConfig(slotId);
+        if (activeInputConfig && activeInputConfig->playerId >= 0) continue;
+        auto failed = m_failedPrerolls.find(slotId);
+        if (failed != m_failedPrerolls.end() && failed->second == videoInputConfig->fileName) continue;
+
+        wantedSlotIds.push_back(slotId);
+    }
+
+    // Give up pre-rolls that failed, aren't wanted anymore or went stale (file or in point edited)
+    for (size_t i = 0; i < m_prerolls.size(); ++i) {
+        Preroll& preroll = m_prerolls[i];
+        VideoPlayer* videoPlayer = m_videoPlayers[i];
+        if (preroll.mediaSlotId < 0 || videoPlayer->isOpeningPreroll()) continue;
+
+        if (videoPlayer->hasPrerollFailed()) {
+            SDL_Log("Pre-roll of slot %d failed: %s", preroll.mediaSlotId, preroll.fileName.c_str());
+            m_failedPrerolls[preroll.mediaSlotId] = preroll.fileName;
+        }
+        else {
+            VideoInputConfig* videoInputConfig = inputMappings.getVideoInputConfig(preroll.mediaSlotId, true);
+            bool isWanted = std::find(wantedSlotIds.begin(), wantedSlotIds.end(), preroll.mediaSlotId) != wantedSlotIds.end();
+            bool isCurrent = videoInputConfig &&
+                             videoInputConfig->fileName == preroll.fileName &&
+                             videoInputConfig->inPoint == preroll.inPoint;
+            if (isWanted && isCurrent) continue;
+        }
+
+        videoPlayer->close();
+        preroll = Preroll();
+    }
+
+    // Start at most one pre-roll per frame on an idle player
+    for (int slotId : wantedSlotIds) {
+        bool isPrerolled = std::any_of(m_prerolls.begin(), m_prerolls.end(), [slotId](const Preroll& preroll) {
+            return preroll.mediaSlotId == slotId;
+        });
+        if (isPrerolled) continue;
+
+        int playerId = -1;
+        for (int i = 0; i < int(m_videoPlayers.size()); ++i) {
+            if (m_prerolls[i].mediaSlotId >= 0 || isPlayerIdActive(i)) continue;
+            if (std::find(activePlayerIds.begin(), activePlayerIds.end(), i) != activePlayerIds.end()) continue;
+            playerId = i;
+            break;
+        }
+        if (playerId < 0) break;
+
+        VideoInputConfig* videoInputConfig = inputMappings.getVideoInputConfig(slotId, true);
+        VideoPlayer* videoPlayer = m_videoPlayers[playerId];
+        videoPlayer->setLooping(videoInputConfig->looping);
+        videoPlayer->setInPoint(videoInputConfig->inPoint);
+        videoPlayer->setOutPoint(videoInputConfig->outPoint);
+        videoPlayer->preroll(videoInputConfig->fileName, m_audioStreams[playerId]);
+
+        Preroll& preroll = m_prerolls[playerId];
+        preroll.mediaSlotId = slotId;
+        preroll.fileName = videoInputConfig->fileName;
+        preroll.inPoint = videoInputConfig->inPoint;
+        break;
+    }
+
+    m_prerollStats.prerolledPlayers = int(std::count_if(m_videoPlayers.begin(), m_videoPlayers.end(), [](const VideoPlayer* videoPlayer) {
+        return videoPlayer->isPrerollReady();
+    }));
+}
+
+void PlaybackOperator::updateTriggerLatencies()
+{
+    Uint64 now = SDL_GetTicksNS();
+    auto isDone = [this, now](const Trigger& trigger) {
+        VideoPlayer* videoPlayer = m_videoPlayers[trigger.playerId];
+        if (videoPlayer->hasPresentedFrame()) {
+            double latencyMs = double(now - trigger.timeNs) / 1000000.0;
+            if (trigger.isWarm) {
+                m_prerollStats.warmTriggers++;
+                m_prerollStats.lastWarmMs = latencyMs;
+                m_prerollStats.averageWarmMs += (latencyMs - m_prerollStats.averageWarmMs) / double(m_prerollStats.warmTriggers);
+            }
+            else {
+                m_prerollStats.coldTriggers++;
+                m_prerollStats.lastColdMs = latencyMs;
+                m_prerollStats.averageColdMs += (latencyMs - m_prerollStats.averageColdMs) / double(m_prerollStats.coldTriggers);
+            }
+            SDL_Log("Video player %d: %s trigger, %.1f ms to first frame", trigger.playerId, trigger.isWarm ? "warm" : "cold", latencyMs);
+            return true;
+        }
+        // Closed before it showed anything
+        return !videoPlayer->isPlaying();
+    };
+    m_triggersAwaitingFrame.erase(std::remove_if(m_triggersAwaitingFrame.begin(), m_triggersAwaitingFrame.end(), isDone),
+                                  m_triggersAwaitingFrame.end());
+}
+
 bool PlaybackOperator::getWebcamPlayerIdFromPort(int port, int& id)
 {
     for (size_t i = 0; i < m_mediaPlayers.size(); ++i) {     
@@ -222,7 +499,7 @@ bool PlaybackOperator::getWebcamPlayerIdFromPort(int port, int& id)
 bool PlaybackOperator::getFreeShaderPlayerId(int& id, int planeId)
 {
     for (size_t i = 0; i < m_mediaPlayers.size(); ++i) {     
-        if(!isPlayerIdActive(i) && dynamic_cast<ShaderPlayer *>(m_mediaPlayers[i])) {
+        if(!isPlayerIdActive(i) && !m_shaderPlayerRequests.contains(int(i)) && dynamic_cast<ShaderPlayer *>(m_mediaPlayers[i])) {
             id = int(i);
             return true;
         }
@@ -276,14 +553,20 @@ void PlaybackOperator::showMedia(int mediaSlotId)
     if (VideoInputConfig *videoInputConfig = dynamic_cast<VideoInputConfig *>(inputConfig))
     {
         filePath = videoInputConfig->fileName;
-        if (!getFreeVideoPlayerId(playerId, planeId)) return;
-
-        // Open video file
-        AudioStream* audioStream = m_audioStreams[playerId];
-        if (!m_mediaPlayers[playerId]->openFile(filePath, audioStream)) {
-            printf("Could not play!!\n");
-            m_eventBus.publish(PlaybackEvent(PlaybackEvent::Type::FileNotSupported, "Video not supported"));
-            return;
+        Uint64 triggerTimeNs = SDL_GetTicksNS();
+
+        // Pre-rolled slots are opened already and hold their first frame
+        bool isWarm = getPrerolledVideoPlayerId(playerId, mediaSlotId, *videoInputConfig);
+        if (!isWarm) {
+            if (!getFreeVideoPlayerId(playerId, planeId)) return;
+
+            // Open video file
+            AudioStream* audioStream = m_audioStreams[playerId];
+            if (!m_mediaPlayers[playerId]->openFile(filePath, audioStream)) {
+                printf("Could not play!!\n");
+                m_eventBus.publish(PlaybackEvent(PlaybackEvent::Type::FileNotSupported, "Video not supported"));
+                return;
+            }
         }
 
         // Set outPoint from duration on first load
@@ -302,7 +585,14 @@ void PlaybackOperator::showMedia(int mediaSlotId)
                 videoPlayer->setInPoint(inPoint);
                 double outPoint = videoInputConfig->outPoint;
                 videoPlayer->setOutPoint(outPoint);
-                videoPlayer->play();
+                if (isWarm) {
+                    videoPlayer->startPrerolled();
+                    m_prerolls[playerId] = Preroll();
+                }
+                else {
+                    videoPlayer->play();
+                }
+                m_triggersAwaitingFrame.push_back({ playerId, triggerTimeNs, isWarm });
             }
             
             videoInputConfig->playerId = playerId;
@@ -352,33 +642,54 @@ void PlaybackOperator::showMedia(int mediaSlotId)
     {
         if (!getFreeShaderPlayerId(playerId, planeId)) return;
         
-        // Open shader file
+        // Compile shader file in the background, showShader() opens it once it is linked
         filePath = shaderInputConfig->fileName;
-        if (!m_mediaPlayers[playerId]->openFile(filePath)) {
-            printf("Could not open custom shader!!\n");
-            m_eventBus.publish(PlaybackEvent(PlaybackEvent::Type::FileNotSupported, "Shader not supported"));
-            return;
-        }
+        bool isChanged = shaderInputConfig->changed;
+        m_shaderPlayerRequests[playerId] = m_shaderCompiler.request("shaders/pass.vert", filePath, {},
+            [this, mediaSlotId, playerId, filePath, isChanged](const ShaderCompileResult& result) {
+                showShader(mediaSlotId, playerId, filePath, isChanged, result);
+            });
+        return;
+    }
+    else {
+        return;
+    }
 
-        // Update shader parameters
-        if (ShaderPlayer* shaderPlayer = dynamic_cast<ShaderPlayer*>(m_mediaPlayers[playerId])) {
-            if (shaderInputConfig->changed) {
-                shaderInputConfig->shaderConfig = shaderPlayer->shaderConfig();
-            }
-            else {
-                shaderInputConfig->shaderConfig.update(shaderPlayer->shaderConfig());
-            }
-        }
+    m_registry.inputMappings().activateInputConfig(mediaSlotId);
+}
 
-        // Start fade
-        if (m_planeMixers[planeId].startFade(playerId))  {
-            //m_planeMixers[planeId].activate();            
-            shaderInputConfig->playerId = playerId;
-            printf("Shader Player ID: %d\n", playerId);
-        }
+void PlaybackOperator::showShader(int mediaSlotId, int playerId, const std::string& fileName, bool isChanged, const ShaderCompileResult& result)
+{
+    auto it = m_shaderPlayerRequests.find(playerId);
+    if (it == m_shaderPlayerRequests.end() || it->second != result.requestId) return;
+    m_shaderPlayerRequests.erase(it);
+
+    // The slot may have been cleared or reassigned while compiling
+    ShaderInputConfig *shaderInputConfig = dynamic_cast<ShaderInputConfig *>(m_registry.inputMappings().getInputConfig(mediaSlotId, true));
+    if (!shaderInputConfig || shaderInputConfig->fileName != fileName) return;
+
+    // Open shader file
+    ShaderPlayer* shaderPlayer = dynamic_cast<ShaderPlayer*>(m_mediaPlayers[playerId]);
+    if (!shaderPlayer || !shaderPlayer->setShader(result.shader)) {
+        printf("Could not open custom shader!!\n");
+        publishShaderError(*result.shader);
+        return;
+    }
+
+    // Update shader parameters
+    if (isChanged) {
+        shaderInputConfig->shaderConfig = shaderPlayer->shaderConfig();
     }
     else {
-        return;
+        shaderInputConfig->shaderConfig.update(shaderPlayer->shaderConfig());
+    }
+
+    // Start fade
+    int planeId = shaderInputConfig->planeId;
+    if (m_planeMixers[planeId].startFade(playerId))  {
+        //m_planeMixers[planeId].activate();            
+        shaderInputConfig->playerId = playerId;
+        printf("Shader Player ID: %d\n", playerId);
     }
 
     m_registry.inputMappings().activateInputConfig(mediaSlotId);
@@ -388,6 +699,22 @@ void PlaybackOperator::update(float deltaTime)
 {
     if (!m_isInitialized) return; 
 
+    m_shaderCompiler.update();
+    reloadChangedShaders();
+
+    if (Shader::isUniformCacheEnabled() != m_registry.settings().useUniformCache) {
+        Shader::setUniformCacheEnabled(m_registry.settings().useUniformCache);
+    }
+
+    DecodeBudget::instance().setThreadLimit(m_registry.settings().softwareDecodeThreads);
+    LoopCacheBudget::instance().setLimit(size_t(std::max(m_registry.settings().loopCacheMegabytes, 0)) << 20);
+    for (auto videoPlayer : m_videoPlayers) {
+        videoPlayer->setSinglePassConversion(m_registry.settings().useSinglePassVideoConversion);
+        videoPlayer->setMeasureGpuTime(m_registry.settings().measureGpuTimes);
+        videoPlayer->setUseKeyframeIndex(m_registry.settings().useKeyframeIndex);
+        videoPlayer->setUseLoopCache(m_registry.settings().useLoopCache);
+    }
+
     for (auto& planeMixer : m_planeMixers) {
         int playerId = planeMixer.toId();
         if (playerId >= 0 && m_mediaPlayers[playerId]->isFrameReady()) {
@@ -465,43 +792,30 @@ void PlaybackOperator::update(float deltaTime)
                         // TODO: Move to registry, maybe "Animation System"
                         ShaderConfig& shaderConfig = shaderInputConfig->shaderConfig;
 
-                        if (shaderConfig.params.contains("iTime")) {
-                            auto& param = shaderConfig.params["iTime"];
-                            if (std::holds_alternative<FloatParameter>(param)) {
-                                auto& floatParam = std::get<FloatParameter>(param);
-                                floatParam.value = m_registry.settings().currentTime;
-                            }
-                        } 
-                        if (shaderConfig.params.contains("analog0")) {
-                            auto& param = shaderConfig.params["analog0"];
-                            if (std::holds_alternative<FloatParameter>(param)) {
-                                auto& floatParam = std::get<FloatParameter>(param);
-                                floatParam.value = m_registry.settings().analog0;
-                            }
-                        } 
-                        if (shaderConfig.params.contains("analog1")) {
-                            auto& param = shaderConfig.params["analog1"];
-                            if (std::holds_alternative<FloatParameter>(param)) {
-                                auto& floatParam = std::get<FloatParameter>(param);
-                                floatParam.value = m_registry.settings().analog1;
-                            }
-                        } 
-                        if (shaderConfig.params.contains("analog2")) {
-                            auto& param = shaderConfig.params["analog2"];
-                            if (std::holds_alternative<FloatParameter>(param)) {
-                                auto& floatParam = std::get<FloatParameter>(param);
-                                floatParam.value = m_registry.settings().analog2;
-                            }
-                        } 
-                        if (shaderConfig.params.contains("analog3")) {
-                            auto& param = shaderConfig.params["analog3"];
-                            if (std::holds_alternative<FloatParameter>(param)) {
-                                auto& floatParam = std::get<FloatParameter>(param);
-                                floatParam.value = m_registry.settings().analog3;
-                            }
-                        }
+                        const DrivenParamIndices& drivenParams = shaderConfig.drivenParams;
+                        shaderConfig.setFloat(drivenParams.analog[0], m_registry.settings().analog0);
+                        shaderConfig.setFloat(drivenParams.analog[1], m_registry.settings().analog1);
+                        shaderConfig.setFloat(drivenParams.analog[2], m_registry.settings().analog2);
+                        shaderConfig.setFloat(drivenParams.analog[3], m_registry.settings().analog3);
                         
                         shaderPlayer->setShaderUniforms(shaderConfig);
+                        shaderPlayer->setCurrentTime(m_registry.settings().currentTime);
+
+                        switch (shaderInputConfig->renderScale) {
+                            case ShaderInputConfig::RenderScale::RS_Half:
+                                shaderPlayer->setRenderScale(1.0f / 2.0f);
+                                break;
+                            case ShaderInputConfig::RenderScale::RS_Third:
+                                shaderPlayer->setRenderScale(1.0f / 3.0f);
+                                break;
+                            case ShaderInputConfig::RenderScale::RS_Auto:
+                                shaderPlayer->setRenderScale(ShaderPlayer::AUTO_RENDER_SCALE);
+                                break;
+                            default:
+                                shaderPlayer->setRenderScale(1.0f);
+                                break;
+                        }
+                        shaderInputConfig->currentRenderScale = shaderPlayer->renderScale();
                     } 
                 }
             }
@@ -519,14 +833,44 @@ void PlaybackOperator::update(float deltaTime)
         m_registry.inputMappings().removeConfig(id);
     }
 
+    // Players only need their RGB framebuffer pass when a plane showing them runs an effect.
+    // Effects sample colorAtUV() arbitrarily often, which is cheaper on the converted image.
+    // Only players a plane mixer shows hold a render target.
+    std::vector<bool> isRgbOutputRequired(m_mediaPlayers.size(), !m_registry.settings().useDirectPlaneSampling);
+    std::vector<bool> isShown(m_mediaPlayers.size(), false);
+    for (int planeId = 0; planeId < int(m_planeMixers.size()); ++planeId) {
+        for (int playerId : { m_planeMixers[planeId].fromId(), m_planeMixers[planeId].toId() }) {
+            if (playerId < 0) continue;
+            isShown[playerId] = true;
+            if (m_planeRenderers[planeId]->hasEffect()) isRgbOutputRequired[playerId] = true;
+        }
+    }
+
+    updateVisibility();
+    updatePreroll(activePlayerIds);
+
+    m_directPlayerCount = 0;
+    m_cullingStats.culledPlayers = 0;
     for (int i = 0; i < int(m_mediaPlayers.size()); ++i) {
         MediaPlayer* mediaPlayer = m_mediaPlayers[i];
-        if (std::find(activePlayerIds.begin(), activePlayerIds.end(), i) == activePlayerIds.end()) {
+        bool isPrerolled = i < int(m_prerolls.size()) && m_prerolls[i].mediaSlotId >= 0;
+        if (std::find(activePlayerIds.begin(), activePlayerIds.end(), i) == activePlayerIds.end() && !isPrerolled) {
             if (!dynamic_cast<WebcamPlayer*>(mediaPlayer)) {
                 mediaPlayer->close();
             }
         }
+        mediaPlayer->setRgbOutputRequired(isRgbOutputRequired[i]);
+        mediaPlayer->setRenderTargetWanted(isShown[i]);
+        mediaPlayer->setVisible(m_isPlayerVisible[i]);
+        if (mediaPlayer->isPlaying() && !m_isPlayerVisible[i]) {
+            m_cullingStats.culledPlayers++;
+            m_cullingStats.culledPlayerFrames++;
+        }
         mediaPlayer->update();
+        if (mediaPlayer->isPlaying() && mediaPlayer->isDirectOutput()) {
+            mediaPlayer->releaseRenderTarget();
+            m_directPlayerCount++;
+        }
     }
 
     for (int i = 0; i < PLANE_COUNT; i++) {
@@ -538,12 +882,8 @@ void PlaybackOperator::update(float deltaTime)
     updateDeviceController();
 }
 
-void PlaybackOperator::renderPlane(int hdmiId)
+std::vector<int> PlaybackOperator::activePlaneIds()
 {
-    if (!m_isInitialized) return;
-
-    const auto& planes = m_registry.planes();
-
     std::vector<int> activePlanesIds;
     std::vector<int> activeSlotIds = m_registry.inputMappings().activeSlotIds();
     for (int activeSlotId : activeSlotIds)
@@ -557,7 +897,84 @@ void PlaybackOperator::renderPlane(int hdmiId)
         }
     }
     std::sort(activePlanesIds.begin(), activePlanesIds.end(), [](int x, int y){return x < y;});
+    return activePlanesIds;
+}
+
+bool PlaybackOperator::isPlaneOpaque(int planeId)
+{
+    const PlaneSettings& planeSettings = m_registry.planes()[planeId];
+    if (planeSettings.blendMode != PlaneSettings::BlendMode::BM_Alpha) return false;
+    if (planeSettings.opacity < 1.0f) return false;
+    if (m_planeRenderers[planeId]->hasEffect()) return false;
+
+    const ShaderConfig& shaderConfig = planeSettings.shaderConfig;
+    int chromaKey = shaderConfig.indexOf("ChromaKey_Enable");
+    if (chromaKey >= 0 &&
+        shaderConfig.values[chromaKey].type == ShaderParamType::Int &&
+        shaderConfig.values[chromaKey].intValue != 0) {
+        return false;
+    }
+
+    // Video and webcam conversions always write alpha 1, generative shaders may not
+    auto isOpaquePlayer = [this](int playerId) {
+        if (playerId < 0) return false;
+        MediaPlayer* mediaPlayer = m_mediaPlayers[playerId];
+        return dynamic_cast<VideoPlayer*>(mediaPlayer) != nullptr || dynamic_cast<WebcamPlayer*>(mediaPlayer) != nullptr;
+    };
+
+    const PlaneMixer& planeMixer = m_planeMixers[planeId];
+    if (!isOpaquePlayer(planeMixer.fromId())) return false;
+    if (planeMixer.mixValue() > 0.0f && !isOpaquePlayer(planeMixer.toId())) return false;
+    return true;
+}
+
+void PlaybackOperator::updateVisibility()
+{
+    auto& planes = m_registry.planes();
+    std::vector<int> planeIds = activePlaneIds();
+
+    m_isPlaneVisible.assign(m_planeMixers.size(), false);
+    m_isPlayerVisible.assign(m_mediaPlayers.size(), false);
+    m_cullingStats.culledPlanes = 0;
+
+    // Planes are drawn in ascending order, so walk them top down and remember
+    // the outputs that are already covered by an opaque full screen plane
+    std::vector<int> coveredHdmiIds;
+    for (auto it = planeIds.rbegin(); it != planeIds.rend(); ++it) {
+        int planeId = *it;
+        const PlaneSettings& planeSettings = planes[planeId];
+        float opacity = planeSettings.useFaderForOpacity ? m_registry.settings().analog0 : planeSettings.opacity;
+        bool isCovered = std::find(coveredHdmiIds.begin(), coveredHdmiIds.end(), planeSettings.hdmiId) != coveredHdmiIds.end();
+        if (opacity <= 0.0f || isCovered) {
+            m_cullingStats.culledPlanes++;
+            m_cullingStats.culledPlaneDraws++;
+            continue;
+        }
+        m_isPlaneVisible[planeId] = true;
+
+        // A completed fade leaves one side with zero weight
+        const PlaneMixer& planeMixer = m_planeMixers[planeId];
+        int fromId = planeMixer.fromId();
+        int toId = planeMixer.toId();
+        if (fromId >= 0 && planeMixer.mixValue() < 1.0f) m_isPlayerVisible[fromId] = true;
+        if (toId >= 0 && planeMixer.mixValue() > 0.0f) m_isPlayerVisible[toId] = true;
+
+        if (isPlaneOpaque(planeId) && m_planeRenderers[planeId]->coversOutput(planeSettings, m_registry.settings().hdmiRotation0)) {
+            coveredHdmiIds.push_back(planeSettings.hdmiId);
+        }
+    }
+}
+
+void PlaybackOperator::renderPlane(int hdmiId)
+{
+    if (!m_isInitialized) return;
+
+    Uint64 startTime = SDL_GetTicksNS();
+    const auto& planes = m_registry.planes();
 
+    std::vector<int> activePlanesIds = activePlaneIds();
+    std::vector<int> drawnPlaneIds;
+    std::vector<PlaneRenderer::InternalShaderParams> drawnPlaneParams;
     for (size_t i = 0; i < activePlanesIds.size(); ++i) {
         int currentPlaneId = activePlanesIds[i];
         
@@ -565,11 +982,12 @@ void PlaybackOperator::renderPlane(int hdmiId)
             m_registry.planes()[currentPlaneId].opacity = m_registry.settings().analog0;    // todo: just for testing
         }
 
+        if (currentPlaneId < int(m_isPlaneVisible.size()) && !m_isPlaneVisible[currentPlaneId]) continue;
+
         if (hdmiId == planes[currentPlaneId].hdmiId) {
             if (i >= m_planeRenderers.size()) return;
             
             
-            PlaneRenderer* planeRenderer = m_planeRenderers[currentPlaneId];
             PlaneMixer& planeMixer = m_planeMixers[currentPlaneId];
             
             int fromId = planeMixer.fromId();
@@ -579,6 +997,7 @@ void PlaybackOperator::renderPlane(int hdmiId)
             float volume = float(m_registry.settings().volume) / 10.0f;
             if (fromId >= 0) {
                 internalShaderParams.texture0 = m_mediaPlayers[fromId]->texture();
+                internalShaderParams.source0 = m_mediaPlayers[fromId]->directSource();
                 internalShaderParams.isTex0Valid = true;
                 AudioStream* audioStream = m_audioStreams[fromId];
                 if (audioStream) audioStream->setVolume((1.0f - planeMixer.mixValue()) * volume);
@@ -586,6 +1005,7 @@ void PlaybackOperator::renderPlane(int hdmiId)
             }
             if (toId >= 0) {
                 internalShaderParams.texture1 = m_mediaPlayers[toId]->texture();
+                internalShaderParams.source1 = m_mediaPlayers[toId]->directSource();
                 internalShaderParams.isTex1Valid = true;
                 AudioStream* audioStream = m_audioStreams[toId];
                 if (audioStream) audioStream->setVolume(planeMixer.mixValue() * volume);
@@ -599,9 +1019,94 @@ void PlaybackOperator::renderPlane(int hdmiId)
             internalShaderParams.analog1 = m_registry.settings().analog1;
             internalShaderParams.analog2 = m_registry.settings().analog2;
             internalShaderParams.analog3 = m_registry.settings().analog3;
-            planeRenderer->update(m_registry.planes()[currentPlaneId], m_registry.settings().hdmiRotation0, internalShaderParams);
+            drawnPlaneIds.push_back(currentPlaneId);
+            drawnPlaneParams.push_back(internalShaderParams);
+        }
+    }
+
+    // Leading planes without effects are composited in one pass, starting with the first
+    // effect the remaining planes are drawn one by one on top of it
+    Settings& settings = m_registry.settings();
+    bool isSinglePass = settings.useSinglePassCompositor && m_planeCompositor.isInitialized();
+    size_t compositedCount = 0;
+    if (isSinglePass) {
+        while (compositedCount < drawnPlaneIds.size() && compositedCount < size_t(PlaneCompositor::MAX_PLANES) &&
+               !m_planeRenderers[drawnPlaneIds[compositedCount]]->hasEffect()) {
+            compositedCount++;
+        }
+    }
+
+    GpuTimer& planeTimer = m_planeTimers[isSinglePass ? 1 : 0];
+    if (settings.measureGpuTimes) planeTimer.begin();
+
+    if (compositedCount > 0) {
+        std::vector<PlaneCompositor::Layer> layers(compositedCount);
+        for (size_t i = 0; i < compositedCount; ++i) {
+            int planeId = drawnPlaneIds[i];
+            layers[i].planeSettings = &planes[planeId];
+            layers[i].quad.resize(4);
+            m_planeRenderers[planeId]->transformPlane(settings.hdmiRotation0, planes[planeId], layers[i].quad);
+            m_planeRenderers[planeId]->updateColorLut(planes[planeId]);
+            layers[i].colorLut = m_planeRenderers[planeId]->colorLutTexture();
+            layers[i].params = drawnPlaneParams[i];
         }
+        m_planeCompositor.render(layers);
+    }
+
+    for (size_t i = compositedCount; i < drawnPlaneIds.size(); ++i) {
+        int planeId = drawnPlaneIds[i];
+        m_planeRenderers[planeId]->update(m_registry.planes()[planeId], settings.hdmiRotation0, drawnPlaneParams[i]);
+    }
+
+    if (settings.measureGpuTimes) planeTimer.end();
+
+    // Summed over the outputs, the first output starts the frame
+    CompositorStats& compositorStats = m_planeCompositor.stats();
+    if (hdmiId == 0) {
+        compositorStats.compositedPlanes = 0;
+        compositorStats.fallbackPlanes = 0;
+    }
+    compositorStats.compositedPlanes += int(compositedCount);
+    if (isSinglePass) compositorStats.fallbackPlanes += int(drawnPlaneIds.size() - compositedCount);
+
+    updateTriggerLatencies();
+
+    // Hot reloaded programs reached the screen
+    if (!m_reloadsAwaitingFrame.empty()) {
+        Uint64 now = SDL_GetTicksNS();
+        for (const ShaderFileChange& change : m_reloadsAwaitingFrame) {
+            double latencyMs = double(now - change.changeTimeNs) / 1000000.0;
+            m_shaderReloadStats.reloads++;
+            m_shaderReloadStats.lastLatencyMs = latencyMs;
+            if (latencyMs > m_shaderReloadStats.maxLatencyMs) m_shaderReloadStats.maxLatencyMs = latencyMs;
+            SDL_Log("Shader hot reload: %s, %.1f ms from file write to first frame", change.path.c_str(), latencyMs);
+        }
+        m_reloadsAwaitingFrame.clear();
+    }
+
+    float cpuMs = float(SDL_GetTicksNS() - startTime) / 1000000.0f;
+    float& averageMs = m_renderPlaneCpuMs[Shader::isUniformCacheEnabled() ? 1 : 0];
+    averageMs = (averageMs == 0.0f) ? cpuMs : averageMs * 0.95f + cpuMs * 0.05f;
+}
+
+UniformBlockStats PlaybackOperator::uniformBlockStats() const
+{
+    UniformBlockStats stats;
+    for (const PlaneRenderer* planeRenderer : m_planeRenderers) {
+        stats.uploads += planeRenderer->uniformBlockStats().uploads;
+        stats.unchangedUpdates += planeRenderer->uniformBlockStats().unchangedUpdates;
+    }
+    return stats;
+}
+
+ColorLutStats PlaybackOperator::colorLutStats() const
+{
+    ColorLutStats stats;
+    for (const PlaneRenderer* planeRenderer : m_planeRenderers) {
+        stats.bakes += planeRenderer->colorLutStats().bakes;
+        stats.lastBakeMs = std::max(stats.lastBakeMs, planeRenderer->colorLutStats().lastBakeMs);
     }
+    return stats;
 }
 
 void PlaybackOperator::updateDeviceController()
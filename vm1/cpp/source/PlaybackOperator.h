@@ -9,9 +9,14 @@
 #pragma once
 
 #include "PlaneRenderer.h"
+#include "PlaneCompositor.h"
+#include "GpuTimer.h"
+#include "RenderTargetPool.h"
 #include "WebcamPlayer.h"
 #include "VideoPlayer.h"
 #include "ShaderPlayer.h"
+#include "ShaderCompiler.h"
+#include "ShaderWatcher.h"
 #include "AudioSystem.h"
 #include "DeviceController.h"
 #include "Registry.h"
@@ -116,6 +121,25 @@ private:
     int m_toId = -1;
 };
 
+// Players and planes that were skipped because nothing of them reaches an output
+struct CullingStats {
+    int culledPlayers = 0;          // this frame
+    int culledPlanes = 0;           // this frame
+    uint64_t culledPlayerFrames = 0;
+    uint64_t culledPlaneDraws = 0;
+};
+
+// Trigger to first frame of video slots. Warm triggers found their slot pre-rolled.
+struct PrerollStats {
+    int prerolledPlayers = 0;       // holding their first frame
+    uint64_t warmTriggers = 0;
+    uint64_t coldTriggers = 0;
+    double lastWarmMs = 0.0;
+    double lastColdMs = 0.0;
+    double averageWarmMs = 0.0;
+    double averageColdMs = 0.0;
+};
+
 class PlaybackOperator {
 public:
     PlaybackOperator(Registry& registry, EventBus& eventBus, DeviceController& deviceController);
@@ -126,15 +150,45 @@ public:
     void showMedia(int mediaId);
     void update(float deltaTime);
     void renderPlane(int hdmiId);
+    const std::vector<VideoPlayer*>& videoPlayers() const { return m_videoPlayers; }
+    const std::vector<ShaderPlayer*>& shaderPlayers() const { return m_shaderPlayers; }
+    int directPlayerCount() const { return m_directPlayerCount; }
+    const RenderTargetPool& renderTargetPool() const { return m_renderTargetPool; }
+    size_t mediaPlayerCount() const { return m_mediaPlayers.size(); }
+    const CullingStats& cullingStats() const { return m_cullingStats; }
+    const PrerollStats& prerollStats() const { return m_prerollStats; }
+    // Smoothed CPU time of one renderPlane() call with the uniform cache enabled or disabled
+    float renderPlaneCpuMs(bool isUniformCacheEnabled) const { return m_renderPlaneCpuMs[isUniformCacheEnabled ? 1 : 0]; }
+    UniformBlockStats uniformBlockStats() const;
+    ColorLutStats colorLutStats() const;
+    const ShaderCompiler& shaderCompiler() const { return m_shaderCompiler; }
+    const ShaderReloadStats& shaderReloadStats() const { return m_shaderReloadStats; }
+    const CompositorStats& compositorStats() const { return m_planeCompositor.stats(); }
+    // GPU time of drawing the planes of one output, plane by plane or with the compositor
+    const GpuTimer& planeTimer(bool isSinglePass) const { return m_planeTimers[isSinglePass ? 1 : 0]; }
     
 private:
 
     void subscribeToEvents();
     void reloadPlaneShader(int planeId);
+    // change is set for hot reloads, see ShaderWatcher
+    void requestPlaneShader(int planeId, const ShaderFileChange& change = {});
+    void reloadShaderPlayer(int mediaSlotId, int playerId, const ShaderFileChange& change);
+    void reloadChangedShaders();
+    void finishShaderReload(const ShaderFileChange& change, bool isLinked);
+    void showShader(int mediaSlotId, int playerId, const std::string& fileName, bool isChanged, const ShaderCompileResult& result);
+    void publishShaderError(const Shader& shader);
     bool getWebcamPlayerIdFromPort(int port, int& id);
     bool getFreeVideoPlayerId(int& id, int planeId);
+    bool getIdleVideoPlayerId(int& id);
+    bool getPrerolledVideoPlayerId(int& id, int mediaSlotId, const VideoInputConfig& videoInputConfig);
+    void updatePreroll(const std::vector<int>& activePlayerIds);
+    void updateTriggerLatencies();
     bool getFreeShaderPlayerId(int& id, int planeId);
     bool isPlayerIdActive(int playerId);
+    std::vector<int> activePlaneIds();
+    void updateVisibility();
+    bool isPlaneOpaque(int planeId);
     void updateDeviceController();
 
 private:
@@ -143,8 +197,19 @@ private:
     DeviceController& m_deviceController;
     
     AudioSystem m_audioSystem;
+    ShaderCompiler m_shaderCompiler;
+    // Latest compile request per plane and per shader player, older results are dropped
+    std::map<int, uint64_t> m_planeShaderRequests;
+    std::map<int, uint64_t> m_shaderPlayerRequests;
+    ShaderWatcher m_shaderWatcher;
+    bool m_isShaderWatcherEnabled = false;
+    std::vector<ShaderFileChange> m_reloadsAwaitingFrame;   // swapped in, not rendered yet
+    ShaderReloadStats m_shaderReloadStats;
+    RenderTargetPool m_renderTargetPool;
     std::vector<PlaneMixer> m_planeMixers;
     std::vector<PlaneRenderer*> m_planeRenderers;
+    PlaneCompositor m_planeCompositor;
+    GpuTimer m_planeTimers[2];
     std::vector<AudioStream*> m_audioStreams;
 
     std::vector<VideoPlayer*> m_videoPlayers;
@@ -154,8 +219,29 @@ private:
     //std::map<int, int> m_mediaSlotIdToPlayerId;
     std::vector<int> m_recentlyUsedPlayerIds;
 
+    // Idle video players holding the first frame of a slot on the focused bank
+    struct Preroll {
+        int mediaSlotId = -1;
+        std::string fileName;
+        double inPoint = 0.0;
+    };
+    struct Trigger {
+        int playerId = -1;
+        Uint64 timeNs = 0;
+        bool isWarm = false;
+    };
+    std::vector<Preroll> m_prerolls;                // per video player
+    std::map<int, std::string> m_failedPrerolls;    // slot -> file, not retried (also software decoded files)
+    std::vector<Trigger> m_triggersAwaitingFrame;
+    PrerollStats m_prerollStats;
+
     bool m_isInitialized = false;
     int m_selectedEditButton = -1;
     int m_selectedMediaButton = -1;
+    int m_directPlayerCount = 0;
+    std::vector<bool> m_isPlaneVisible;
+    std::vector<bool> m_isPlayerVisible;
+    CullingStats m_cullingStats;
+    float m_renderPlaneCpuMs[2] = {0.0f, 0.0f};
 
 };
\ No newline at end of file
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "ProgramBinaryCache.h"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+// FNV-1a, only used to name cache files
+static uint64_t hashBytes(uint64_t hash, const char* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= uint8_t(data[i]);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+ProgramBinaryCache& ProgramBinaryCache::instance()
+{
+    static ProgramBinaryCache s_instance;
+    return s_instance;
+}
+
+bool ProgramBinaryCache::isSupported()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_isSupported < 0) {
+        GLint formatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        m_isSupported = (formatCount > 0) ? 1 : 0;
+        if (!m_isSupported) SDL_Log("Program binaries are not supported by the driver, shaders are always compiled from source.");
+    }
+    return m_isSupported == 1;
+}
+
+const std::string& ProgramBinaryCache::driverString()
+{
+    if (m_driverString.empty()) {
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION}) {
+            const GLubyte* value = glGetString(name);
+            if (value) m_driverString += reinterpret_cast<const char*>(value);
+            m_driverString += '\n';
+        }
+    }
+    return m_driverString;
+}
+
+uint64_t ProgramBinaryCache::key(std::initializer_list<const std::string*> sources)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::string& driver = driverString();
+    uint64_t hash = hashBytes(0xcbf29ce484222325ull, driver.data(), driver.size());
+    for (const std::string* source : sources) {
+        hash = hashBytes(hash, source->data(), source->size());
+        // Separator, so moving code between the stages changes the key
+        hash = hashBytes(hash, "\0", 1);
+    }
+    return hash;
+}
+
+std::string ProgramBinaryCache::pathForKey(uint64_t key) const
+{
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.bin", (unsigned long long)key);
+    return (fs::path(m_directory) / fileName).string();
+}
+
+bool ProgramBinaryCache::load(GLuint program, uint64_t key)
+{
+    if (!isSupported()) return false;
+
+    std::string path = pathForKey(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    uint32_t magic = 0;
+    GLenum format = 0;
+    uint32_t length = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    file.read(reinterpret_cast<char*>(&length), sizeof(length));
+    if (!file || magic != FILE_MAGIC || length == 0) {
+        SDL_Log("Invalid program binary: %s", path.c_str());
+        return false;
+    }
+
+    std::vector<char> binary(length);
+    file.read(binary.data(), length);
+    if (!file) {
+        SDL_Log("Truncated program binary: %s", path.c_str());
+        return false;
+    }
+    file.close();
+
+    glProgramBinary(program, format, binary.data(), GLsizei(length));
+    GLint linkSucceeded = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linkSucceeded);
+    if (!linkSucceeded) {
+        // Stale binary (e.g. the driver changed without changing its strings), replace it on the next store
+        SDL_Log("Program binary was rejected by the driver: %s", path.c_str());
+        std::error_code error;
+        fs::remove(path, error);
+        return false;
+    }
+
+    // Marks the binary as used, pruning removes the least recently used ones
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    return true;
+}
+
+void ProgramBinaryCache::store(GLuint program, uint64_t key)
+{
+    if (!isSupported()) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei writtenLength = 0;
+    glGetProgramBinary(program, length, &writtenLength, &format, binary.data());
+    if (writtenLength <= 0) return;
+
+    std::error_code error;
+    fs::create_directories(m_directory, error);
+    if (error) {
+        SDL_Log("Couldn't create shader cache directory %s: %s", m_directory.c_str(), error.message().c_str());
+        return;
+    }
+
+    // Write to a temporary file first, a crash must not leave a truncated binary behind
+    std::string path = pathForKey(key);
+    std::string tempPath = path + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        SDL_Log("Couldn't write program binary: %s", tempPath.c_str());
+        return;
+    }
+
+    uint32_t magic = FILE_MAGIC;
+    uint32_t binaryLength = uint32_t(writtenLength);
+    file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+    file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+    file.write(reinterpret_cast<const char*>(&binaryLength), sizeof(binaryLength));
+    file.write(binary.data(), writtenLength);
+    file.close();
+    if (!file) {
+        fs::remove(tempPath, error);
+        return;
+    }
+
+    fs::rename(tempPath, path, error);
+    if (error) {
+        SDL_Log("Couldn't store program binary %s: %s", path.c_str(), error.message().c_str());
+        fs::remove(tempPath, error);
+        return;
+    }
+
+    pruneBinaries();
+}
+
+void ProgramBinaryCache::pruneBinaries()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    struct Binary {
+        fs::path path;
+        fs::file_time_type lastUsed;
+    };
+    std::vector<Binary> binaries;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(m_directory, error)) {
+        if (entry.path().extension() != ".bin") continue;
+        binaries.push_back({entry.path(), entry.last_write_time(error)});
+    }
+    if (binaries.size() <= MAX_BINARIES) return;
+
+    std::sort(binaries.begin(), binaries.end(), [](const Binary& a, const Binary& b) {
+        return a.lastUsed < b.lastUsed;
+    });
+    size_t removeCount = binaries.size() - MAX_BINARIES;
+    for (size_t i = 0; i < removeCount; ++i) {
+        fs::remove(binaries[i].path, error);
+    }
+    SDL_Log("Removed %zu unused program binaries from %s", removeCount, m_directory.c_str());
+}
+
+void ProgramBinaryCache::addRecord(const std::string& name, double ms, bool isCacheHit)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_records.push_back({name, ms, isCacheHit});
+    if (m_records.size() > MAX_RECORDS) m_records.pop_front();
+}
+
+std::vector<ProgramLoadRecord> ProgramBinaryCache::records() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::vector<ProgramLoadRecord>(m_records.begin(), m_records.end());
+}
+
+void ProgramBinaryCache::logReport() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double hitMs = 0.0;
+    double compileMs = 0.0;
+    int hits = 0;
+    for (const auto& record : m_records) {
+        SDL_Log("  %-8s %8.2f ms  %s", record.isCacheHit ? "cached" : "compiled", record.ms, record.name.c_str());
+        if (record.isCacheHit) {
+            hitMs += record.ms;
+            hits++;
+        }
+        else {
+            compileMs += record.ms;
+        }
+    }
+    SDL_Log("Shader programs: %d from cache (%.2f ms), %d compiled (%.2f ms)",
+            hits, hitMs, int(m_records.size()) - hits, compileMs);
+}
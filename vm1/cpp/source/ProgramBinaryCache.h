@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// How one program got loaded, for the startup report
+struct ProgramLoadRecord {
+    std::string name;
+    double ms = 0.0;
+    bool isCacheHit = false;
+};
+
+// On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary).
+// Binaries are keyed by a hash of the final shader sources and the driver strings,
+// so a driver update or a changed shader simply misses and recompiles from source.
+// Binaries that weren't used for longest are removed once there are more than
+// MAX_BINARIES, so edited shaders don't pile up.
+// Thread safe, programs are also loaded by the background ShaderCompiler.
+class ProgramBinaryCache
+{
+public:
+    static ProgramBinaryCache& instance();
+
+    ProgramBinaryCache(const ProgramBinaryCache&) = delete;
+    ProgramBinaryCache& operator=(const ProgramBinaryCache&) = delete;
+
+public:
+    void setDirectory(const std::string& directory) { m_directory = directory; }
+    bool isSupported();
+
+    uint64_t key(std::initializer_list<const std::string*> sources);
+    // Loads a cached binary into the program, false when there is none or the driver rejects it
+    bool load(GLuint program, uint64_t key);
+    // Must be called on a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+    void store(GLuint program, uint64_t key);
+
+    // Keeps the last MAX_RECORDS loads, hot reloading adds one per edit
+    void addRecord(const std::string& name, double ms, bool isCacheHit);
+    std::vector<ProgramLoadRecord> records() const;
+    void logReport() const;
+
+private:
+    ProgramBinaryCache() = default;
+
+    std::string pathForKey(uint64_t key) const;
+    const std::string& driverString();
+    void pruneBinaries();
+
+private:
+    static constexpr uint32_t FILE_MAGIC = 0x50314d56; // "VM1P"
+    static constexpr size_t MAX_BINARIES = 128;
+    static constexpr size_t MAX_RECORDS = 256;
+
+    mutable std::mutex m_mutex;
+    std::string m_directory = "shader-cache";
+    std::string m_driverString;
+    int m_isSupported = -1;
+    std::deque<ProgramLoadRecord> m_records;
+};
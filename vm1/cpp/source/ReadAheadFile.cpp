@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "ReadAheadFile.h"
+
+extern "C"
+{
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+ReadAheadFile::~ReadAheadFile()
+{
+    close();
+}
+
+bool ReadAheadFile::open(const std::string& fileName)
+{
+    close();
+
+    int fd = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    uint8_t* buffer = static_cast<uint8_t*>(av_malloc(IO_BUFFER_SIZE));
+    m_ioContext = buffer ? avio_alloc_context(buffer, IO_BUFFER_SIZE, 0, this, &ReadAheadFile::read, nullptr, &ReadAheadFile::seek) : nullptr;
+    if (!m_ioContext) {
+        av_free(buffer);
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_size = int64_t(fileStat.st_size);
+    m_position = 0;
+    for (Chunk& chunk : m_chunks) {
+        chunk.data.resize(CHUNK_SIZE);
+        chunk.start = -1;
+        chunk.length = 0;
+    }
+    m_lastChunk = 0;
+    m_stats.chunkReads = 0;
+    m_stats.bytesRead = 0;
+    m_stats.slowestReadMs = 0.0;
+
+    // Doubles the kernel's own read-ahead window for this file
+    posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return true;
+}
+
+void ReadAheadFile::close()
+{
+    if (m_ioContext) {
+        av_freep(&m_ioContext->buffer);
+        avio_context_free(&m_ioContext);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+    m_position = 0;
+    for (Chunk& chunk : m_chunks) {
+        chunk.start = -1;
+        chunk.length = 0;
+    }
+}
+
+int ReadAheadFile::chunkAt(int64_t position)
+{
+    for (int i = 0; i < 2; ++i) {
+        const Chunk& chunk = m_chunks[i];
+        if (chunk.start >= 0 && position >= chunk.start && position < chunk.start + int64_t(chunk.length)) {
+            m_lastChunk = i;
+            return i;
+        }
+    }
+
+    int index = 1 - m_lastChunk;
+    if (!loadChunk(index, position)) return -1;
+    m_lastChunk = index;
+    return index;
+}
+
+bool ReadAheadFile::loadChunk(int index, int64_t position)
+{
+    Chunk& chunk = m_chunks[index];
+    auto start = Clock::now();
+    int64_t chunkStart = position - (position % int64_t(CHUNK_SIZE));
+    size_t length = size_t(std::min<int64_t>(int64_t(CHUNK_SIZE), m_size - chunkStart));
+
+    if (m_throttle.latency.count() > 0) {
+        std::this_thread::sleep_for(m_throttle.latency);
+    }
+    if (m_throttle.bytesPerSecond > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(length * 1000000 / m_throttle.bytesPerSecond));
+    }
+
+    size_t done = 0;
+    while (done < length) {
+        ssize_t result = pread(m_fd, chunk.data.data() + done, length - done, chunkStart + int64_t(done));
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) break;
+        done += size_t(result);
+    }
+    if (done == 0) return false;
+
+    chunk.start = chunkStart;
+    chunk.length = done;
+
+    // The next chunks are read by the kernel while this one is demuxed
+    int64_t nextChunk = chunkStart + int64_t(CHUNK_SIZE);
+    if (nextChunk < m_size) {
+        posix_fadvise(m_fd, nextChunk, off_t(CHUNK_SIZE) * READ_AHEAD_CHUNKS, POSIX_FADV_WILLNEED);
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    m_stats.chunkReads++;
+    m_stats.bytesRead += done;
+    if (ms > m_stats.slowestReadMs) m_stats.slowestReadMs = ms;
+    return true;
+}
+
+int ReadAheadFile::read(void* opaque, uint8_t* buffer, int size)
+{
+    ReadAheadFile* file = static_cast<ReadAheadFile*>(opaque);
+    if (file->m_position >= file->m_size) return AVERROR_EOF;
+
+    int index = file->chunkAt(file->m_position);
+    if (index < 0) return AVERROR(EIO);
+
+    const Chunk& chunk = file->m_chunks[index];
+    size_t offset = size_t(file->m_position - chunk.start);
+    size_t length = std::min(size_t(size), chunk.length - offset);
+    std::memcpy(buffer, chunk.data.data() + offset, length);
+    file->m_position += int64_t(length);
+    return int(length);
+}
+
+int64_t ReadAheadFile::seek(void* opaque, int64_t offset, int whence)
+{
+    ReadAheadFile* file = static_cast<ReadAheadFile*>(opaque);
+    switch (whence & ~AVSEEK_FORCE) {
+        case AVSEEK_SIZE:
+            return file->m_size;
+        case SEEK_SET:
+            break;
+        case SEEK_CUR:
+            offset += file->m_position;
+            break;
+        case SEEK_END:
+            offset += file->m_size;
+            break;
+        default:
+            return AVERROR(EINVAL);
+    }
+    if (offset < 0) return AVERROR(EINVAL);
+
+    // The chunks stay, seeks within them (e.g. while probing) don't touch the storage
+    file->m_position = offset;
+    return offset;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include <libavformat/avio.h>
+}
+
+// Artificial slowness of the storage, for tests only
+struct ReadThrottle {
+    std::chrono::microseconds latency{ 0 };    // per chunk read
+    uint64_t bytesPerSecond = 0;               // 0 = unlimited
+};
+
+struct ReadAheadStats {
+    std::atomic<uint64_t> chunkReads = 0;
+    std::atomic<uint64_t> bytesRead = 0;
+    std::atomic<double> slowestReadMs = 0.0;
+};
+
+// File input for libavformat (see DemuxThread) that reads large aligned chunks
+// instead of the small reads of the default AVIOContext, and tells the kernel
+// which chunks come next, so several players on one SD card or USB stick don't
+// turn into random reads. The last two chunks stay in memory, so a demuxer
+// alternating between two places (probing, audio interleaved far from the
+// video) doesn't read a chunk again on every switch.
+class ReadAheadFile
+{
+public:
+    static constexpr size_t CHUNK_SIZE = 1024 * 1024;
+    static constexpr int READ_AHEAD_CHUNKS = 4;
+    static constexpr int IO_BUFFER_SIZE = 64 * 1024;
+
+    ReadAheadFile() = default;
+    ~ReadAheadFile();
+
+    ReadAheadFile(const ReadAheadFile&) = delete;
+    ReadAheadFile& operator=(const ReadAheadFile&) = delete;
+
+public:
+    // Regular files only, false for anything else (e.g. stream URLs)
+    bool open(const std::string& fileName);
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+
+    // Owned by the file, set as pb of a format context opened with AVFMT_FLAG_CUSTOM_IO
+    AVIOContext* ioContext() const { return m_ioContext; }
+
+    void setThrottle(const ReadThrottle& throttle) { m_throttle = throttle; }
+    const ReadAheadStats& stats() const { return m_stats; }
+
+private:
+    static int read(void* opaque, uint8_t* buffer, int size);
+    static int64_t seek(void* opaque, int64_t offset, int whence);
+    // Returns the chunk holding position, loads it into the older one if neither does
+    int chunkAt(int64_t position);
+    bool loadChunk(int index, int64_t position);
+
+private:
+    int m_fd = -1;
+    int64_t m_size = 0;
+    int64_t m_position = 0;
+    struct Chunk {
+        std::vector<uint8_t> data;
+        int64_t start = -1;
+        size_t length = 0;
+    };
+    Chunk m_chunks[2];
+    int m_lastChunk = 0;    // the other one is replaced first
+    AVIOContext* m_ioContext = nullptr;
+    ReadThrottle m_throttle;
+    ReadAheadStats m_stats;
+};
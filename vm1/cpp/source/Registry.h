@@ -17,6 +17,7 @@
 #include <functional>
 #include <sstream>
 #include <algorithm> 
+#include <type_traits>
 
 #include <glm/vec2.hpp>
 
@@ -38,6 +39,25 @@
 #include "NetworkTools.h"
 #include "CaptureType.h"
 
+// For fields added after registry files were saved: JSONInputArchive throws when
+// a name is missing, this keeps the default instead and returns false.
+template <class Archive, class T>
+bool serializeOptional(Archive& ar, const char* name, T& value)
+{
+    if constexpr (std::is_same_v<Archive, cereal::JSONInputArchive>) {
+        try {
+            ar(cereal::make_nvp(name, value));
+        }
+        catch (const cereal::Exception&) {
+            return false;
+        }
+    }
+    else {
+        ar(cereal::make_nvp(name, value));
+    }
+    return true;
+}
+
 class InputConfig
 {
 public:
@@ -126,8 +146,20 @@ public:
         return std::make_unique<ShaderInputConfig>(*this);
     }
 
+    enum RenderScale {
+        RS_Full,
+        RS_Half,
+        RS_Third,
+        RS_Auto     // picked from the measured GPU time
+    };
+
+    // saved
     std::string fileName;
     ShaderConfig shaderConfig;
+    RenderScale renderScale = RS_Full;
+
+    // volatile
+    float currentRenderScale = 1.0f;    // fraction of the output resolution the shader renders at
 
     template <class Archive>
     void serialize(Archive& ar)
@@ -137,6 +169,7 @@ public:
             CEREAL_NVP(fileName),
             CEREAL_NVP(shaderConfig)
         );
+        serializeOptional(ar, "renderScale", renderScale);
     }
 };
 
@@ -334,7 +367,8 @@ struct PlaneSettings
     float opacity = 1.0f;
     bool useFaderForOpacity = false;
     ShaderConfig shaderConfig;
-    std::string extShaderFilename;
+    std::vector<std::string> effectChain;  // effect shaders in call order, fused into one program
+    std::string colorLutFilename;           // .cube file applied after the color correction, empty for none
 
     // Mapping
     std::vector<glm::vec2> coords = { glm::vec2(-1.0f, -1.0f),   // bottom left
@@ -355,13 +389,20 @@ struct PlaneSettings
             CEREAL_NVP(blendMode),
             CEREAL_NVP(opacity),
             CEREAL_NVP(shaderConfig),
-            CEREAL_NVP(extShaderFilename),
             CEREAL_NVP(coords),
             // CEREAL_NVP(rotation),
             CEREAL_NVP(scale),
             // CEREAL_NVP(scaleXY),
             CEREAL_NVP(translation)
         );
+        if (!serializeOptional(ar, "effectChain", effectChain)) {
+            // Files from before effect chains name a single effect
+            std::string extShaderFilename;
+            if (serializeOptional(ar, "extShaderFilename", extShaderFilename) && !extShaderFilename.empty()) {
+                effectChain = { extShaderFilename };
+            }
+        }
+        serializeOptional(ar, "colorLutFilename", colorLutFilename);
     }
 };
 
@@ -395,11 +436,22 @@ struct Settings
     bool useRotaryAsFader = false;
     ScreenRotation hdmiRotation0 = ScreenRotation::SR_Rotate_0;
     ScreenRotation hdmiRotation1 = ScreenRotation::SR_Rotate_0;
+    int prerollSlots = 2;   // video slots of the focused bank kept opened at their first frame
+    int loopCacheMegabytes = 256;   // GPU memory for the decoded frames of short loops, all players together
 
     // Volatile
     bool isProVersion = true;
     bool isHdmiOutputReady = false;
     bool isHdmiInputReady = false;
+    bool useSinglePassVideoConversion = true;
+    bool measureGpuTimes = false;
+    bool useDirectPlaneSampling = false;
+    bool useUniformCache = true;
+    bool useShaderHotReload = true;
+    bool useSinglePassCompositor = false;
+    int softwareDecodeThreads = 2;  // decoder threads all software decoded clips share
+    bool useKeyframeIndex = true;   // seek with the ".keyframes" sidecars of the clips
+    bool useLoopCache = true;
 
     //std::string captureDevicePath = "";
     std::vector<std::string> hdmiOutputs = std::vector<std::string>(2, std::string());
@@ -436,6 +488,8 @@ struct Settings
             CEREAL_NVP(showUI),
             CEREAL_NVP(isProVersion)
         );
+        serializeOptional(ar, "prerollSlots", prerollSlots);
+        serializeOptional(ar, "loopCacheMegabytes", loopCacheMegabytes);
     }
 };
 
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "RenderTargetPool.h"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+
+RenderTargetPool::~RenderTargetPool()
+{
+    clear();
+}
+
+RenderTarget* RenderTargetPool::acquire(int width, int height)
+{
+    RenderTarget* renderTarget = nullptr;
+
+    auto it = std::find_if(m_freeTargets.begin(), m_freeTargets.end(), [&](const RenderTarget* target) {
+        return target->width == width && target->height == height;
+    });
+    if (it != m_freeTargets.end()) {
+        renderTarget = *it;
+        m_freeTargets.erase(it);
+    }
+    else {
+        renderTarget = new RenderTarget();
+        if (!createTarget(*renderTarget, width, height)) {
+            delete renderTarget;
+            return nullptr;
+        }
+    }
+
+    m_leasedTargets.push_back(renderTarget);
+    m_stats.leasedCount = m_leasedTargets.size();
+    m_stats.leasedBytes += bytesPerTarget(width, height);
+    m_stats.peakLeasedBytes = std::max(m_stats.peakLeasedBytes, m_stats.leasedBytes);
+    return renderTarget;
+}
+
+void RenderTargetPool::release(RenderTarget* renderTarget)
+{
+    auto it = std::find(m_leasedTargets.begin(), m_leasedTargets.end(), renderTarget);
+    if (it == m_leasedTargets.end()) return;
+
+    m_leasedTargets.erase(it);
+    m_stats.leasedCount = m_leasedTargets.size();
+    m_stats.leasedBytes -= bytesPerTarget(renderTarget->width, renderTarget->height);
+
+    if (m_freeTargets.size() < MAX_FREE_TARGETS) {
+        m_freeTargets.push_back(renderTarget);
+        return;
+    }
+
+    destroyTarget(*renderTarget);
+    delete renderTarget;
+}
+
+void RenderTargetPool::clear()
+{
+    for (auto renderTarget : m_leasedTargets) {
+        destroyTarget(*renderTarget);
+        delete renderTarget;
+    }
+    m_leasedTargets.clear();
+
+    for (auto renderTarget : m_freeTargets) {
+        destroyTarget(*renderTarget);
+        delete renderTarget;
+    }
+    m_freeTargets.clear();
+
+    m_stats.leasedCount = 0;
+    m_stats.leasedBytes = 0;
+}
+
+bool RenderTargetPool::createTarget(RenderTarget& renderTarget, int width, int height)
+{
+    renderTarget.width = width;
+    renderTarget.height = height;
+
+    glGenFramebuffers(1, &renderTarget.frameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, renderTarget.frameBuffer);
+
+    glGenTextures(1, &renderTarget.texture);
+    glBindTexture(GL_TEXTURE_2D, renderTarget.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); 
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, renderTarget.texture, 0);
+
+    m_stats.targetCount++;
+    m_stats.residentBytes += bytesPerTarget(width, height);
+    m_stats.peakResidentBytes = std::max(m_stats.peakResidentBytes, m_stats.residentBytes);
+
+    bool isComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (!isComplete) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Render target %dx%d is not complete", width, height);
+        destroyTarget(renderTarget);
+        return false;
+    }
+    return true;
+}
+
+void RenderTargetPool::destroyTarget(RenderTarget& renderTarget)
+{
+    if (renderTarget.frameBuffer) {
+        glDeleteFramebuffers(1, &renderTarget.frameBuffer);
+        renderTarget.frameBuffer = 0;
+    }
+    if (renderTarget.texture) {
+        glDeleteTextures(1, &renderTarget.texture);
+        renderTarget.texture = 0;
+
+        m_stats.targetCount--;
+        m_stats.residentBytes -= bytesPerTarget(renderTarget.width, renderTarget.height);
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <cstddef>
+#include <vector>
+
+// RGBA8 color texture with its framebuffer
+struct RenderTarget {
+    GLuint frameBuffer = 0;
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+};
+
+struct RenderTargetPoolStats {
+    size_t targetCount = 0;
+    size_t leasedCount = 0;
+    size_t residentBytes = 0;
+    size_t peakResidentBytes = 0;
+    size_t leasedBytes = 0;
+    size_t peakLeasedBytes = 0;
+};
+
+// Hands out render targets to the players that are currently shown and takes them back
+// when they are not. A few released targets are kept around so crossfades between
+// players don't reallocate, the rest is deleted right away.
+class RenderTargetPool
+{
+public:
+    RenderTargetPool() = default;
+    ~RenderTargetPool();
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+public:
+    RenderTarget* acquire(int width, int height);
+    void release(RenderTarget* renderTarget);
+    void clear();
+
+    const RenderTargetPoolStats& stats() const { return m_stats; }
+    static size_t bytesPerTarget(int width, int height) { return size_t(width) * size_t(height) * 4; }
+
+private:
+    bool createTarget(RenderTarget& renderTarget, int width, int height);
+    void destroyTarget(RenderTarget& renderTarget);
+
+private:
+    static constexpr size_t MAX_FREE_TARGETS = 2;
+
+    std::vector<RenderTarget*> m_leasedTargets;
+    std::vector<RenderTarget*> m_freeTargets;
+    RenderTargetPoolStats m_stats;
+};
@@ -7,15 +7,22 @@
  */
 
 #include "Shader.h"
+#include "EffectChain.h"
+#include "ProgramBinaryCache.h"
 #include "StringHelper.h"
+#include "UniformAnnotationParser.h"
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <iostream>
-#include <regex>
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL.h>
@@ -26,6 +33,9 @@
 
 using json = nlohmann::json;
 
+bool Shader::s_isUniformCacheEnabled = true;
+uint32_t Shader::s_cacheGeneration = 1;
+
 Shader::Shader()
 {
 	
@@ -92,13 +102,66 @@ void fetchVec2ParameterFromJson(const std::string& name, Vec2Parameter& param, c
 	}
 }
 
-void Shader::parseUnifromJson(const std::string& uniformName, const std::string& uniformType, const std::string& uniformJson)
+// Annotation with its JSON already parsed
+struct ParsedUniformAnnotation {
+	std::string type;
+	std::string name;
+	json data;
+};
+
+using ParsedUniformAnnotations = std::vector<ParsedUniformAnnotation>;
+
+// Sources are scanned and their annotations parsed once, reloads and every
+// further plane with the same effect reuse the result. The cache keeps the
+// sources it was filled from, a hash collision must not hand out foreign
+// annotations, and drops the oldest entry once it is full.
+static std::shared_ptr<const ParsedUniformAnnotations> parseUniformAnnotations(const std::string& source)
+{
+	static constexpr size_t MAX_CACHED_SOURCES = 64;
+
+	struct CacheEntry {
+		size_t hash = 0;
+		std::string source;
+		std::shared_ptr<const ParsedUniformAnnotations> annotations;
+	};
+	static std::mutex s_mutex;
+	static std::deque<CacheEntry> s_cache;
+
+	size_t sourceHash = std::hash<std::string>{}(source);
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		for (const CacheEntry& entry : s_cache) {
+			if (entry.hash == sourceHash && entry.source == source) return entry.annotations;
+		}
+	}
+
+	std::vector<UniformAnnotation> annotations;
+	scanUniformAnnotations(source, annotations);
+
+	auto parsedAnnotations = std::make_shared<ParsedUniformAnnotations>();
+	parsedAnnotations->reserve(annotations.size());
+	for (const UniformAnnotation& annotation : annotations) {
+		json data = json::parse(annotation.json.begin(), annotation.json.end(), nullptr, false);
+		if (data.is_discarded()) {
+			SDL_Log("Ignoring malformed annotation of uniform %.*s", int(annotation.name.size()), annotation.name.data());
+			continue;
+		}
+		parsedAnnotations->push_back({std::string(annotation.type), std::string(annotation.name), std::move(data)});
+	}
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (s_cache.size() >= MAX_CACHED_SOURCES) s_cache.pop_front();
+	s_cache.push_back({sourceHash, source, parsedAnnotations});
+	return parsedAnnotations;
+}
+
+void Shader::parseUnifromJson(const std::string& uniformName, const std::string& uniformType, const json& jsonData)
 {
-	if (!m_shaderConfig.params.contains(uniformName)) return;
+	int paramIndex = m_shaderConfig.indexOf(uniformName);
+	if (paramIndex < 0) return;
 
 	static const std::vector<std::string> valueNames = {"name", "default", "min", "max", "step"};
 
-	json jsonData = json::parse(uniformJson);
 	if (jsonData.contains("group")) {
 		const json& value = jsonData["group"];
 		if (value.is_string()) {
@@ -111,7 +174,7 @@ void Shader::parseUnifromJson(const std::string& uniformName, const std::string&
 	}
 
 	if (uniformType == "int") {
-		auto& param = m_shaderConfig.params[uniformName];
+		auto& param = m_shaderConfig.params[paramIndex];
 		if (std::holds_alternative<IntParameter>(param)) {
 			IntParameter& intParam = std::get<IntParameter>(param);
 			for (const auto& valueName : valueNames) {
@@ -123,7 +186,7 @@ void Shader::parseUnifromJson(const std::string& uniformName, const std::string&
 		// TODO: implement UIntParameter
 	}
 	else if (uniformType == "float") {
-		auto& param = m_shaderConfig.params[uniformName];
+		auto& param = m_shaderConfig.params[paramIndex];
 		if (std::holds_alternative<FloatParameter>(param)) {
 			FloatParameter& floatParam = std::get<FloatParameter>(param);
 			for (const auto& valueName : valueNames) {
@@ -132,7 +195,7 @@ void Shader::parseUnifromJson(const std::string& uniformName, const std::string&
 		}
 	}
 	else if (uniformType == "vec2") {
-		auto& param = m_shaderConfig.params[uniformName];
+		auto& param = m_shaderConfig.params[paramIndex];
 		if (std::holds_alternative<Vec2Parameter>(param)) {
 			Vec2Parameter& vec2Param = std::get<Vec2Parameter>(param);  
 			for (const auto& valueName : valueNames) {
@@ -144,55 +207,11 @@ void Shader::parseUnifromJson(const std::string& uniformName, const std::string&
 
 void Shader::extractUniformMetadata() 
 {
-	static std::regex uniform_regex(R"(^\s*uniform\s+(\w+)\s+(\w+)\s*;\s*//\s*(\{.*\}))", std::regex::multiline);
-
-	std::sregex_iterator next(m_shaderSrc.begin(), m_shaderSrc.end(), uniform_regex);
-  	std::sregex_iterator end;
-
-	//try {
-		while (next != end) {
-			std::smatch match = *next;
-			if (match.size() >= 3) {
-				std::string uniformType = match[1].str();
-				std::string uniformName = match[2].str();
-				std::string uniformJson = match[3].str();
-				//printf("Uniform: %s, Type: %s, JSON: %s\n", uniformName.c_str(), uniformType.c_str(), uniformJson.c_str());
-				parseUnifromJson(uniformName, uniformType, uniformJson);
-				next++;
-			}
-		}
-	//} 
-	// catch (std::regex_error& e) {
-  	// 	// Syntax error in the regular expression
-	// }
-
-	// for (auto& kv : m_shaderConfig.params) {
-	// 	auto& param = kv.second;
-	// 	if (std::holds_alternative<IntParameter>(param)) {
-	// 		auto& intParam = std::get<IntParameter>(param);  
-	// 		printf("Int -> Name: %s, Value: %d, Min: %d, Max: %d, Step: %d\n", intParam.name.c_str(), intParam.value, intParam.min, intParam.max, intParam.step);
-	// 	} 
-	// 	else if (std::holds_alternative<FloatParameter>(param)) {
-	// 		auto& floatParam = std::get<FloatParameter>(param); 
-	// 		printf("Float -> Name: %s, Value: %f, Min: %f, Max: %f, Step: %f\n", floatParam.name.c_str(), floatParam.value, floatParam.min, floatParam.max, floatParam.step);
-	// 	}
-	// 	else if (std::holds_alternative<Vec2Parameter>(param)) {
-	// 		auto& vec2Param = std::get<Vec2Parameter>(param); 
-	// 		printf("Vec2 -> Name: %s, Value: %f, %f, Min: %f, %f, Max: %f, %f, Step: %f, %f\n", vec2Param.name.c_str(), vec2Param.value.x, vec2Param.value.y, vec2Param.min.x, vec2Param.min.y, vec2Param.max.x, vec2Param.max.y, vec2Param.step.x, vec2Param.step.y);
-	// 	}
-
-	// }
-
-	//auto begin = shaderCode.cbegin();
-    //auto end = shaderCode.cend();
-    // while (std::regex_search(begin, end, matches, uniform_regex)) {
-	// 	if (matches.size() >= 3) {
-    //     	std::string uniformName = matches[1].str();
-    //     	std::string uniformJson = matches[2].str();
-	// 		//printf("Uniform: %s, JSON: %s\n", uniformName.c_str(), uniformJson.c_str());
-	// 	}
-    //     begin = matches.suffix().first;
-    // }
+	// Plain uniforms and members of uniform blocks (without the "uniform" keyword)
+	std::shared_ptr<const ParsedUniformAnnotations> annotations = parseUniformAnnotations(m_shaderSrc);
+	for (const ParsedUniformAnnotation& annotation : *annotations) {
+		parseUnifromJson(annotation.name, annotation.type, annotation.data);
+	}
 }
 
 void Shader::createShaderConfigFromUniforms()
@@ -210,18 +229,20 @@ void Shader::createShaderConfigFromUniforms()
 			SDL_Log("Uniforms of size > 0 (arrays/structs) are not supported.\n");
 			continue;
 		}
+		// Set by the players every frame, not a parameter of the shader
+		if (strcmp(name, "iResolution") == 0 || strcmp(name, "iTime") == 0) continue;
 
 		switch (type) {
 			case GL_FLOAT:
-				m_shaderConfig.params[name] = FloatParameter(std::string(name), 0.0f);
+				m_shaderConfig.setParam(name, FloatParameter(std::string(name), 0.0f));
 				//printf("Name: %s Type: Float\n", name);
 				break;
 			case GL_FLOAT_VEC2:
-				m_shaderConfig.params[name] = Vec2Parameter(std::string(name), glm::vec2(0.0f, 0.0f));
+				m_shaderConfig.setParam(name, Vec2Parameter(std::string(name), glm::vec2(0.0f, 0.0f)));
 				//printf("Name: %s Type: Vec2\n", name);
 				break;
 			case GL_INT:
-				m_shaderConfig.params[name] = IntParameter(std::string(name), 0);
+				m_shaderConfig.setParam(name, IntParameter(std::string(name), 0));
 				//printf("Name: %s Type: Int\n", name);
 				break;
 			//default:
@@ -243,12 +264,14 @@ bool Shader::link()
 	if (!linkingSucceeded) {
 		//SDL_Log("Linking shader failed (vert. shader: %s, frag. shader: %s\n", vertFilename, fragFilename);
 		SDL_Log("Linking shader failed!");
+		m_errorLog = "Linking failed";
 		GLint logLength = 0;
 		glGetProgramiv(m_shaderProgram, GL_INFO_LOG_LENGTH, &logLength);
 		GLchar *errLog = (GLchar*)malloc(logLength);
 		if(errLog) {
 			glGetProgramInfoLog(m_shaderProgram, logLength, &logLength, errLog);
 			SDL_Log("%s\n", errLog);
+			m_errorLog = errLog;
 			free(errLog);
 		}
 		else {
@@ -262,108 +285,174 @@ bool Shader::link()
 	return true;
 }
 
-bool Shader::load(const std::string& vertFilename, const std::string& fragFilename, const std::string& extFilename) 
+bool Shader::load(const std::string& vertFilename, const std::string& fragFilename, const std::vector<std::string>& effectChain) 
 {
-	if (!strhlpr::isFile(vertFilename) || !strhlpr::isFile(fragFilename)) return false;
-	
-	if (!extFilename.empty() && !strhlpr::isFile(extFilename)) return false;
-
-	GLuint vertShader = loadShaderByType(vertFilename, GL_VERTEX_SHADER);
-	if(!vertShader) {
-		SDL_Log("Couldn't load vertex shader: %s\n", vertFilename.c_str());
-		return false;
+	m_errorLog.clear();
+	std::vector<const std::string*> filenames = {&vertFilename, &fragFilename};
+	for (const std::string& filename : effectChain) filenames.push_back(&filename);
+	for (const std::string* filename : filenames) {
+		if (!filename->empty() && !strhlpr::isFile(*filename)) {
+			m_errorLog = "File not found: " + *filename;
+			return false;
+		}
 	}
-	
-	GLuint fragShader = loadShaderByType(fragFilename, GL_FRAGMENT_SHADER, extFilename);
-	if(!fragShader) {
-		SDL_Log("Couldn't load fragent shader: %s\n", fragFilename.c_str());
+	if (vertFilename.empty() || fragFilename.empty()) return false;
+
+	Uint64 startTime = SDL_GetTicksNS();
+
+	std::string vertSrc;
+	std::string fragSrc;
+	if (!readShaderSource(vertFilename, {}, vertSrc) || !readShaderSource(fragFilename, effectChain, fragSrc)) {
 		return false;
 	}
-	
+	m_shaderSrc = fragSrc;
+
+	m_uniforms.clear();
+	m_isLinked = false;
 	m_shaderProgram = glCreateProgram();
 	if (!m_shaderProgram) {
 		SDL_Log("Couldn't create shader program\n");
 	}
 
-	glAttachShader(m_shaderProgram, vertShader);
-	glAttachShader(m_shaderProgram, fragShader);
-	if (link()) {
+	ProgramBinaryCache& binaryCache = ProgramBinaryCache::instance();
+	uint64_t cacheKey = binaryCache.key({&vertSrc, &fragSrc});
+	bool isCacheHit = binaryCache.load(m_shaderProgram, cacheKey);
+	bool isLinked = isCacheHit;
+	if (!isCacheHit) {
+		GLuint vertShader = compileShader(vertSrc, GL_VERTEX_SHADER, vertFilename);
+		if(!vertShader) {
+			SDL_Log("Couldn't load vertex shader: %s\n", vertFilename.c_str());
+			return false;
+		}
+		
+		GLuint fragShader = compileShader(fragSrc, GL_FRAGMENT_SHADER, fragFilename);
+		if(!fragShader) {
+			SDL_Log("Couldn't load fragent shader: %s\n", fragFilename.c_str());
+			glDeleteShader(vertShader);
+			return false;
+		}
+
+		glAttachShader(m_shaderProgram, vertShader);
+		glAttachShader(m_shaderProgram, fragShader);
+		glProgramParameteri(m_shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		isLinked = link();
+		if (isLinked) binaryCache.store(m_shaderProgram, cacheKey);
+
+		glDeleteShader(vertShader);
+		glDeleteShader(fragShader);
+	}
+
+	m_isLinked = isLinked;
+	if (isLinked) {
+		resolveUniforms();
 		activate();
 		m_shaderConfig = ShaderConfig();
 		createShaderConfigFromUniforms();
 		extractUniformMetadata();
+		m_shaderConfig.resetValuesFromParams();
 		deactivate();
 	}
 	glBindAttribLocation(m_shaderProgram, 0, "in_Position");
 	glBindAttribLocation(m_shaderProgram, 1, "in_TexCoord");
 
-	glDeleteShader(vertShader);
-	glDeleteShader(fragShader);
+	std::string programName = effectChain.empty() ? fragFilename : fragFilename + " + " + effectChainSignature(effectChain);
+	binaryCache.addRecord(programName, double(SDL_GetTicksNS() - startTime) / 1000000.0, isCacheHit);
 
 	return true;
 }
 
 bool Shader::load(const std::string& compFilename)
 {
-	GLuint compShader = loadShaderByType(compFilename, GL_COMPUTE_SHADER);
-	if(!compShader) {
-		SDL_Log("Couldn't load compute shader: %s\n", compFilename.c_str());
-		return false;
-	}
-	
+	Uint64 startTime = SDL_GetTicksNS();
+	m_errorLog.clear();
+
+	std::string compSrc;
+	if (!readShaderSource(compFilename, {}, compSrc)) return false;
+	m_shaderSrc = compSrc;
+
+	m_uniforms.clear();
+	m_isLinked = false;
 	m_shaderProgram = glCreateProgram();
 	if (!m_shaderProgram) {
 		SDL_Log("Couldn't create compute shader program\n");
 	}
 
-	glAttachShader(m_shaderProgram, compShader);
-	link();
+	ProgramBinaryCache& binaryCache = ProgramBinaryCache::instance();
+	uint64_t cacheKey = binaryCache.key({&compSrc});
+	bool isCacheHit = binaryCache.load(m_shaderProgram, cacheKey);
+	bool isLinked = isCacheHit;
+	if (!isCacheHit) {
+		GLuint compShader = compileShader(compSrc, GL_COMPUTE_SHADER, compFilename);
+		if(!compShader) {
+			SDL_Log("Couldn't load compute shader: %s\n", compFilename.c_str());
+			return false;
+		}
+
+		glAttachShader(m_shaderProgram, compShader);
+		glProgramParameteri(m_shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		isLinked = link();
+		if (isLinked) binaryCache.store(m_shaderProgram, cacheKey);
+
+		glDeleteShader(compShader);
+	}
+
+	m_isLinked = isLinked;
+	if (isLinked) {
+		resolveUniforms();
+	}
 
-	glDeleteShader(compShader);
+	binaryCache.addRecord(compFilename, double(SDL_GetTicksNS() - startTime) / 1000000.0, isCacheHit);
 
 	return true;
 }
 
-GLuint Shader::loadShaderByType(const std::string& filename, GLenum shaderType, const std::string& extFilename)
+bool Shader::readShaderSource(const std::string& filename, const std::vector<std::string>& effectChain, std::string& src)
 {
-	m_shaderSrc = "";
-
-	GLuint shader;
-
 	std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Failed to open: " << filename << std::endl;
-		return -1;
+		m_errorLog = "Failed to open: " + filename;
+		return false;
     }
     
     std::ostringstream buffer;
     buffer << file.rdbuf();
-    m_shaderSrc = std::string(buffer.str());
+    src = std::string(buffer.str());
 	file.close();
 
-	// Load extension when existing
-	if (!extFilename.empty()) {
-		std::ifstream extFile(extFilename);
-		if (!extFile.is_open()) {
-			std::cerr << "Failed to open: " << extFilename << std::endl;
-			return -1;
+	// Fuse the effect modules when existing
+	if (!effectChain.empty()) {
+		std::vector<EffectModule> modules;
+		for (const std::string& extFilename : effectChain) {
+			std::ifstream extFile(extFilename);
+			if (!extFile.is_open()) {
+				std::cerr << "Failed to open: " << extFilename << std::endl;
+				m_errorLog = "Failed to open: " + extFilename;
+				return false;
+			}
+			
+			std::ostringstream extBuffer;
+			extBuffer << extFile.rdbuf();
+			modules.push_back({extFilename, extBuffer.str()});
+			extFile.close();
 		}
-		
-		std::ostringstream extBuffer;
-		extBuffer << extFile.rdbuf();
-		std::string extShaderSrc(extBuffer.str());
-		extFile.close();
-
-		strhlpr::searchAndReplace(m_shaderSrc, "//###EXT_MAIN_DEF###", extShaderSrc);
-		strhlpr::searchAndReplace(m_shaderSrc, "//###EXT_MAIN_USE###", "extMain(color, coord);");
-		//printf("SOURCE:\n %s\n", m_shaderSrc.c_str());
-		//printf("EXT SOURCE:\n %s\n", extShaderSrc.c_str());
+
+		if (!composeEffectChain(src, modules)) {
+			m_errorLog = "Invalid effect chain: " + effectChainSignature(effectChain);
+			return false;
+		}
+		//printf("SOURCE:\n %s\n", src.c_str());
 	}
-	
+
+	return true;
+}
+
+GLuint Shader::compileShader(const std::string& src, GLenum shaderType, const std::string& filename)
+{
 	// Create the shader
-	shader = glCreateShader(shaderType);
-	const char* src = m_shaderSrc.c_str();
-	glShaderSource(shader, 1, &src, NULL);
+	GLuint shader = glCreateShader(shaderType);
+	const char* srcPtr = src.c_str();
+	glShaderSource(shader, 1, &srcPtr, NULL);
 	
 	// Compile it
 	glCompileShader(shader);
@@ -372,12 +461,14 @@ GLuint Shader::loadShaderByType(const std::string& filename, GLenum shaderType,
 	
 	if(!compileSucceeded) {
 		SDL_Log("Compilation of shader %s failed:\n", filename.c_str());
+		m_errorLog = "Compilation of " + filename + " failed";
 		GLint logLength = 0;
 		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
 		GLchar *errLog = (GLchar*)malloc(logLength);
 		if(errLog) {
 			glGetShaderInfoLog(shader, logLength, &logLength, errLog);
 			SDL_Log("%s\n", errLog);
+			m_errorLog = errLog;
 			free(errLog);
 		}
 		else {
@@ -392,47 +483,247 @@ GLuint Shader::loadShaderByType(const std::string& filename, GLenum shaderType,
 	return shader;
 }
 
-bool Shader::bindUniformLocation(const std::string& locName, GLint unit)
+void Shader::resolveUniforms()
 {
-	GLint texSamplerUniformLoc = glGetUniformLocation(m_shaderProgram, locName.c_str());
-	if (texSamplerUniformLoc < 0) {
-		SDL_Log("ERROR: Couldn't get uniform location with this name: %s", locName.c_str());
-		return false;
+	m_uniforms.clear();
+	m_blockMembers.clear();
+	m_uniformBlocks.clear();
+
+	GLint uniformCount = 0;
+	glGetProgramiv(m_shaderProgram, GL_ACTIVE_UNIFORMS, &uniformCount);
+	m_uniforms.reserve(uniformCount);
+
+	for (GLint i = 0; i < uniformCount; i++) {
+		GLint size, length;
+		GLenum type;
+		GLchar name[256];
+
+		glGetActiveUniform(m_shaderProgram, i, 256, &length, &size, &type, name);
+		Uniform uniform;
+		uniform.name = std::string(name, length);
+		uniform.location = glGetUniformLocation(m_shaderProgram, name);
+
+		// Arrays are reported as "name[0]", look them up by their plain name
+		if (size > 1 && uniform.name.ends_with("[0]")) {
+			uniform.name.resize(uniform.name.size() - 3);
+		}
+
+		if (uniform.location >= 0) {
+			m_uniforms.push_back(uniform);
+			continue;
+		}
+
+		// Uniforms in blocks have no location, remember where they live in the block instead
+		GLuint index = GLuint(i);
+		GLint blockIndex = -1;
+		GLint offset = -1;
+		glGetActiveUniformsiv(m_shaderProgram, 1, &index, GL_UNIFORM_BLOCK_INDEX, &blockIndex);
+		glGetActiveUniformsiv(m_shaderProgram, 1, &index, GL_UNIFORM_OFFSET, &offset);
+		if (blockIndex >= 0 && offset >= 0) {
+			m_blockMembers.push_back({uniform.name, GLuint(blockIndex), offset});
+		}
+	}
+
+	GLint blockCount = 0;
+	glGetProgramiv(m_shaderProgram, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+	for (GLint i = 0; i < blockCount; i++) {
+		GLchar name[256];
+		GLsizei length = 0;
+		UniformBlockInfo block;
+		block.index = GLuint(i);
+		glGetActiveUniformBlockName(m_shaderProgram, block.index, 256, &length, name);
+		glGetActiveUniformBlockiv(m_shaderProgram, block.index, GL_UNIFORM_BLOCK_DATA_SIZE, &block.dataSize);
+		block.name = std::string(name, length);
+		m_uniformBlocks.push_back(block);
+	}
+
+	std::sort(m_blockMembers.begin(), m_blockMembers.end(), [](const BlockMember& a, const BlockMember& b) {
+		return a.name < b.name;
+	});
+
+	std::sort(m_uniforms.begin(), m_uniforms.end(), [](const Uniform& a, const Uniform& b) {
+		return a.name < b.name;
+	});
+}
+
+UniformHandle Shader::uniformHandle(const std::string& locName) const
+{
+	UniformHandle handle;
+	auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), locName, [](const Uniform& uniform, const std::string& name) {
+		return uniform.name < name;
+	});
+	if (it != m_uniforms.end() && it->name == locName) {
+		handle.index = int(it - m_uniforms.begin());
 	}
-	glUniform1i(texSamplerUniformLoc, unit);
+	return handle;
+}
+
+bool Shader::uniformBlockMember(const std::string& name, GLuint& blockIndex, GLint& offset) const
+{
+	auto it = std::lower_bound(m_blockMembers.begin(), m_blockMembers.end(), name, [](const BlockMember& member, const std::string& name) {
+		return member.name < name;
+	});
+	if (it == m_blockMembers.end() || it->name != name) return false;
+
+	blockIndex = it->blockIndex;
+	offset = it->offset;
 	return true;
 }
 
-bool Shader::setValue(const std::string& locName, GLfloat value)
+void Shader::setUniformBlockBinding(GLuint blockIndex, GLuint binding)
+{
+	glUniformBlockBinding(m_shaderProgram, blockIndex, binding);
+}
+
+Shader::Uniform* Shader::uniformFor(UniformHandle handle)
+{
+	if (!handle.isValid() || handle.index >= int(m_uniforms.size())) return nullptr;
+	return &m_uniforms[handle.index];
+}
+
+bool Shader::hasCachedValue(const Uniform& uniform)
 {
-	GLint uniformLoc = glGetUniformLocation(m_shaderProgram, locName.c_str());
-	if (uniformLoc < 0) {
+	return s_isUniformCacheEnabled && uniform.cacheGeneration == s_cacheGeneration;
+}
+
+template<typename T>
+bool Shader::setValueByName(const std::string& locName, T value)
+{
+	if (s_isUniformCacheEnabled) return setValue(uniformHandle(locName), value);
+
+	// Old behaviour: resolve the location and upload on every call
+	GLint location = glGetUniformLocation(m_shaderProgram, locName.c_str());
+	if (location < 0) {
 		//SDL_Log("ERROR: Couldn't get uniform location with this name: %s", locName.c_str());
 		return false;
 	}
-	glUniform1f(uniformLoc, value);
+	uploadUniform(location, value);
 	return true;
 }
 
-bool Shader::setValue(const std::string& locName, GLint value)
+void Shader::uploadUniform(GLint location, GLfloat value)
 {
-	GLint uniformLoc = glGetUniformLocation(m_shaderProgram, locName.c_str());
-	if (uniformLoc < 0) {
-		//SDL_Log("ERROR: Couldn't get uniform location with this name: %s", locName.c_str());
+	glUniform1f(location, value);
+}
+
+void Shader::uploadUniform(GLint location, GLint value)
+{
+	glUniform1i(location, value);
+}
+
+void Shader::uploadUniform(GLint location, glm::vec2 value)
+{
+	glUniform2f(location, value.x, value.y);
+}
+
+void Shader::uploadUniform(GLint location, glm::ivec4 value)
+{
+	glUniform4i(location, value.x, value.y, value.z, value.w);
+}
+
+std::vector<UniformHandle> Shader::uniformHandles(const std::vector<std::string>& names) const
+{
+	std::vector<UniformHandle> handles;
+	handles.reserve(names.size());
+	for (const auto& name : names) {
+		handles.push_back(uniformHandle(name));
+	}
+	return handles;
+}
+
+void Shader::setValues(const std::vector<UniformHandle>& handles, const std::vector<ShaderParamValue>& values)
+{
+	size_t count = std::min(handles.size(), values.size());
+	for (size_t i = 0; i < count; ++i) {
+		const ShaderParamValue& value = values[i];
+		switch (value.type) {
+			case ShaderParamType::Int:
+				setValue(handles[i], value.intValue);
+				break;
+			case ShaderParamType::Float:
+				setValue(handles[i], value.floatValue.x);
+				break;
+			case ShaderParamType::Vec2:
+				setValue(handles[i], value.floatValue);
+				break;
+		}
+	}
+}
+
+bool Shader::bindUniformLocation(const std::string& locName, GLint unit)
+{
+	if (!setValueByName(locName, unit)) {
+		SDL_Log("ERROR: Couldn't get uniform location with this name: %s", locName.c_str());
 		return false;
 	}
-	glUniform1i(uniformLoc, value);
 	return true;
 }
 
+bool Shader::setValue(const std::string& locName, GLfloat value)
+{
+	return setValueByName(locName, value);
+}
+
+bool Shader::setValue(const std::string& locName, GLint value)
+{
+	return setValueByName(locName, value);
+}
+
 bool Shader::setValue(const std::string& locName, glm::vec2 value)
 {
-	GLint uniformLoc = glGetUniformLocation(m_shaderProgram, locName.c_str());
-	if (uniformLoc < 0) {
-		//SDL_Log("ERROR: Couldn't get uniform location with this name: %s", locName.c_str());
-		return false;
-	}
-	glUniform2f(uniformLoc, value.x, value.y);
+	return setValueByName(locName, value);
+}
+
+bool Shader::setValue(const std::string& locName, glm::ivec4 value)
+{
+	return setValueByName(locName, value);
+}
+
+bool Shader::setValue(UniformHandle handle, GLfloat value)
+{
+	Uniform* uniform = uniformFor(handle);
+	if (!uniform) return false;
+	if (hasCachedValue(*uniform) && uniform->floatValue.x == value) return true;
+
+	uploadUniform(uniform->location, value);
+	uniform->floatValue.x = value;
+	uniform->cacheGeneration = s_cacheGeneration;
+	return true;
+}
+
+bool Shader::setValue(UniformHandle handle, GLint value)
+{
+	Uniform* uniform = uniformFor(handle);
+	if (!uniform) return false;
+	if (hasCachedValue(*uniform) && uniform->intValue.x == value) return true;
+
+	uploadUniform(uniform->location, value);
+	uniform->intValue.x = value;
+	uniform->cacheGeneration = s_cacheGeneration;
+	return true;
+}
+
+bool Shader::setValue(UniformHandle handle, glm::vec2 value)
+{
+	Uniform* uniform = uniformFor(handle);
+	if (!uniform) return false;
+	if (hasCachedValue(*uniform) && uniform->floatValue.x == value.x && uniform->floatValue.y == value.y) return true;
+
+	uploadUniform(uniform->location, value);
+	uniform->floatValue = glm::vec4(value.x, value.y, 0.0f, 0.0f);
+	uniform->cacheGeneration = s_cacheGeneration;
+	return true;
+}
+
+bool Shader::setValue(UniformHandle handle, glm::ivec4 value)
+{
+	Uniform* uniform = uniformFor(handle);
+	if (!uniform) return false;
+	if (hasCachedValue(*uniform) && uniform->intValue == value) return true;
+
+	uploadUniform(uniform->location, value);
+	uniform->intValue = value;
+	uniform->cacheGeneration = s_cacheGeneration;
 	return true;
 }
 
@@ -10,7 +10,27 @@
 
 #include <GLES3/gl3.h>
 #include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
 #include <ShaderConfig.h>
+#include <nlohmann/json_fwd.hpp>
+
+#include <string>
+#include <vector>
+
+// Pre-resolved uniform of a linked program (index into the shader's uniform table).
+// Handles are only valid for the program they were resolved from, resolve them
+// again after every load().
+struct UniformHandle {
+    int index = -1;
+    bool isValid() const { return index >= 0; }
+};
+
+// Active uniform block of a linked program
+struct UniformBlockInfo {
+    std::string name;
+    GLuint index = 0;
+    GLint dataSize = 0;
+};
 
 class Shader {
 public:
@@ -18,27 +38,81 @@ public:
     ~Shader();
 
 public:
-    bool load(const std::string& vertFilename, const std::string& fragFilename, const std::string& extFilename = "");
+    // effectChain: effect modules fused into the fragment shader, in call order (see EffectChain.h)
+    bool load(const std::string& vertFilename, const std::string& fragFilename, const std::vector<std::string>& effectChain = {});
     bool load(const std::string& compFilename);
     bool bindUniformLocation(const std::string& locName, GLint unit);
     bool setValue(const std::string& locName, GLfloat value);
     bool setValue(const std::string& locName, GLint value);
     bool setValue(const std::string& locName, glm::vec2 value);
+    bool setValue(const std::string& locName, glm::ivec4 value);
+    UniformHandle uniformHandle(const std::string& locName) const;
+    bool setValue(UniformHandle handle, GLfloat value);
+    bool setValue(UniformHandle handle, GLint value);
+    bool setValue(UniformHandle handle, glm::vec2 value);
+    bool setValue(UniformHandle handle, glm::ivec4 value);
+    // Handles for the parameters of a config layout, same order as its values
+    std::vector<UniformHandle> uniformHandles(const std::vector<std::string>& names) const;
+    void setValues(const std::vector<UniformHandle>& handles, const std::vector<ShaderParamValue>& values);
+    const std::vector<UniformBlockInfo>& uniformBlocks() const { return m_uniformBlocks; }
+    // Block and std140 byte offset of a block member, false for plain uniforms
+    bool uniformBlockMember(const std::string& name, GLuint& blockIndex, GLint& offset) const;
+    void setUniformBlockBinding(GLuint blockIndex, GLuint binding);
     void activate();
     void deactivate();
     const ShaderConfig& shaderConfig();
+    bool isLinked() const { return m_isLinked; }
+    GLuint program() const { return m_shaderProgram; }
+    // Compiler or linker log of the last failed load()
+    const std::string& errorLog() const { return m_errorLog; }
+
+    // Disabling the cache restores the old behaviour (location lookup and upload on every call), for comparisons
+    static void setUniformCacheEnabled(bool enabled) { s_isUniformCacheEnabled = enabled; s_cacheGeneration++; }
+    static bool isUniformCacheEnabled() { return s_isUniformCacheEnabled; }
     
 private:
-    GLuint loadShaderByType(const std::string& filename, GLenum shaderType, const std::string& extFilename = "");
+    // Active uniform with the last uploaded value, sorted by name
+    struct Uniform {
+        std::string name;
+        GLint location = -1;
+        uint32_t cacheGeneration = 0;   // value is only known while this matches s_cacheGeneration
+        glm::vec4 floatValue = glm::vec4(0.0f);
+        glm::ivec4 intValue = glm::ivec4(0);
+    };
+
+    struct BlockMember {
+        std::string name;
+        GLuint blockIndex = 0;
+        GLint offset = 0;
+    };
+
+    bool readShaderSource(const std::string& filename, const std::vector<std::string>& effectChain, std::string& src);
+    GLuint compileShader(const std::string& src, GLenum shaderType, const std::string& filename);
     bool link();
     void createShaderConfigFromUniforms();
-    void parseUnifromJson(const std::string& uniformName, const std::string& uniformType, const std::string& uniformJson);
+    void parseUnifromJson(const std::string& uniformName, const std::string& uniformType, const nlohmann::json& jsonData);
     void extractUniformMetadata();
     void destroyShaderProg(GLuint shaderProg);
+    void resolveUniforms();
+    Uniform* uniformFor(UniformHandle handle);
+    static bool hasCachedValue(const Uniform& uniform);
+    template<typename T> bool setValueByName(const std::string& locName, T value);
+    static void uploadUniform(GLint location, GLfloat value);
+    static void uploadUniform(GLint location, GLint value);
+    static void uploadUniform(GLint location, glm::vec2 value);
+    static void uploadUniform(GLint location, glm::ivec4 value);
     
 
 private:
     GLuint m_shaderProgram = 0;
+    bool m_isLinked = false;
     ShaderConfig m_shaderConfig;
     std::string m_shaderSrc;
+    std::string m_errorLog;
+    std::vector<Uniform> m_uniforms;
+    std::vector<BlockMember> m_blockMembers;
+    std::vector<UniformBlockInfo> m_uniformBlocks;
+
+    static bool s_isUniformCacheEnabled;
+    static uint32_t s_cacheGeneration;
 };
\ No newline at end of file
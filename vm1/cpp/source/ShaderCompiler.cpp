@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "ShaderCompiler.h"
+#include "ShaderLibrary.h"
+
+#include <SDL3/SDL.h>
+
+#include <cstring>
+
+ShaderCompiler::~ShaderCompiler()
+{
+    finalize();
+}
+
+bool ShaderCompiler::initialize()
+{
+    finalize();
+
+    m_display = eglGetCurrentDisplay();
+    EGLContext renderContext = eglGetCurrentContext();
+    if (m_display == EGL_NO_DISPLAY || renderContext == EGL_NO_CONTEXT) {
+        SDL_Log("No current EGL context, shaders are compiled on the main thread.");
+        return false;
+    }
+
+    // Use the config of the render context, shared contexts have to be compatible
+    EGLint configId = 0;
+    eglQueryContext(m_display, renderContext, EGL_CONFIG_ID, &configId);
+    EGLint configAttribs[] = { EGL_CONFIG_ID, configId, EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(m_display, configAttribs, &config, 1, &configCount) || configCount < 1) {
+        SDL_Log("Couldn't find the EGL config of the render context, shaders are compiled on the main thread.");
+        return false;
+    }
+
+    EGLint contextAttribs[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 1, EGL_NONE };
+    m_context = eglCreateContext(m_display, config, renderContext, contextAttribs);
+    if (m_context == EGL_NO_CONTEXT) {
+        SDL_Log("Couldn't create shared EGL context (0x%x), shaders are compiled on the main thread.", eglGetError());
+        return false;
+    }
+
+    // The worker never draws, a 1x1 pbuffer is only needed without surfaceless contexts
+    const char* extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+    if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context")) {
+        EGLint surfaceAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        m_surface = eglCreatePbufferSurface(m_display, config, surfaceAttribs);
+        if (m_surface == EGL_NO_SURFACE) {
+            SDL_Log("Couldn't create pbuffer for the shader compiler (0x%x), shaders are compiled on the main thread.", eglGetError());
+            finalize();
+            return false;
+        }
+    }
+
+    m_isRunning = true;
+    std::promise<bool> isContextCurrent;
+    std::future<bool> result = isContextCurrent.get_future();
+    m_thread = std::thread(&ShaderCompiler::run, this, std::move(isContextCurrent));
+    if (!result.get()) {
+        SDL_Log("Couldn't make the shader compiler context current (0x%x), shaders are compiled on the main thread.", eglGetError());
+        finalize();
+        return false;
+    }
+
+    m_isAsync = true;
+    return true;
+}
+
+void ShaderCompiler::finalize()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isRunning = false;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+    m_isAsync = false;
+
+    // Drop unfinished requests, their programs are shared and can be deleted from here
+    for (Job& job : m_compiledJobs) {
+        if (job.fence) glDeleteSync(job.fence);
+    }
+    for (Job& job : m_fencedJobs) {
+        if (job.fence) glDeleteSync(job.fence);
+    }
+    m_queuedJobs.clear();
+    m_compiledJobs.clear();
+    m_fencedJobs.clear();
+
+    if (m_surface != EGL_NO_SURFACE) {
+        eglDestroySurface(m_display, m_surface);
+        m_surface = EGL_NO_SURFACE;
+    }
+    if (m_context != EGL_NO_CONTEXT) {
+        eglDestroyContext(m_display, m_context);
+        m_context = EGL_NO_CONTEXT;
+    }
+    m_display = EGL_NO_DISPLAY;
+}
+
+uint64_t ShaderCompiler::request(const std::string& vertFilename, const std::string& fragFilename, const std::vector<std::string>& effectChain, ShaderCompileCallback callback)
+{
+    Job job;
+    job.id = m_nextRequestId++;
+    job.vertFilename = vertFilename;
+    job.fragFilename = fragFilename;
+    job.effectChain = effectChain;
+    job.callback = std::move(callback);
+    m_stats.requests++;
+
+    // Resident programs are handed out on the next update() without compiling
+    ShaderLibrary& library = ShaderLibrary::instance();
+    if (!library.makeKey(vertFilename, fragFilename, effectChain, job.key)) job.key.clear();
+    if (!job.key.empty()) {
+        job.shader = library.find(job.key);
+        job.isShared = (job.shader != nullptr);
+    }
+
+    uint64_t id = job.id;
+    if (job.isShared || !m_isAsync) {
+        if (!job.isShared) compile(job);
+        m_fencedJobs.push_back(std::move(job));
+        return id;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queuedJobs.push_back(std::move(job));
+    }
+    m_condition.notify_one();
+    return id;
+}
+
+void ShaderCompiler::update()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Job& job : m_compiledJobs) {
+            m_fencedJobs.push_back(std::move(job));
+        }
+        m_compiledJobs.clear();
+    }
+
+    // Collect first, callbacks may request new programs
+    std::vector<Job> readyJobs;
+    for (auto it = m_fencedJobs.begin(); it != m_fencedJobs.end();) {
+        if (it->fence) {
+            GLenum status = glClientWaitSync(it->fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                ++it;
+                continue;
+            }
+            glDeleteSync(it->fence);
+            it->fence = 0;
+        }
+        readyJobs.push_back(std::move(*it));
+        it = m_fencedJobs.erase(it);
+    }
+
+    for (Job& job : readyJobs) {
+        if (!job.isShared) {
+            if (job.shader->isLinked()) {
+                m_stats.compiled++;
+                m_stats.lastCompileMs = job.compileMs;
+                if (job.compileMs > m_stats.maxCompileMs) m_stats.maxCompileMs = job.compileMs;
+                if (!job.key.empty()) ShaderLibrary::instance().insert(job.key, job.shader, job.compileMs);
+            }
+            else {
+                m_stats.failed++;
+            }
+        }
+
+        if (job.callback) {
+            ShaderCompileResult result;
+            result.requestId = job.id;
+            result.shader = job.shader;
+            result.compileMs = job.isShared ? 0.0 : job.compileMs;
+            job.callback(result);
+        }
+    }
+}
+
+int ShaderCompiler::pendingRequests() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return int(m_queuedJobs.size() + m_compiledJobs.size() + m_fencedJobs.size());
+}
+
+void ShaderCompiler::compile(Job& job)
+{
+    Uint64 startTime = SDL_GetTicksNS();
+    job.shader = std::make_shared<Shader>();
+    job.shader->load(job.vertFilename, job.fragFilename, job.effectChain);
+    job.compileMs = double(SDL_GetTicksNS() - startTime) / 1000000.0;
+}
+
+void ShaderCompiler::run(std::promise<bool> isContextCurrent)
+{
+    bool isCurrent = eglMakeCurrent(m_display, m_surface, m_surface, m_context) == EGL_TRUE;
+    isContextCurrent.set_value(isCurrent);
+    if (!isCurrent) return;
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return !m_isRunning || !m_queuedJobs.empty(); });
+            if (!m_isRunning) break;
+            job = std::move(m_queuedJobs.front());
+            m_queuedJobs.pop_front();
+        }
+
+        compile(job);
+
+        // The render context may only use the program once the commands that built it completed
+        job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_compiledJobs.push_back(std::move(job));
+    }
+
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglReleaseThread();
+}
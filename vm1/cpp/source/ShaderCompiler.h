@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include "Shader.h"
+
+#include <SDL3/SDL_egl.h>
+#include <GLES3/gl3.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ShaderCompileResult {
+    uint64_t requestId = 0;
+    std::shared_ptr<Shader> shader;     // never nullptr, check Shader::isLinked()
+    double compileMs = 0.0;             // 0 when a resident program was reused
+};
+
+using ShaderCompileCallback = std::function<void(const ShaderCompileResult&)>;
+
+struct ShaderCompilerStats {
+    int requests = 0;
+    int compiled = 0;
+    int failed = 0;
+    double lastCompileMs = 0.0;
+    double maxCompileMs = 0.0;
+};
+
+// Compiles and links programs on a worker thread with its own EGL context that
+// shares objects with the render context, so a new shader never stalls the frame.
+// Finished programs are handed to the request callbacks from update() on the main
+// thread once their fence signaled, until then the previous program keeps rendering.
+// Falls back to compiling on the main thread when no shared context can be created.
+class ShaderCompiler
+{
+public:
+    ShaderCompiler() = default;
+    ~ShaderCompiler();
+
+    ShaderCompiler(const ShaderCompiler&) = delete;
+    ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+public:
+    // Must be called on the main thread with the render context current
+    bool initialize();
+    void finalize();
+    bool isAsync() const { return m_isAsync; }
+
+    // Returns the request id, the callback is never invoked from within request()
+    uint64_t request(const std::string& vertFilename, const std::string& fragFilename, const std::vector<std::string>& effectChain, ShaderCompileCallback callback);
+    // Main thread, once per frame
+    void update();
+
+    int pendingRequests() const;
+    const ShaderCompilerStats& stats() const { return m_stats; }
+
+private:
+    struct Job {
+        uint64_t id = 0;
+        std::string vertFilename;
+        std::string fragFilename;
+        std::vector<std::string> effectChain;
+        std::string key;                // empty when a source file is missing
+        ShaderCompileCallback callback;
+        std::shared_ptr<Shader> shader;
+        bool isShared = false;
+        double compileMs = 0.0;
+        GLsync fence = 0;
+    };
+
+    void run(std::promise<bool> isContextCurrent);
+    static void compile(Job& job);
+
+private:
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    EGLSurface m_surface = EGL_NO_SURFACE;
+    bool m_isAsync = false;
+
+    std::thread m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_isRunning = false;
+    std::deque<Job> m_queuedJobs;       // waiting for the worker
+    std::vector<Job> m_compiledJobs;    // handed back by the worker
+
+    // Main thread only
+    std::vector<Job> m_fencedJobs;      // waiting for their fence (or the next update())
+    uint64_t m_nextRequestId = 1;
+    ShaderCompilerStats m_stats;
+};
@@ -10,7 +10,11 @@
 
 #include "Parameters.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <type_traits>
 #include <map>
 #include <variant>
 #include <vector>
@@ -21,10 +25,34 @@
 #include <cereal/types/string.hpp>
 #include <cereal/types/variant.hpp>
 
+using ShaderParameter = std::variant<IntParameter, FloatParameter, Vec2Parameter>;
 
+enum class ShaderParamType : uint8_t
+{
+    Int = 0,
+    Float = 1,
+    Vec2 = 2
+};
 
+// Current value of one parameter. This is all the per-frame code touches.
+struct ShaderParamValue
+{
+    ShaderParamType type = ShaderParamType::Float;
+    int intValue = 0;
+    glm::vec2 floatValue = glm::vec2(0.0f, 0.0f);   // Float uses x
+};
 
+// Parameters driven by the playback every frame (-1 if the shader has none)
+struct DrivenParamIndices
+{
+    int analog[4] = {-1, -1, -1, -1};
+};
 
+// Parameters of a shader in a compiled layout: names, metadata and values are
+// parallel arrays sorted by uniform name. Menu and serialization find parameters
+// through the name -> index table, per-frame code only walks `values`.
+// The `value` member of the metadata in `params` is only used to initialize
+// `values` and for serialization.
 struct ShaderConfig
 {
     ShaderConfig() = default;
@@ -33,39 +61,150 @@ struct ShaderConfig
     // }
 
     void reset() {
+        names.clear();
         params.clear();
+        values.clear();
         groups.clear();
+        rebuildLayout();
     }
 
     void update(const ShaderConfig& shaderConfig) {
-        std::vector<std::string> toDelete;
-        for (const auto& kv : params) {
-            const std::string& paramName = kv.first;
-            if (!shaderConfig.params.contains(paramName)) {
-                toDelete.push_back(paramName);
-            }
+        ShaderConfig merged;
+        for (size_t i = 0; i < shaderConfig.names.size(); ++i) {
+            int index = indexOf(shaderConfig.names[i]);
+            bool isKept = index >= 0 && values[index].type == shaderConfig.values[i].type;
+            merged.names.push_back(shaderConfig.names[i]);
+            merged.params.push_back(isKept ? params[index] : shaderConfig.params[i]);
+            merged.values.push_back(isKept ? values[index] : shaderConfig.values[i]);
         }
-        for (const auto& paramName : toDelete) {
-            params.erase(paramName);
+        merged.groups = shaderConfig.groups;
+        merged.rebuildLayout();
+        *this = std::move(merged);
+    }
+
+    // Adds a parameter or replaces the one with the same uniform name
+    void setParam(const std::string& uniformName, const ShaderParameter& param) {
+        int index = indexOf(uniformName);
+        if (index >= 0) {
+            params[index] = param;
+            values[index] = valueFromParam(param);
+            return;
         }
-        for (const auto& kv : shaderConfig.params) {
-            const std::string& paramName = kv.first;
-            if (!params.contains(paramName)) {
-                params[paramName] = kv.second;
-            }
+
+        auto it = std::lower_bound(names.begin(), names.end(), uniformName);
+        size_t position = it - names.begin();
+        names.insert(it, uniformName);
+        params.insert(params.begin() + position, param);
+        values.insert(values.begin() + position, valueFromParam(param));
+        rebuildLayout();
+    }
+
+    int indexOf(const std::string& uniformName) const {
+        auto it = indices.find(uniformName);
+        return (it != indices.end()) ? it->second : -1;
+    }
+
+    bool contains(const std::string& uniformName) const {
+        return indices.contains(uniformName);
+    }
+
+    // Takes over the values from the metadata, e.g. after defaults were parsed
+    void resetValuesFromParams() {
+        for (size_t i = 0; i < params.size(); ++i) {
+            values[i] = valueFromParam(params[i]);
         }
+    }
+
+    void resetValue(int index) {
+        if (index < 0 || index >= int(params.size())) return;
+        std::visit([&](auto& param) { param.reset(); }, params[index]);
+        values[index] = valueFromParam(params[index]);
+    }
 
-        groups = shaderConfig.groups;
+    void setFloat(int index, float value) {
+        if (index < 0 || index >= int(values.size())) return;
+        values[index].floatValue.x = value;
     }
 
-    std::map<std::string, std::variant<IntParameter, FloatParameter, Vec2Parameter>> params;
+    static ShaderParamValue valueFromParam(const ShaderParameter& param) {
+        ShaderParamValue value;
+        if (std::holds_alternative<IntParameter>(param)) {
+            value.type = ShaderParamType::Int;
+            value.intValue = std::get<IntParameter>(param).value;
+        }
+        else if (std::holds_alternative<FloatParameter>(param)) {
+            value.type = ShaderParamType::Float;
+            value.floatValue.x = std::get<FloatParameter>(param).value;
+        }
+        else if (std::holds_alternative<Vec2Parameter>(param)) {
+            value.type = ShaderParamType::Vec2;
+            value.floatValue = std::get<Vec2Parameter>(param).value;
+        }
+        return value;
+    }
+
+    std::vector<std::string> names;
+    std::vector<ShaderParameter> params;
+    std::vector<ShaderParamValue> values;
+    std::map<std::string, int> indices;
     std::map<std::string, std::vector<std::string>> groups;
+    DrivenParamIndices drivenParams;
+    // Changes whenever names/types change, copies of a config share it
+    uint64_t layoutId = 0;
 
+    // Same format as the former std::map<std::string, variant> member
     template <class Archive>
-    void serialize(Archive& ar)
+    void save(Archive& ar) const
     {
+        std::map<std::string, ShaderParameter> params;
+        for (size_t i = 0; i < names.size(); ++i) {
+            ShaderParameter param = this->params[i];
+            const ShaderParamValue& value = values[i];
+            std::visit([&](auto& typedParam) {
+                using T = std::decay_t<decltype(typedParam)>;
+                if constexpr (std::is_same_v<T, IntParameter>) typedParam.value = value.intValue;
+                else if constexpr (std::is_same_v<T, FloatParameter>) typedParam.value = value.floatValue.x;
+                else typedParam.value = value.floatValue;
+            }, param);
+            params[names[i]] = param;
+        }
         ar(
             CEREAL_NVP(params)
         );
     }
-};
\ No newline at end of file
+
+    template <class Archive>
+    void load(Archive& ar)
+    {
+        std::map<std::string, ShaderParameter> params;
+        ar(
+            CEREAL_NVP(params)
+        );
+
+        names.clear();
+        this->params.clear();
+        values.clear();
+        for (const auto& kv : params) {
+            names.push_back(kv.first);
+            this->params.push_back(kv.second);
+            values.push_back(valueFromParam(kv.second));
+        }
+        rebuildLayout();
+    }
+
+private:
+    void rebuildLayout() {
+        static std::atomic<uint64_t> s_nextLayoutId = 1;
+        layoutId = s_nextLayoutId++;
+
+        indices.clear();
+        drivenParams = DrivenParamIndices();
+        for (size_t i = 0; i < names.size(); ++i) {
+            indices[names[i]] = int(i);
+            if (values[i].type != ShaderParamType::Float) continue;
+            for (int j = 0; j < 4; ++j) {
+                if (names[i] == "analog" + std::to_string(j)) drivenParams.analog[j] = int(i);
+            }
+        }
+    }
+};
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "ShaderLibrary.h"
+#include "EffectChain.h"
+
+#include <SDL3/SDL.h>
+#include <GLES3/gl3.h>
+
+#include <fstream>
+#include <sstream>
+
+static bool appendFile(const std::string& filename, std::string& key)
+{
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    key += buffer.str();
+    key += '\0';
+    return true;
+}
+
+ShaderLibrary& ShaderLibrary::instance()
+{
+    static ShaderLibrary s_instance;
+    return s_instance;
+}
+
+std::shared_ptr<Shader> ShaderLibrary::load(const std::string& vertFilename, const std::string& fragFilename, const std::vector<std::string>& effectChain)
+{
+    std::string key;
+    bool hasSources = makeKey(vertFilename, fragFilename, effectChain, key);
+    if (hasSources) {
+        if (std::shared_ptr<Shader> shader = find(key)) return shader;
+    }
+    else {
+        m_stats.requests++;
+    }
+
+    // Missing files end up here as well, so load() reports them as before
+    Uint64 startTime = SDL_GetTicksNS();
+    std::shared_ptr<Shader> shader = std::make_shared<Shader>();
+    shader->load(vertFilename, fragFilename, effectChain);
+    if (hasSources) insert(key, shader, double(SDL_GetTicksNS() - startTime) / 1000000.0);
+
+    return shader;
+}
+
+bool ShaderLibrary::makeKey(const std::string& vertFilename, const std::string& fragFilename, const std::vector<std::string>& effectChain, std::string& key) const
+{
+    key.clear();
+    bool hasSources = appendFile(vertFilename, key) && appendFile(fragFilename, key);
+    for (const std::string& extFilename : effectChain) {
+        if (hasSources) hasSources = appendFile(extFilename, key);
+    }
+    // Repeated modules are told apart by their file names, so the names are part of the program
+    key += effectChainSignature(effectChain);
+    return hasSources;
+}
+
+std::shared_ptr<Shader> ShaderLibrary::find(const std::string& key)
+{
+    m_stats.requests++;
+    removeExpired();
+
+    auto it = m_programs.find(key);
+    if (it == m_programs.end()) return nullptr;
+
+    std::shared_ptr<Shader> shader = it->second.shader.lock();
+    if (shader) {
+        m_stats.sharedPrograms++;
+        m_stats.savedMs += it->second.loadMs;
+        m_stats.savedBytes += it->second.binarySize;
+    }
+    return shader;
+}
+
+void ShaderLibrary::insert(const std::string& key, const std::shared_ptr<Shader>& shader, double loadMs)
+{
+    if (!shader || !shader->isLinked()) return;
+
+    Entry entry;
+    entry.shader = shader;
+    entry.loadMs = loadMs;
+    GLint binarySize = 0;
+    glGetProgramiv(shader->program(), GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    entry.binarySize = size_t(binarySize > 0 ? binarySize : 0);
+    m_programs[key] = entry;
+    m_stats.linkedPrograms++;
+}
+
+void ShaderLibrary::removeExpired()
+{
+    for (auto it = m_programs.begin(); it != m_programs.end();) {
+        if (it->second.shader.expired()) {
+            it = m_programs.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+size_t ShaderLibrary::residentPrograms() const
+{
+    size_t count = 0;
+    for (const auto& kv : m_programs) {
+        if (!kv.second.shader.expired()) count++;
+    }
+    return count;
+}
+
+void ShaderLibrary::logReport() const
+{
+    SDL_Log("Shader library: %d requests, %d programs linked, %d shared (saved %.2f ms, %.1f KB of program binaries)",
+            m_stats.requests, m_stats.linkedPrograms, m_stats.sharedPrograms, m_stats.savedMs, m_stats.savedBytes / 1024.0);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include "Shader.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ShaderLibraryStats {
+    int requests = 0;
+    int linkedPrograms = 0;
+    int sharedPrograms = 0;     // requests served by an already linked program
+    double savedMs = 0.0;       // load time those requests would have cost
+    size_t savedBytes = 0;      // program binary size of the programs not linked again
+};
+
+// Shares linked programs between all users of identical sources (vertex, fragment
+// and effect extension). Users hold the returned shader, a program is deleted when
+// its last user drops it. Since the program (and its uniform values) is shared,
+// users have to set all of their uniforms before every draw.
+// Main thread only, the ShaderCompiler hands its results over through find()/insert().
+class ShaderLibrary
+{
+public:
+    static ShaderLibrary& instance();
+
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+public:
+    // Never returns nullptr, check Shader::isLinked() for failures
+    std::shared_ptr<Shader> load(const std::string& vertFilename, const std::string& fragFilename, const std::vector<std::string>& effectChain = {});
+
+    // Identifies a program by its sources and the chain signature, false when one of the files can't be read
+    bool makeKey(const std::string& vertFilename, const std::string& fragFilename, const std::vector<std::string>& effectChain, std::string& key) const;
+    // Counts as a request, returns nullptr when no linked program for the key is resident
+    std::shared_ptr<Shader> find(const std::string& key);
+    // Registers a program that was loaded outside of load()
+    void insert(const std::string& key, const std::shared_ptr<Shader>& shader, double loadMs);
+
+    const ShaderLibraryStats& stats() const { return m_stats; }
+    size_t residentPrograms() const;
+    void logReport() const;
+
+private:
+    ShaderLibrary() = default;
+
+    struct Entry {
+        std::weak_ptr<Shader> shader;
+        double loadMs = 0.0;
+        size_t binarySize = 0;
+    };
+
+    void removeExpired();
+
+private:
+    // Keyed by the raw sources, so changed files never match a stale program
+    std::unordered_map<std::string, Entry> m_programs;
+    ShaderLibraryStats m_stats;
+};
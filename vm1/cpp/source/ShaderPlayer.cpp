@@ -18,6 +18,7 @@
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 
+#include <algorithm>
 #include <iostream>
 #include <math.h>
 #include <variant>
@@ -30,12 +31,50 @@ using namespace std;
 const int IMAGE_WIDTH = 1920;
 const int IMAGE_HEIGHT = 1080;
 
+// Steps of the automatic render scale. A shader steps down while it needs more than
+// SCALE_DOWN_GPU_MS per frame and only steps up again when the larger scale is expected
+// (by pixel count) to stay below SCALE_UP_GPU_MS. Every step waits for SETTLE_SAMPLES
+// measurements at the current scale, so the scale can't oscillate.
+const float AUTO_RENDER_SCALES[] = { 1.0f, 0.75f, 0.5f, 1.0f / 3.0f };
+const int AUTO_RENDER_SCALE_COUNT = sizeof(AUTO_RENDER_SCALES) / sizeof(AUTO_RENDER_SCALES[0]);
+const double SCALE_DOWN_GPU_MS = 8.0;
+const double SCALE_UP_GPU_MS = 5.0;
+const uint64_t SETTLE_SAMPLES = 60;
+// Without timer queries every measurement stalls on glFinish(), so only every n-th frame is measured
+const uint64_t FALLBACK_MEASURE_INTERVAL = 10;
+
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    // FNV-1a
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Everything a static shader's output depends on
+static uint64_t fingerprint(const std::vector<ShaderParamValue>& values, int width, int height)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashBytes(hash, &width, sizeof(width));
+    hash = hashBytes(hash, &height, sizeof(height));
+    for (const ShaderParamValue& value : values) {
+        hash = hashBytes(hash, &value.type, sizeof(value.type));
+        hash = hashBytes(hash, &value.intValue, sizeof(value.intValue));
+        hash = hashBytes(hash, &value.floatValue.x, sizeof(value.floatValue.x));
+        hash = hashBytes(hash, &value.floatValue.y, sizeof(value.floatValue.y));
+    }
+    return hash;
+}
+
 
 ShaderPlayer::ShaderPlayer()
 {
     loadShaders();
     createVertexBuffers();
-    initializeFramebufferAndTextures();
+    initializeInputTextures();
 }
 
 ShaderPlayer::~ShaderPlayer()
@@ -46,7 +85,26 @@ ShaderPlayer::~ShaderPlayer()
 bool ShaderPlayer::openFile(const std::string& fileName, AudioStream* audioStream)
 {
     printf("Load Custom Shader: %s\n", fileName.c_str());
-    m_isShaderReady = m_shader.load("shaders/pass.vert", fileName.c_str());
+    return setShader(ShaderLibrary::instance().load("shaders/pass.vert", fileName));
+}
+
+bool ShaderPlayer::setShader(std::shared_ptr<Shader> shader)
+{
+    m_shader = shader;
+    m_isShaderReady = m_shader->isLinked();
+    m_paramLayoutId = 0;
+    m_resolutionHandle = m_shader->uniformHandle("iResolution");
+    m_timeHandle = m_shader->uniformHandle("iTime");
+    // Only active uniforms have a handle, so a declared but unused iTime doesn't count
+    m_isTimeDependent = m_timeHandle.isValid();
+    m_isRgbOutputValid = false;
+
+    // A new shader starts over at full resolution
+    if (m_requestedRenderScale == AUTO_RENDER_SCALE) {
+        m_autoScaleIndex = 0;
+        m_renderScale = AUTO_RENDER_SCALES[0];
+    }
+    m_gpuTimer.reset();
     return m_isShaderReady;
 }
 
@@ -55,8 +113,11 @@ void ShaderPlayer::close()
     MediaPlayer::close();
 
     if (m_isShaderReady) {
-        m_shader = Shader();
+        m_shader = std::make_shared<Shader>();
         m_isShaderReady = false;
+        m_paramLayoutId = 0;
+        m_resolutionHandle = UniformHandle();
+        m_timeHandle = UniformHandle();
     }
 }
 
@@ -79,18 +140,17 @@ void ShaderPlayer::run()
 
 void ShaderPlayer::activateShader()
 {
-    m_shader.activate();
+    m_shader->activate();
 }
 
 void ShaderPlayer::deactivateShader()
 {
-    m_shader.deactivate();
+    m_shader->deactivate();
 }
 
 void ShaderPlayer::setCurrentTime(float time)
 {
     m_currentTime = time;
-    //m_shader.setValue("iTime", time);
 }
 
 void ShaderPlayer::setAnalogValue(float value) 
@@ -98,10 +158,69 @@ void ShaderPlayer::setAnalogValue(float value)
     m_analogValue = value;
 }
 
+void ShaderPlayer::setRenderScale(float renderScale)
+{
+    if (renderScale == m_requestedRenderScale) return;
+
+    m_requestedRenderScale = renderScale;
+    if (renderScale == AUTO_RENDER_SCALE) {
+        m_autoScaleIndex = 0;
+        m_renderScale = AUTO_RENDER_SCALES[0];
+    }
+    else {
+        m_renderScale = std::clamp(renderScale, 0.1f, 1.0f);
+    }
+    m_gpuTimer.reset();
+}
+
+float ShaderPlayer::renderScale() const
+{
+    return m_resolutionHandle.isValid() ? m_renderScale : 1.0f;
+}
+
+void ShaderPlayer::updateAutoRenderScale()
+{
+    if (m_gpuTimer.samples() < SETTLE_SAMPLES) return;
+
+    double gpuMs = m_gpuTimer.averageMs();
+    int scaleIndex = m_autoScaleIndex;
+    if (gpuMs > SCALE_DOWN_GPU_MS) {
+        scaleIndex = std::min(scaleIndex + 1, AUTO_RENDER_SCALE_COUNT - 1);
+    }
+    else if (scaleIndex > 0) {
+        double ratio = AUTO_RENDER_SCALES[scaleIndex - 1] / AUTO_RENDER_SCALES[scaleIndex];
+        if (gpuMs * ratio * ratio < SCALE_UP_GPU_MS) scaleIndex--;
+    }
+    if (scaleIndex == m_autoScaleIndex) return;
+
+    SDL_Log("Shader render scale %.2f -> %.2f (%.2f ms GPU time)", AUTO_RENDER_SCALES[m_autoScaleIndex], AUTO_RENDER_SCALES[scaleIndex], gpuMs);
+    m_autoScaleIndex = scaleIndex;
+    m_renderScale = AUTO_RENDER_SCALES[scaleIndex];
+    m_gpuTimer.reset();
+}
+
 void ShaderPlayer::render()
 {
-    glViewport(0, 0, 1920, 1080);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    float scale = renderScale();
+    int width = std::max(1, int(float(IMAGE_WIDTH) * scale + 0.5f));
+    int height = std::max(1, int(float(IMAGE_HEIGHT) * scale + 0.5f));
+    if (!acquireRenderTarget(width, height)) return;
+
+    // A static shader keeps its last frame while its parameters don't change.
+    // A newly leased render target resets m_isRgbOutputValid.
+    uint64_t valuesFingerprint = m_isTimeDependent ? 0 : fingerprint(m_paramValues, width, height);
+    if (!m_isTimeDependent && m_isRgbOutputValid && valuesFingerprint == m_renderedFingerprint) {
+        m_stats.skippedFrames++;
+        return;
+    }
+
+    bool isAutomatic = (m_requestedRenderScale == AUTO_RENDER_SCALE) && m_resolutionHandle.isValid();
+    bool isMeasured = isAutomatic && (m_gpuTimer.usesTimerQuery() || m_frameCount % FALLBACK_MEASURE_INTERVAL == 0);
+    m_frameCount++;
+    if (isMeasured) m_gpuTimer.begin();
+
+    glViewport(0, 0, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_renderTarget->frameBuffer);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
@@ -109,23 +228,9 @@ void ShaderPlayer::render()
 
     glBindVertexArray(m_vao);
 
-    for (const auto& kv : m_shaderConfig.params) {
-        const std::string& name = kv.first;
-        const auto& param = kv.second;
-        if (std::holds_alternative<IntParameter>(param)) {
-            auto& intParam = std::get<IntParameter>(param);  
-            m_shader.setValue(name.c_str(), intParam.value);
-        } 
-        else if (std::holds_alternative<FloatParameter>(param)) {
-            auto& floatParam = std::get<FloatParameter>(param); 
-            m_shader.setValue(name.c_str(), floatParam.value);
-        } 
-        else if (std::holds_alternative<Vec2Parameter>(param)) {
-            auto& vec2Param = std::get<Vec2Parameter>(param);
-            glm::vec2 value(vec2Param.value.x, vec2Param.value.y);
-            m_shader.setValue(name.c_str(), value);
-        }
-    }
+    m_shader->setValues(m_paramHandles, m_paramValues);
+    m_shader->setValue(m_resolutionHandle, glm::vec2(float(width), float(height)));
+    m_shader->setValue(m_timeHandle, m_currentTime);
     
     glDrawArrays(GL_TRIANGLES, 0, 6);
 
@@ -134,19 +239,30 @@ void ShaderPlayer::render()
 
     glBindTexture(GL_TEXTURE_2D, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    m_renderedFingerprint = valuesFingerprint;
+    m_isRgbOutputValid = true;
+    m_stats.renderedFrames++;
+
+    if (isMeasured) m_gpuTimer.end();
+    if (isAutomatic) updateAutoRenderScale();
 }
 
 void ShaderPlayer::update()
 {
-    if (m_isShaderReady) render();
+    if (m_isShaderReady && m_isVisible) render();
 }
 
 const ShaderConfig& ShaderPlayer::shaderConfig()
 {
-    return m_shader.shaderConfig();
+    return m_shader->shaderConfig();
 }
 
 void ShaderPlayer::setShaderUniforms(const ShaderConfig& shaderConfig)
 {
-    m_shaderConfig = shaderConfig;
+    if (shaderConfig.layoutId != m_paramLayoutId) {
+        m_paramHandles = m_shader->uniformHandles(shaderConfig.names);
+        m_paramLayoutId = shaderConfig.layoutId;
+    }
+    m_paramValues = shaderConfig.values;
 }
\ No newline at end of file
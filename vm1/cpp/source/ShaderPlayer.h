@@ -14,6 +14,7 @@
 #include "Shader.h"
 #include "CaptureType.h"
 #include "ShaderConfig.h"
+#include "GpuTimer.h"
 
 #include <SDL3/SDL_render.h> 
 #include <SDL3/SDL_opengl.h>
@@ -24,6 +25,11 @@
 
 #include <vector>
 
+struct ShaderPlayerStats {
+    uint64_t renderedFrames = 0;
+    uint64_t skippedFrames = 0;     // parameters unchanged, the last frame was reused
+};
+
 class ShaderPlayer : public MediaPlayer {
 public: 
     ShaderPlayer();
@@ -31,6 +37,8 @@ public:
 
 public:
     bool openFile(const std::string& fileName, AudioStream* audioStream = nullptr);
+    // Takes over a program built from "shaders/pass.vert" and the shader file (e.g. by the ShaderCompiler)
+    bool setShader(std::shared_ptr<Shader> shader);
     void close() override;
     void finalize();
     bool isFrameReady() override;
@@ -40,20 +48,45 @@ public:
     void setCurrentTime(float time);
     void setAnalogValue(float value);
 
+    // Fraction of the output resolution the shader renders at, the planes upscale it
+    // bilinearly. AUTO_RENDER_SCALE picks it from the measured GPU time. Shaders
+    // without an iResolution uniform always render at full resolution.
+    static constexpr float AUTO_RENDER_SCALE = 0.0f;
+    void setRenderScale(float renderScale);
+    float renderScale() const;
+
+    // Shaders without an active iTime uniform only change with their parameters
+    bool isTimeDependent() const { return m_isTimeDependent; }
+    const ShaderPlayerStats& stats() const { return m_stats; }
+
 private:
     void loadShaders() override;
     void run() override;
     void render();
+    void updateAutoRenderScale();
 
     void activateShader();
     void deactivateShader();
 
 private:
     //Shader m_customShader;
-    ShaderConfig m_shaderConfig;
+    std::vector<ShaderParamValue> m_paramValues;
+    std::vector<UniformHandle> m_paramHandles;
+    uint64_t m_paramLayoutId = 0;
+    UniformHandle m_resolutionHandle;
+    UniformHandle m_timeHandle;
     float m_currentTime = 0.0f;
     float m_analogValue = 0.0f;
     bool m_isShaderReady = false;
+    bool m_isTimeDependent = true;
+    uint64_t m_renderedFingerprint = 0;
+    ShaderPlayerStats m_stats;
+
+    float m_requestedRenderScale = 1.0f;
+    float m_renderScale = 1.0f;
+    int m_autoScaleIndex = 0;
+    uint64_t m_frameCount = 0;
+    GpuTimer m_gpuTimer;
 
     int m_fd = -1;
     int m_bufferIndex = -1;
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "ShaderWatcher.h"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+ShaderWatcher::~ShaderWatcher()
+{
+    stop();
+}
+
+bool ShaderWatcher::start(const std::vector<std::string>& directories)
+{
+    stop();
+
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        SDL_Log("Couldn't initialize inotify (%s), shader hot reload is disabled.", strerror(errno));
+        return false;
+    }
+
+    for (const std::string& directory : directories) {
+        std::error_code error;
+        fs::path path = fs::weakly_canonical(directory, error);
+        if (error || !fs::is_directory(path, error)) continue;
+
+        addWatch(path.string());
+        for (auto it = fs::recursive_directory_iterator(path, error); !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+            if (it->is_directory(error)) addWatch(it->path().string());
+        }
+    }
+
+    return true;
+}
+
+void ShaderWatcher::stop()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_directories.clear();
+    m_pendingChanges.clear();
+}
+
+void ShaderWatcher::addWatch(const std::string& directory)
+{
+    // IN_CLOSE_WRITE for editors writing in place, IN_MOVED_TO for the ones renaming a temporary file
+    int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (wd < 0) {
+        SDL_Log("Couldn't watch %s: %s", directory.c_str(), strerror(errno));
+        return;
+    }
+    m_directories[wd] = directory;
+}
+
+void ShaderWatcher::readEvents(Uint64 now)
+{
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            auto it = m_directories.find(event->wd);
+            if (it == m_directories.end() || event->len == 0) continue;
+            std::string path = it->second + "/" + event->name;
+
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) addWatch(path);
+                continue;
+            }
+
+            // Only shaders, editors touch swap and backup files as well
+            if (fs::path(path).extension() != ".frag") continue;
+            if (!(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) continue;
+
+            PendingChange& change = m_pendingChanges[path];
+            if (change.firstEventNs == 0) change.firstEventNs = now;
+            change.lastEventNs = now;
+        }
+    }
+}
+
+std::vector<ShaderFileChange> ShaderWatcher::poll()
+{
+    std::vector<ShaderFileChange> changes;
+    if (m_fd < 0) return changes;
+
+    Uint64 now = SDL_GetTicksNS();
+    readEvents(now);
+
+    for (auto it = m_pendingChanges.begin(); it != m_pendingChanges.end();) {
+        if (now - it->second.lastEventNs >= DEBOUNCE_NS) {
+            changes.push_back({it->first, it->second.firstEventNs});
+            it = m_pendingChanges.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    return changes;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Shader file that was written and then left alone for the debounce time
+struct ShaderFileChange {
+    std::string path;               // canonical
+    Uint64 changeTimeNs = 0;        // first write of the burst (SDL_GetTicksNS)
+};
+
+struct ShaderReloadStats {
+    int reloads = 0;
+    int failed = 0;
+    double lastLatencyMs = 0.0;     // file write -> first frame rendered with the new program
+    double maxLatencyMs = 0.0;
+};
+
+// Watches shader directories and their subdirectories with inotify. Editors save in
+// bursts (truncate and write, or write a temporary file and rename it), so a file is
+// only reported once no further event arrived for DEBOUNCE_NS.
+// Non blocking, poll() is called from the main loop.
+class ShaderWatcher
+{
+public:
+    static constexpr Uint64 DEBOUNCE_NS = 150 * 1000000ull;
+
+    ShaderWatcher() = default;
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+public:
+    bool start(const std::vector<std::string>& directories);
+    void stop();
+    bool isRunning() const { return m_fd >= 0; }
+
+    // Changes that settled since the last call
+    std::vector<ShaderFileChange> poll();
+
+private:
+    struct PendingChange {
+        Uint64 firstEventNs = 0;
+        Uint64 lastEventNs = 0;
+    };
+
+    void addWatch(const std::string& directory);
+    void readEvents(Uint64 now);
+
+private:
+    int m_fd = -1;
+    std::map<int, std::string> m_directories;   // watch descriptor -> directory
+    std::map<std::string, PendingChange> m_pendingChanges;
+};
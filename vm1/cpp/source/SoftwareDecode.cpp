@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "SoftwareDecode.h"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+const char* decodeRouteName(DecodeRoute route)
+{
+    switch (route) {
+        case DecodeRoute::Hardware:
+            return "hardware";
+        case DecodeRoute::Software:
+            return "software";
+        default:
+            return "none";
+    }
+}
+
+DecodeRoute selectDecodeRoute(const AVCodecParameters* codecpar)
+{
+    if (codecpar->codec_type != AVMEDIA_TYPE_VIDEO) return DecodeRoute::None;
+
+    if (codecpar->width == 1920 &&
+        codecpar->height == 1080 &&
+        codecpar->codec_id == AV_CODEC_ID_HEVC &&
+        (codecpar->format == AV_PIX_FMT_YUV420P || codecpar->format == AV_PIX_FMT_YUVJ420P) &&
+        codecpar->color_space != AVCOL_SPC_BT2020_NCL &&
+        codecpar->color_space != AVCOL_SPC_BT2020_CL) {
+        return DecodeRoute::Hardware;
+    }
+
+    if (codecpar->width <= 0 || codecpar->height <= 0) return DecodeRoute::None;
+    if (!avcodec_find_decoder(codecpar->codec_id)) return DecodeRoute::None;
+    return DecodeRoute::Software;
+}
+
+DecodeBudget& DecodeBudget::instance()
+{
+    static DecodeBudget s_instance;
+    return s_instance;
+}
+
+void DecodeBudget::setThreadLimit(int threads)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_threadLimit = std::max(threads, 0);
+}
+
+int DecodeBudget::threadLimit() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_threadLimit;
+}
+
+int DecodeBudget::usedThreads() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_usedThreads;
+}
+
+int DecodeBudget::acquire(int wanted)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int granted = std::clamp(m_threadLimit - m_usedThreads, 0, wanted);
+    m_usedThreads += granted;
+    return granted;
+}
+
+void DecodeBudget::release(int threads)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_usedThreads = std::max(m_usedThreads - threads, 0);
+}
+
+AVCodecContext* openSoftwareDecoder(const AVStream* stream, int threads)
+{
+    const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "No software decoder for %s", avcodec_get_name(stream->codecpar->codec_id));
+        return nullptr;
+    }
+
+    AVCodecContext* context = avcodec_alloc_context3(codec);
+    if (!context) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "avcodec_alloc_context3 failed");
+        return nullptr;
+    }
+
+    if (avcodec_parameters_to_context(context, stream->codecpar) < 0) {
+        avcodec_free_context(&context);
+        return nullptr;
+    }
+    context->pkt_timebase = stream->time_base;
+
+    // Frame threads scale best for long GOP codecs, slices are used where a codec only supports those
+    context->thread_count = std::max(threads, 1);
+    context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+    if (avcodec_open2(context, codec, nullptr) < 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't open software decoder %s", codec->name);
+        avcodec_free_context(&context);
+        return nullptr;
+    }
+
+    SDL_Log("Software decoder %s %dx%d %s, %d threads\n", codec->name, context->width, context->height,
+            av_get_pix_fmt_name(context->pix_fmt), context->thread_count);
+    return context;
+}
+
+SoftwareFramePool::SoftwareFramePool()
+{
+    for (auto& frame : m_frames) {
+        frame = av_frame_alloc();
+    }
+}
+
+SoftwareFramePool::~SoftwareFramePool()
+{
+    for (auto& frame : m_frames) {
+        av_frame_free(&frame);
+    }
+    if (m_swsContext) {
+        sws_freeContext(m_swsContext);
+        m_swsContext = nullptr;
+    }
+}
+
+int SoftwareFramePool::store(const AVFrame* decoded, const std::atomic<bool>& isRunning)
+{
+    // Wait for the main thread to upload one
+    int slot = -1;
+    while (slot < 0) {
+        for (int i = 0; i < SLOT_COUNT; ++i) {
+            if (!m_isInUse[i].load(std::memory_order_acquire)) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot >= 0) break;
+        if (!isRunning) return -1;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    AVFrame* frame = m_frames[slot];
+    if (!frame) return -1;
+
+    if (decoded->format == AV_PIX_FMT_YUV420P || decoded->format == AV_PIX_FMT_YUVJ420P) {
+        av_frame_unref(frame);
+        m_isConverted[slot] = false;
+        if (av_frame_ref(frame, decoded) < 0) return -1;
+    }
+    else {
+        if (!m_isConverted[slot]) av_frame_unref(frame);
+        m_isConverted[slot] = true;
+        if (!convert(decoded, frame)) return -1;
+        m_stats.convertedFrames++;
+    }
+
+    m_stats.frames++;
+    m_isInUse[slot].store(true, std::memory_order_release);
+    return slot;
+}
+
+bool SoftwareFramePool::convert(const AVFrame* decoded, AVFrame* converted)
+{
+    m_swsContext = sws_getCachedContext(m_swsContext,
+                                        decoded->width, decoded->height, AVPixelFormat(decoded->format),
+                                        decoded->width, decoded->height, AV_PIX_FMT_YUV420P,
+                                        SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!m_swsContext) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "No conversion from %s", av_get_pix_fmt_name(AVPixelFormat(decoded->format)));
+        return false;
+    }
+
+    // The slot keeps its own buffer while the size stays the same
+    if (converted->format != AV_PIX_FMT_YUV420P ||
+        converted->width != decoded->width ||
+        converted->height != decoded->height ||
+        !converted->buf[0]) {
+        av_frame_unref(converted);
+        converted->format = AV_PIX_FMT_YUV420P;
+        converted->width = decoded->width;
+        converted->height = decoded->height;
+        if (av_frame_get_buffer(converted, 0) < 0) return false;
+    }
+
+    sws_scale(m_swsContext, decoded->data, decoded->linesize, 0, decoded->height, converted->data, converted->linesize);
+    return true;
+}
+
+const AVFrame* SoftwareFramePool::frame(int slot) const
+{
+    if (slot < 0 || slot >= SLOT_COUNT) return nullptr;
+    return m_frames[slot];
+}
+
+void SoftwareFramePool::release(int slot)
+{
+    if (slot < 0 || slot >= SLOT_COUNT) return;
+
+    // Referenced decoder buffers go back to the decoder right away, converted ones are reused
+    if (!m_isConverted[slot] && m_frames[slot]) av_frame_unref(m_frames[slot]);
+    m_isInUse[slot].store(false, std::memory_order_release);
+}
+
+void SoftwareFramePool::clear()
+{
+    for (int i = 0; i < SLOT_COUNT; ++i) {
+        if (m_frames[i]) av_frame_unref(m_frames[i]);
+        m_isConverted[i] = false;
+        m_isInUse[i].store(false, std::memory_order_release);
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+// How the frames of a video file get decoded, chosen per file from the probed stream
+enum class DecodeRoute {
+    None,
+    Hardware,   // DRM PRIME decoder, SAND128 buffers imported as EGL images
+    Software    // frame threaded libav decoder, YUV 4:2:0 planes uploaded to textures
+};
+
+const char* decodeRouteName(DecodeRoute route);
+
+// The hardware route only takes what the SAND128 conversion handles (1080p 8 bit 4:2:0
+// HEVC that is not BT.2020), everything else libav can decode takes the software route
+DecodeRoute selectDecodeRoute(const AVCodecParameters* codecpar);
+
+// Process-wide limit of the decoder threads all software decoded clips use together,
+// so they can't starve the main thread and the hardware decoded layers
+class DecodeBudget
+{
+public:
+    static DecodeBudget& instance();
+
+    DecodeBudget(const DecodeBudget&) = delete;
+    DecodeBudget& operator=(const DecodeBudget&) = delete;
+
+public:
+    // Only affects clips opened afterwards
+    void setThreadLimit(int threads);
+    int threadLimit() const;
+    int usedThreads() const;
+
+    // Grants up to wanted threads, 0 when the budget is used up (the clip then
+    // decodes single threaded, it is never refused)
+    int acquire(int wanted);
+    void release(int threads);
+
+private:
+    DecodeBudget() = default;
+
+private:
+    mutable std::mutex m_mutex;
+    int m_threadLimit = 2;
+    int m_usedThreads = 0;
+};
+
+// Opens a frame threaded software decoder for the stream with the given thread count
+AVCodecContext* openSoftwareDecoder(const AVStream* stream, int threads);
+
+struct SoftwareFrameStats {
+    uint64_t frames = 0;
+    uint64_t convertedFrames = 0;   // went through swscale
+};
+
+// Decoded pictures handed from the decoder thread to the main thread. Planar 8 bit
+// 4:2:0 frames are only referenced, everything else is converted with swscale.
+// The decoder thread fills a free slot, the main thread uploads it and releases it.
+class SoftwareFramePool
+{
+public:
+    // FrameRing capacity, the frame being uploaded and the one being decoded
+    static constexpr int SLOT_COUNT = 5;
+
+    SoftwareFramePool();
+    ~SoftwareFramePool();
+
+    SoftwareFramePool(const SoftwareFramePool&) = delete;
+    SoftwareFramePool& operator=(const SoftwareFramePool&) = delete;
+
+public:
+    // Decoder thread. Waits for a free slot while isRunning, returns the slot or -1.
+    int store(const AVFrame* decoded, const std::atomic<bool>& isRunning);
+    // Main thread
+    const AVFrame* frame(int slot) const;
+    void release(int slot);
+    // Only while the decoder thread is stopped
+    void clear();
+
+    const SoftwareFrameStats& stats() const { return m_stats; }
+
+private:
+    bool convert(const AVFrame* decoded, AVFrame* converted);
+
+private:
+    std::array<AVFrame*, SLOT_COUNT> m_frames = {};
+    std::array<std::atomic<bool>, SLOT_COUNT> m_isInUse = {};
+    std::array<bool, SLOT_COUNT> m_isConverted = {};   // owns its buffer instead of referencing the decoder's
+    SwsContext* m_swsContext = nullptr;
+    SoftwareFrameStats m_stats;
+};
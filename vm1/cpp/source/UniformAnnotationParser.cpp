@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "UniformAnnotationParser.h"
+
+// Same classes as \s, \w and the line terminators of ECMAScript regular expressions
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static bool isWordChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+static bool isLineTerminator(char c)
+{
+    return c == '\n' || c == '\r';
+}
+
+static size_t skipSpaces(std::string_view source, size_t pos)
+{
+    while (pos < source.size() && isSpace(source[pos])) ++pos;
+    return pos;
+}
+
+static size_t skipWord(std::string_view source, size_t pos)
+{
+    while (pos < source.size() && isWordChar(source[pos])) ++pos;
+    return pos;
+}
+
+// Matches "<type> <name> ; // {...}" at pos, returns the end of the match or 0
+static size_t matchDeclaration(std::string_view source, size_t pos, UniformAnnotation& annotation)
+{
+    size_t typeEnd = skipWord(source, pos);
+    if (typeEnd == pos) return 0;
+
+    size_t nameBegin = skipSpaces(source, typeEnd);
+    if (nameBegin == typeEnd) return 0;
+    size_t nameEnd = skipWord(source, nameBegin);
+    if (nameEnd == nameBegin) return 0;
+
+    size_t i = skipSpaces(source, nameEnd);
+    if (i >= source.size() || source[i] != ';') return 0;
+    i = skipSpaces(source, i + 1);
+    if (i + 1 >= source.size() || source[i] != '/' || source[i + 1] != '/') return 0;
+    i = skipSpaces(source, i + 2);
+    if (i >= source.size() || source[i] != '{') return 0;
+
+    // Greedy up to the last closing brace of the line
+    size_t jsonBegin = i;
+    size_t jsonEnd = 0;
+    for (++i; i < source.size() && !isLineTerminator(source[i]); ++i) {
+        if (source[i] == '}') jsonEnd = i + 1;
+    }
+    if (jsonEnd == 0) return 0;
+
+    annotation.type = source.substr(pos, typeEnd - pos);
+    annotation.name = source.substr(nameBegin, nameEnd - nameBegin);
+    annotation.json = source.substr(jsonBegin, jsonEnd - jsonBegin);
+    return jsonEnd;
+}
+
+size_t scanUniformAnnotations(std::string_view source, std::vector<UniformAnnotation>& annotations)
+{
+    static constexpr std::string_view UNIFORM_KEYWORD = "uniform";
+
+    size_t count = 0;
+    size_t lineBegin = 0;
+    while (lineBegin < source.size()) {
+        size_t pos = skipSpaces(source, lineBegin);
+        size_t matchEnd = 0;
+        UniformAnnotation annotation;
+
+        // The keyword is optional, "uniform x; // {}" still declares a parameter x of type "uniform"
+        if (source.substr(pos, UNIFORM_KEYWORD.size()) == UNIFORM_KEYWORD) {
+            size_t keywordEnd = pos + UNIFORM_KEYWORD.size();
+            size_t typeBegin = skipSpaces(source, keywordEnd);
+            if (typeBegin > keywordEnd) matchEnd = matchDeclaration(source, typeBegin, annotation);
+        }
+        if (matchEnd == 0) matchEnd = matchDeclaration(source, pos, annotation);
+
+        size_t searchFrom = lineBegin;
+        if (matchEnd > 0) {
+            annotations.push_back(annotation);
+            count++;
+            searchFrom = matchEnd;
+        }
+
+        // Next line start at or after searchFrom
+        while (searchFrom < source.size() && !isLineTerminator(source[searchFrom])) ++searchFrom;
+        lineBegin = searchFrom + 1;
+    }
+
+    return count;
+}
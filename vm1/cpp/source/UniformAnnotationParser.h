@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+// Annotated uniform in a shader source, the views point into the scanned source
+struct UniformAnnotation {
+    std::string_view type;
+    std::string_view name;
+    std::string_view json;      // "{...}", not validated
+};
+
+// Single pass scanner for parameter annotations like
+//
+//   uniform float ChromaKey_Threshold; // {"name": "Threshold", "default": 0.4}
+//   float ColorCorrection_Gamma; // {...}     (member of a uniform block)
+//
+// Matches exactly what the former regex ^\s*(?:uniform\s+)?(\w+)\s+(\w+)\s*;\s*//\s*(\{.*\})
+// (multiline) matched: the annotation runs from the first '{' to the last '}' of its line.
+// Appends to annotations, returns the number of annotations found.
+size_t scanUniformAnnotations(std::string_view source, std::vector<UniformAnnotation>& annotations);
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "UniformBlockBuffer.h"
+
+#include <cstring>
+
+UniformBlockBuffer::~UniformBlockBuffer()
+{
+    finalize();
+}
+
+void UniformBlockBuffer::initialize(Shader& shader)
+{
+    finalize();
+
+    for (const UniformBlockInfo& blockInfo : shader.uniformBlocks()) {
+        Block block;
+        block.binding = blockInfo.index;
+        block.data.resize(blockInfo.dataSize, 0);
+
+        glGenBuffers(1, &block.buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, block.buffer);
+        glBufferData(GL_UNIFORM_BUFFER, blockInfo.dataSize, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        shader.setUniformBlockBinding(blockInfo.index, block.binding);
+        m_blocks.push_back(std::move(block));
+    }
+}
+
+void UniformBlockBuffer::finalize()
+{
+    for (Block& block : m_blocks) {
+        glDeleteBuffers(1, &block.buffer);
+    }
+    m_blocks.clear();
+    m_slots.clear();
+    m_layoutId = 0;
+}
+
+void UniformBlockBuffer::resolveSlots(const Shader& shader, const ShaderConfig& shaderConfig)
+{
+    m_slots.assign(shaderConfig.names.size(), Slot());
+    for (size_t i = 0; i < shaderConfig.names.size(); ++i) {
+        GLuint blockIndex = 0;
+        GLint offset = 0;
+        if (!shader.uniformBlockMember(shaderConfig.names[i], blockIndex, offset)) continue;
+        if (blockIndex >= m_blocks.size()) continue;
+
+        // Whole value has to fit into the block
+        size_t size = (shaderConfig.values[i].type == ShaderParamType::Vec2) ? 2 * sizeof(float) : sizeof(float);
+        if (offset + size > m_blocks[blockIndex].data.size()) continue;
+
+        m_slots[i].block = int(blockIndex);
+        m_slots[i].offset = offset;
+    }
+    m_layoutId = shaderConfig.layoutId;
+}
+
+void UniformBlockBuffer::update(const Shader& shader, const ShaderConfig& shaderConfig)
+{
+    if (m_blocks.empty()) return;
+    if (shaderConfig.layoutId != m_layoutId) resolveSlots(shader, shaderConfig);
+
+    for (size_t blockIndex = 0; blockIndex < m_blocks.size(); ++blockIndex) {
+        Block& block = m_blocks[blockIndex];
+        m_packed = block.data;
+
+        for (size_t i = 0; i < m_slots.size(); ++i) {
+            if (m_slots[i].block != int(blockIndex)) continue;
+
+            const ShaderParamValue& value = shaderConfig.values[i];
+            uint8_t* dst = m_packed.data() + m_slots[i].offset;
+            switch (value.type) {
+                case ShaderParamType::Int:
+                    memcpy(dst, &value.intValue, sizeof(int));
+                    break;
+                case ShaderParamType::Float:
+                    memcpy(dst, &value.floatValue.x, sizeof(float));
+                    break;
+                case ShaderParamType::Vec2:
+                    memcpy(dst, &value.floatValue.x, sizeof(float));
+                    memcpy(dst + sizeof(float), &value.floatValue.y, sizeof(float));
+                    break;
+            }
+        }
+
+        if (block.isUploaded && m_packed == block.data) {
+            m_stats.unchangedUpdates++;
+            continue;
+        }
+
+        block.data.swap(m_packed);
+        glBindBuffer(GL_UNIFORM_BUFFER, block.buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, block.data.size(), block.data.data());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        block.isUploaded = true;
+        m_stats.uploads++;
+    }
+}
+
+void UniformBlockBuffer::bind()
+{
+    for (const Block& block : m_blocks) {
+        glBindBufferBase(GL_UNIFORM_BUFFER, block.binding, block.buffer);
+    }
+}
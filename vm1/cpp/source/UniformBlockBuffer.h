@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include "Shader.h"
+#include "ShaderConfig.h"
+
+#include <GLES3/gl3.h>
+
+#include <cstdint>
+#include <vector>
+
+struct UniformBlockStats {
+    uint64_t uploads = 0;
+    uint64_t unchangedUpdates = 0;
+};
+
+// One uniform buffer per std140 block of a shader, filled from the values of a
+// ShaderConfig. The values are packed into a CPU copy first, the buffer is only
+// uploaded when the packed bytes differ from what the GPU already has.
+class UniformBlockBuffer
+{
+public:
+    UniformBlockBuffer() = default;
+    ~UniformBlockBuffer();
+
+    UniformBlockBuffer(const UniformBlockBuffer&) = delete;
+    UniformBlockBuffer& operator=(const UniformBlockBuffer&) = delete;
+
+public:
+    // Creates the buffers for all blocks of the (linked) shader and assigns their binding points
+    void initialize(Shader& shader);
+    void finalize();
+    bool isEmpty() const { return m_blocks.empty(); }
+
+    // Packs the block members of the config, the layout is cached per ShaderConfig::layoutId
+    void update(const Shader& shader, const ShaderConfig& shaderConfig);
+    void bind();
+
+    const UniformBlockStats& stats() const { return m_stats; }
+
+private:
+    struct Block {
+        GLuint buffer = 0;
+        GLuint binding = 0;
+        std::vector<uint8_t> data;
+        bool isUploaded = false;
+    };
+
+    // Where a config value goes, in config order
+    struct Slot {
+        int block = -1;
+        GLint offset = 0;
+    };
+
+    void resolveSlots(const Shader& shader, const ShaderConfig& shaderConfig);
+
+private:
+    std::vector<Block> m_blocks;
+    std::vector<Slot> m_slots;
+    std::vector<uint8_t> m_packed;
+    uint64_t m_layoutId = 0;
+    UniformBlockStats m_stats;
+};
@@ -10,6 +10,8 @@
 #include "VM1Application.h"
 #include "VM1DeviceDefinitions.h"
 #include "CaptureType.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderLibrary.h"
 #include "ili9341/ILI9341.h"
 
 #include <kms++/card.h>
@@ -78,6 +80,8 @@ void VM1Application::subscribeToEvents()
 bool VM1Application::initialize()
 {
     initializeVideo();
+    ProgramBinaryCache::instance().logReport();
+    ShaderLibrary::instance().logReport();
     
     if (m_isHeadless) m_keyboardHotplug.start();
 
@@ -549,6 +553,194 @@ void VM1Application::renderImGui()
             }
             ImGuiIO &io = ImGui::GetIO();
             ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+            if (ImGui::CollapsingHeader("Culling")) {
+                const CullingStats& stats = m_playbackOperator.cullingStats();
+                ImGui::Text("Invisible players: %d (%lu player frames skipped)", stats.culledPlayers, (unsigned long)stats.culledPlayerFrames);
+                ImGui::Text("Invisible planes: %d (%lu plane draws skipped)", stats.culledPlanes, (unsigned long)stats.culledPlaneDraws);
+            }
+            if (ImGui::CollapsingHeader("Shader Programs")) {
+                const ShaderLibraryStats& libraryStats = ShaderLibrary::instance().stats();
+                ImGui::Text("Shared programs: %zu resident, %d requests, %d shared", ShaderLibrary::instance().residentPrograms(), libraryStats.requests, libraryStats.sharedPrograms);
+                ImGui::Text("Saved by sharing: %.2f ms, %.1f KB", libraryStats.savedMs, libraryStats.savedBytes / 1024.0);
+                const ShaderCompiler& shaderCompiler = m_playbackOperator.shaderCompiler();
+                const ShaderCompilerStats& compilerStats = shaderCompiler.stats();
+                ImGui::Text("Background compiler: %s, %d pending", shaderCompiler.isAsync() ? "shared context" : "main thread", shaderCompiler.pendingRequests());
+                ImGui::Text("Compiled: %d (last %.2f ms, max %.2f ms), failed: %d", compilerStats.compiled, compilerStats.lastCompileMs, compilerStats.maxCompileMs, compilerStats.failed);
+                ImGui::Checkbox("Hot reload changed shader files", &m_registry.settings().useShaderHotReload);
+                const ShaderReloadStats& reloadStats = m_playbackOperator.shaderReloadStats();
+                ImGui::Text("Hot reloads: %d, failed: %d, write to first frame: last %.1f ms, max %.1f ms", reloadStats.reloads, reloadStats.failed, reloadStats.lastLatencyMs, reloadStats.maxLatencyMs);
+                for (const auto& record : ProgramBinaryCache::instance().records()) {
+                    ImGui::Text("%-8s %8.2f ms  %s", record.isCacheHit ? "cached" : "compiled", record.ms, record.name.c_str());
+                }
+            }
+            if (ImGui::CollapsingHeader("Uniforms")) {
+                ImGui::Checkbox("Cache uniform locations and values", &m_registry.settings().useUniformCache);
+                ImGui::Text("renderPlane CPU time cached: %.3f ms", m_playbackOperator.renderPlaneCpuMs(true));
+                ImGui::Text("renderPlane CPU time uncached: %.3f ms", m_playbackOperator.renderPlaneCpuMs(false));
+                UniformBlockStats blockStats = m_playbackOperator.uniformBlockStats();
+                ImGui::Text("Effect parameter blocks: %lu uploads, %lu unchanged", (unsigned long)blockStats.uploads, (unsigned long)blockStats.unchangedUpdates);
+                ColorLutStats lutStats = m_playbackOperator.colorLutStats();
+                ImGui::Text("Color LUT bakes: %lu, slowest last bake %.2f ms", (unsigned long)lutStats.bakes, lutStats.lastBakeMs);
+            }
+            if (ImGui::CollapsingHeader("Compositor")) {
+                Settings& settings = m_registry.settings();
+                ImGui::Checkbox("Composite planes in a single pass", &settings.useSinglePassCompositor);
+                const CompositorStats& compositorStats = m_playbackOperator.compositorStats();
+                ImGui::Text("Composited planes: %d, drawn one by one (effects): %d, passes: %lu",
+                            compositorStats.compositedPlanes, compositorStats.fallbackPlanes, (unsigned long)compositorStats.passes);
+                ImGui::Checkbox("Measure GPU times##compositor", &settings.measureGpuTimes);
+                if (settings.measureGpuTimes) {
+                    const GpuTimer& perPlaneTimer = m_playbackOperator.planeTimer(false);
+                    const GpuTimer& singlePassTimer = m_playbackOperator.planeTimer(true);
+                    ImGui::Text("Planes per output: one by one %.3f ms  single pass %.3f ms%s",
+                                perPlaneTimer.averageMs(),
+                                singlePassTimer.averageMs(),
+                                perPlaneTimer.usesTimerQuery() ? "" : " (glFinish)");
+                }
+            }
+            if (ImGui::CollapsingHeader("Render Targets")) {
+                const RenderTargetPoolStats& stats = m_playbackOperator.renderTargetPool().stats();
+                const double mb = 1024.0 * 1024.0;
+                size_t unpooledBytes = m_playbackOperator.mediaPlayerCount() * RenderTargetPool::bytesPerTarget(1920, 1080);
+                ImGui::Text("Leased: %zu of %zu targets, %.1f MB (peak %.1f MB)", stats.leasedCount, stats.targetCount, stats.leasedBytes / mb, stats.peakLeasedBytes / mb);
+                ImGui::Text("Resident: %.1f MB (peak %.1f MB)", stats.residentBytes / mb, stats.peakResidentBytes / mb);
+                ImGui::Text("One target per player would be: %.1f MB", unpooledBytes / mb);
+            }
+            if (ImGui::CollapsingHeader("Video Conversion")) {
+                Settings& settings = m_registry.settings();
+                ImGui::Checkbox("Single-pass SAND128 conversion", &settings.useSinglePassVideoConversion);
+                ImGui::Checkbox("Sample YUV directly in planes", &settings.useDirectPlaneSampling);
+                ImGui::Text("Players without RGB pass: %d", m_playbackOperator.directPlayerCount());
+                ImGui::Checkbox("Measure GPU times", &settings.measureGpuTimes);
+                if (settings.measureGpuTimes) {
+                    const auto& videoPlayers = m_playbackOperator.videoPlayers();
+                    for (size_t i = 0; i < videoPlayers.size(); ++i) {
+                        const GpuTimer& stripTimer = videoPlayers[i]->conversionTimer(false);
+                        const GpuTimer& singlePassTimer = videoPlayers[i]->conversionTimer(true);
+                        if (stripTimer.samples() == 0 && singlePassTimer.samples() == 0) continue;
+                        ImGui::Text("Video %zu: strips %.3f ms  single pass %.3f ms%s",
+                                    i,
+                                    stripTimer.averageMs(),
+                                    singlePassTimer.averageMs(),
+                                    stripTimer.usesTimerQuery() ? "" : " (glFinish)");
+                    }
+                }
+            }
+            if (ImGui::CollapsingHeader("Decode Routes")) {
+                Settings& settings = m_registry.settings();
+                ImGui::SliderInt("Software decode threads", &settings.softwareDecodeThreads, 1, 8);
+                ImGui::Text("Budget: %d of %d threads in use", DecodeBudget::instance().usedThreads(), DecodeBudget::instance().threadLimit());
+                const auto& videoPlayers = m_playbackOperator.videoPlayers();
+                for (size_t i = 0; i < videoPlayers.size(); ++i) {
+                    DecodeRoute route = videoPlayers[i]->decodeRoute();
+                    if (route == DecodeRoute::None) continue;
+                    const SoftwareFrameStats& stats = videoPlayers[i]->softwareFrameStats();
+                    ImGui::Text("Video %zu: %s, threads %d  frames %lu  converted %lu",
+                                i,
+                                decodeRouteName(route),
+                                videoPlayers[i]->softwareDecodeThreads(),
+                                (unsigned long)stats.frames,
+                                (unsigned long)stats.convertedFrames);
+                }
+            }
+            if (ImGui::CollapsingHeader("Seeking")) {
+                Settings& settings = m_registry.settings();
+                ImGui::Checkbox("Use keyframe index", &settings.useKeyframeIndex);
+                const auto& videoPlayers = m_playbackOperator.videoPlayers();
+                for (size_t i = 0; i < videoPlayers.size(); ++i) {
+                    const SeekStats& stats = videoPlayers[i]->seekStats();
+                    if (stats.indexedSeeks + stats.searchedSeeks + stats.unfinishedIndexedSeeks + stats.unfinishedSearchedSeeks == 0) continue;
+                    ImGui::Text("Video %zu: %s", i, videoPlayers[i]->hasKeyframeIndex() ? "indexed" : "no index");
+                    ImGui::Text("  indexed %lu (+%lu unfinished), last %.1f ms, avg %.1f ms, dropped %lu (predicted %lu)",
+                                (unsigned long)stats.indexedSeeks, (unsigned long)stats.unfinishedIndexedSeeks,
+                                double(stats.lastIndexedMs), double(stats.averageIndexedMs),
+                                (unsigned long)stats.indexedDiscardedFrames, (unsigned long)stats.predictedFrames);
+                    ImGui::Text("  searched %lu (+%lu unfinished), last %.1f ms, avg %.1f ms, dropped %lu",
+                                (unsigned long)stats.searchedSeeks, (unsigned long)stats.unfinishedSearchedSeeks,
+                                double(stats.lastSearchedMs), double(stats.averageSearchedMs),
+                                (unsigned long)stats.searchedDiscardedFrames);
+                }
+            }
+            if (ImGui::CollapsingHeader("Demux")) {
+                const auto& videoPlayers = m_playbackOperator.videoPlayers();
+                for (size_t i = 0; i < videoPlayers.size(); ++i) {
+                    if (!videoPlayers[i]->isPlaying()) continue;
+                    const DemuxStats& demux = videoPlayers[i]->demuxStats();
+                    ImGui::Text("Video %zu: queued %zu KB, %lu packets, slowest read %.1f ms",
+                                i,
+                                size_t(demux.queuedBytes) >> 10,
+                                (unsigned long)demux.packets,
+                                double(demux.slowestReadMs));
+                    ImGui::Text("  decoder underruns %lu, longest wait %.1f ms",
+                                (unsigned long)demux.underruns, double(demux.longestWaitMs));
+                    if (videoPlayers[i]->isReadingAhead()) {
+                        const ReadAheadStats& readAhead = videoPlayers[i]->readAheadStats();
+                        ImGui::Text("  read-ahead: %lu chunks, %lu MB, slowest %.1f ms",
+                                    (unsigned long)readAhead.chunkReads,
+                                    (unsigned long)(readAhead.bytesRead >> 20),
+                                    double(readAhead.slowestReadMs));
+                    }
+                }
+            }
+            if (ImGui::CollapsingHeader("Loop Cache")) {
+                Settings& settings = m_registry.settings();
+                ImGui::Checkbox("Use loop cache", &settings.useLoopCache);
+                ImGui::SliderInt("Budget (MB)", &settings.loopCacheMegabytes, 0, 1024);
+                ImGui::Text("Reserved: %zu of %zu MB",
+                            LoopCacheBudget::instance().usedBytes() >> 20, LoopCacheBudget::instance().limit() >> 20);
+                const auto& videoPlayers = m_playbackOperator.videoPlayers();
+                for (size_t i = 0; i < videoPlayers.size(); ++i) {
+                    const LoopCacheStats& stats = videoPlayers[i]->loopCacheStats();
+                    if (stats.decodedPasses + stats.cachedPasses == 0) continue;
+                    const LoopFrameCache& cache = videoPlayers[i]->loopCache();
+                    ImGui::Text("Video %zu: %s, %zu frames (%zu MB), decoder load %.0f%%, decoded %lu frames",
+                                i,
+                                videoPlayers[i]->isPlayingFromLoopCache() ? "cached" : (cache.isRecording() ? "recording" : "decoding"),
+                                cache.frameCount(),
+                                cache.residentBytes() >> 20,
+                                100.0 * stats.decoderLoad,
+                                (unsigned long)stats.decodedFrames);
+                    ImGui::Text("  passes: decoded %lu, cached %lu, frame %.1f ms, loop point: last %.1f ms, avg %.1f ms, worst %.1f ms",
+                                (unsigned long)stats.decodedPasses, (unsigned long)stats.cachedPasses,
+                                stats.averageFrameMs, stats.lastBoundaryMs, stats.averageBoundaryMs, stats.worstBoundaryMs);
+                }
+            }
+            if (ImGui::CollapsingHeader("Pre-roll")) {
+                Settings& settings = m_registry.settings();
+                const PrerollStats& stats = m_playbackOperator.prerollStats();
+                ImGui::SliderInt("Pre-rolled slots", &settings.prerollSlots, 0, int(m_playbackOperator.videoPlayers().size()) / 2);
+                ImGui::Text("Holding their first frame: %d", stats.prerolledPlayers);
+                ImGui::Text("Warm triggers: %lu, to first frame: last %.1f ms, avg %.1f ms",
+                            (unsigned long)stats.warmTriggers, stats.lastWarmMs, stats.averageWarmMs);
+                ImGui::Text("Cold triggers: %lu, to first frame: last %.1f ms, avg %.1f ms",
+                            (unsigned long)stats.coldTriggers, stats.lastColdMs, stats.averageColdMs);
+            }
+            if (ImGui::CollapsingHeader("Shader Players")) {
+                const auto& shaderPlayers = m_playbackOperator.shaderPlayers();
+                for (size_t i = 0; i < shaderPlayers.size(); ++i) {
+                    const ShaderPlayerStats& stats = shaderPlayers[i]->stats();
+                    if (stats.renderedFrames == 0) continue;
+                    ImGui::Text("Shader %zu: %s, rendered %lu  skipped %lu  scale %.2f",
+                                i,
+                                shaderPlayers[i]->isTimeDependent() ? "animated" : "static",
+                                (unsigned long)stats.renderedFrames,
+                                (unsigned long)stats.skippedFrames,
+                                shaderPlayers[i]->renderScale());
+                }
+            }
+            if (ImGui::CollapsingHeader("EGLImage Cache")) {
+                const auto& videoPlayers = m_playbackOperator.videoPlayers();
+                for (size_t i = 0; i < videoPlayers.size(); ++i) {
+                    const auto& stats = videoPlayers[i]->imageCacheStats();
+                    if (stats.frames == 0) continue;
+                    ImGui::Text("Video %zu: hits %lu  misses %lu  invalidations %lu  eglCreateImage/frame %.2f",
+                                i,
+                                (unsigned long)stats.hits,
+                                (unsigned long)stats.misses,
+                                (unsigned long)stats.invalidations,
+                                double(stats.createdImages) / double(stats.frames));
+                }
+            }
             ImGui::End();
         }
         {
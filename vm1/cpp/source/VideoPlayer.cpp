@@ -12,12 +12,17 @@
 
 #include "source/GLHelper.h"
 #include "source/VideoPlayer.h"
+#include "source/AllocationCounter.h"
 
 #include <SDL3/SDL_opengl.h>
 #include <SDL3/SDL_opengles2.h>
 #include <EGL/eglext.h>
 #include <GLES3/gl31.h>
 
+#include <sys/stat.h>
+#include <algorithm>
+#include <cmath>
+
 #ifndef fourcc_code
 #define fourcc_code(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
 #endif
@@ -36,12 +41,23 @@ VideoPlayer::VideoPlayer()
     m_numberOfInputImages = 15;
     loadShaders();
     createVertexBuffers();
-    initializeFramebufferAndTextures();
+    initializeInputTextures();
+    m_boundImages.resize(m_yuvImages.size(), EGL_NO_IMAGE);
+    m_imageCache.reserve(MAX_IMAGE_CACHE_ENTRIES);
+
+    glGenTextures(1, &m_sandTexture);
+    glGenTextures(3, m_softwareTextures);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxTextureSize);
 }
 
 VideoPlayer::~VideoPlayer()
 {
     close();
+    if (m_sandTexture) {
+        glDeleteTextures(1, &m_sandTexture);
+        m_sandTexture = 0;
+    }
+    glDeleteTextures(3, m_softwareTextures);
 }
 
 void VideoPlayer::setInPoint(double value)
@@ -73,6 +89,19 @@ void VideoPlayer::reset()
     m_isFlushing = false;
     m_foundKeyframe = false;
     m_currentTime = 0.0;
+    m_hasPresentedFrame = false;
+    m_seekTargetPts = AV_NOPTS_VALUE;
+
+    clearLoopCache();
+    m_isLoopCacheRejected = false;
+    m_isAwaitingRestart = false;
+    m_isDecoderParked = false;
+    m_isRestartRequested = false;
+    m_loopCacheStats = LoopCacheStats();
+    m_lastPresentNs = 0;
+    m_decoderIdleNs = 0;
+    m_decodedFrames = 0;
+    m_loadWindowStartNs = 0;
 }
 
 void VideoPlayer::pause(bool isPaused) {
@@ -80,23 +109,61 @@ void VideoPlayer::pause(bool isPaused) {
         m_pauseStartTime = SDL_GetTicks();
     else if (!isPaused && m_isPaused)
         m_startTime += SDL_GetTicks() - m_pauseStartTime;
+    if (isPaused != m_isPaused) m_lastPresentNs = 0;    // no frame interval across the pause
     m_isPaused = isPaused;
 }
 
 
 void VideoPlayer::loadShaders()
 {
-    m_shader.load("shaders/video.vert", "shaders/video.frag");
+    m_shader = ShaderLibrary::instance().load("shaders/video.vert", "shaders/video.frag");
+    m_sandShader = ShaderLibrary::instance().load("shaders/pass.vert", "shaders/video_sand.frag");
+    m_yuvShader = ShaderLibrary::instance().load("shaders/pass.vert", "shaders/video_yuv420p.frag");
 }
 
 bool VideoPlayer::openFile(const std::string& fileName, AudioStream* audioStream)
 {
     close(); 
-    
+    return openStreams(fileName, audioStream);
+}
+
+void VideoPlayer::preroll(const std::string& fileName, AudioStream* audioStream)
+{
+    close();
+
+    // Same as play(), the decoder thread opens the file first so the main thread never waits for it
+    m_isHeld = true;
+    m_isPrerollOpened = false;
+    m_hasPrerollFailed = false;
+    reset();
+    m_audioQueue.setActive(true);
+    m_videoQueue.setActive(true);
+    m_isRunning = true;
+    m_decoderThread = std::thread([this, fileName, audioStream]() {
+        if (!openStreams(fileName, audioStream)) {
+            m_hasPrerollFailed = true;
+            m_isRunning = false;
+        }
+        m_isPrerollOpened = true;
+        if (m_isRunning) run();
+    });
+}
+
+bool VideoPlayer::openStreams(const std::string& fileName, AudioStream* audioStream)
+{
     // This is just for rtsp steams. Necessary?
     //AVDictionary* opts = NULL;
     //av_dict_set(&opts, "rtsp_transport", "tcp", 0);
 
+    // Files are read in large chunks with read-ahead hints, stream URLs by libavformat itself
+    if (m_readAheadFile.open(fileName)) {
+        m_formatContext = avformat_alloc_context();
+        if (m_formatContext) {
+            m_formatContext->pb = m_readAheadFile.ioContext();
+            m_formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+        }
+    }
+
     // Open the video file
     int result = avformat_open_input(&m_formatContext, fileName.c_str(), NULL, NULL);
     if (result < 0) {
@@ -113,15 +180,8 @@ bool VideoPlayer::openFile(const std::string& fileName, AudioStream* audioStream
     for (unsigned int i = 0; i < m_formatContext->nb_streams; i++) {
         AVStream *stream = m_formatContext->streams[i];
         AVCodecParameters *codecpar = stream->codecpar;
-        if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
-            codecpar->width == 1920 &&
-            codecpar->height == 1080 &&
-            codecpar->codec_id == AV_CODEC_ID_HEVC &&
-            (codecpar->format == AV_PIX_FMT_YUV420P || codecpar->format == AV_PIX_FMT_YUVJ420P) &&
-            codecpar->color_space != AVCOL_SPC_BT2020_NCL &&
-            codecpar->color_space != AVCOL_SPC_BT2020_CL
-        )
-        {
+        m_decodeRoute = selectDecodeRoute(codecpar);
+        if (m_decodeRoute != DecodeRoute::None) {
             foundStream = true;
             m_width = codecpar->width;
             m_height = codecpar->height;
@@ -133,19 +193,47 @@ bool VideoPlayer::openFile(const std::string& fileName, AudioStream* audioStream
     }
 
     if (!foundStream) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't find a valid HEVC/1080p video stream in file %s: %d", fileName.c_str(), result);
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't find a decodable video stream in file %s: %d", fileName.c_str(), result);
         return false;
     }
 
     m_videoStream = av_find_best_stream(m_formatContext, AVMEDIA_TYPE_VIDEO, -1, -1, &m_videoCodec, 0);
     if (m_videoStream >= 0) {
+        // Written by the media pool in the background, missing until the clip was indexed once
+        if (m_keyframeIndex.load(fileName) && m_keyframeIndex.streamIndex() != m_videoStream) {
+            m_keyframeIndex.clear();
+        }
+
         m_fps = av_q2d(m_formatContext->streams[m_videoStream]->avg_frame_rate);
         m_duration = m_formatContext->streams[m_videoStream]->duration * av_q2d(m_formatContext->streams[m_videoStream]->time_base);
 
-        m_videoContext = openVideoStream();
+        if (m_decodeRoute == DecodeRoute::Hardware) {
+            m_videoContext = openVideoStream();
+            if (!m_videoContext) {
+                SDL_Log("No hardware decoder for %s, falling back to software decoding\n", fileName.c_str());
+                m_decodeRoute = DecodeRoute::Software;
+            }
+        }
+
+        if (m_decodeRoute == DecodeRoute::Software) {
+            // An idle pre-roll would hold DecodeBudget threads a triggered clip needs
+            if (m_isHeld) {
+                SDL_Log("Not pre-rolling software decoded %s\n", fileName.c_str());
+                return false;
+            }
+            m_softwareThreads = DecodeBudget::instance().acquire(SOFTWARE_DECODE_THREADS);
+            if (m_softwareThreads == 0) {
+                // Still plays, decoded on the decoder thread alone without frame threading
+                SDL_Log("Software decoding budget used up (%d threads), decoding %s single threaded\n",
+                        DecodeBudget::instance().threadLimit(), fileName.c_str());
+            }
+            m_videoContext = openSoftwareDecoder(m_formatContext->streams[m_videoStream], std::max(m_softwareThreads, 1));
+        }
+
         if (!m_videoContext) {
             return false;
         }
+        SDL_Log("Decode route for %s: %s\n", fileName.c_str(), decodeRouteName(m_decodeRoute));
     }
 
     m_audioStream = av_find_best_stream(m_formatContext, AVMEDIA_TYPE_AUDIO, -1, m_videoStream, &m_audioCodec, 0);
@@ -180,6 +268,30 @@ bool VideoPlayer::openFile(const std::string& fileName, AudioStream* audioStream
 void VideoPlayer::close()
 {
     MediaPlayer::close();
+    m_isHeld = false;
+    m_isPrerollOpened = false;
+    if (alloccounter::isEnabled() && m_decodeAllocations.frames() > 0) {
+        SDL_Log("Steady-state frame handoff allocations: decoder %lu (%lu frames), main %lu (%lu frames)\n",
+                (unsigned long)m_decodeAllocations.allocations(), (unsigned long)m_decodeAllocations.frames(),
+                (unsigned long)m_renderAllocations.allocations(), (unsigned long)m_renderAllocations.frames());
+    }
+    m_decodeAllocations.reset();
+    m_renderAllocations.reset();
+    clearImageCache();
+    m_lastFramesContext = nullptr;
+
+    m_keyframeIndex.clear();
+    clearLoopCache();
+    m_isDecoderParked = false;
+
+    // The decoder thread has stopped, so no slot is written anymore
+    m_softwareFrames.clear();
+    m_hasSoftwareFrame = false;
+    if (m_softwareThreads > 0) {
+        DecodeBudget::instance().release(m_softwareThreads);
+        m_softwareThreads = 0;
+    }
+    m_decodeRoute = DecodeRoute::None;
     if (m_packet) {
         av_packet_free(&m_packet);
         m_packet = nullptr;
@@ -196,10 +308,13 @@ void VideoPlayer::close()
         avcodec_free_context(&m_videoContext);
         m_videoContext = nullptr;
     }
+    m_demuxThread.stop();
     if (m_formatContext) {
         avformat_close_input(&m_formatContext);
         m_formatContext = nullptr;
     }
+    // After the format context, it doesn't free a custom pb
+    m_readAheadFile.close();
 
     m_audioCodec = nullptr;
     m_videoCodec = nullptr;
@@ -266,6 +381,12 @@ AVCodecContext* VideoPlayer::openVideoStream()
         }
     }
 
+    // Without a device the frames wouldn't be DRM PRIME buffers
+    if (!context->hw_device_ctx) {
+        avcodec_free_context(&context);
+        return nullptr;
+    }
+
     /* Allow supported hardware accelerated pixel formats */
     context->get_format = getSupportedPixelFormat;
 
@@ -319,17 +440,43 @@ AVCodecContext* VideoPlayer::openAudioStream()
 
 void VideoPlayer::render()
 {
+    if (!acquireRenderTarget()) return;
+
     glViewport(0, 0, 1920, 1080);
     // TODO: resize framebuffer if necessary
-    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_renderTarget->frameBuffer);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
+    // Fall back to the strips while the current frame has no single pass image (e.g. right after switching)
+    // Cached hardware frames are SAND128 views, they always take the single pass
+    bool singlePass = m_cachedFrame || (m_useSinglePass && m_sandImage != EGL_NO_IMAGE);
+    GpuTimer& timer = singlePass ? m_singlePassTimer : m_stripTimer;
+
+    if (m_measureGpuTime) timer.begin();
+    if (m_decodeRoute == DecodeRoute::Software) {
+        renderSoftware();
+    }
+    else if (singlePass) {
+        renderSinglePass();
+    }
+    else {
+        renderStrips();
+    }
+    if (m_measureGpuTime) timer.end();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    m_isRgbOutputValid = true;
+}
+
+void VideoPlayer::renderStrips()
+{
     float stripCount = truncf((float(m_width) / 128.0f) + 0.5f); 
     //float stripCount = 15.0f;
 
-    m_shader.activate();
-    m_shader.setValue("stripWidthNDC", 2.0f/stripCount);
+    m_shader->activate();
+    m_shader->setValue("stripWidthNDC", 2.0f/stripCount);
 
     glBindVertexArray(m_vao);
     for (size_t i = 0; i < m_yuvTextures.size(); ++i) {
@@ -340,26 +487,290 @@ void VideoPlayer::render()
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-        // Bind the texture to unit
+        // Bind the texture to unit (the strip textures keep their image until the frame changes)
         if (m_yuvImages[i] != EGL_NO_IMAGE) {
-            GLHelper::glEGLImageTargetTexture2DOESFunc(GL_TEXTURE_2D, m_yuvImages[i]);
-            m_shader.bindUniformLocation("inputTexture", 0);
+            if (m_boundImages[i] != m_yuvImages[i]) {
+                GLHelper::glEGLImageTargetTexture2DOESFunc(GL_TEXTURE_2D, m_yuvImages[i]);
+                m_boundImages[i] = m_yuvImages[i];
+            }
+            m_shader->bindUniformLocation("inputTexture", 0);
         }
 
-        m_shader.setValue("stripId", static_cast<int>(i));
+        m_shader->setValue("stripId", static_cast<int>(i));
         glDrawArrays(GL_TRIANGLES, 0, 6);
     }
 
     glBindVertexArray(0);
-    m_shader.deactivate();
+    m_shader->deactivate();
+}
 
+void VideoPlayer::bindSandImage()
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_sandTexture);
+    if (m_boundSandImage != m_sandImage) {
+        GLHelper::glEGLImageTargetTexture2DOESFunc(GL_TEXTURE_2D, m_sandImage);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        m_boundSandImage = m_sandImage;
+    }
+}
+
+DirectSource VideoPlayer::nativeSource() const
+{
+    DirectSource source;
+    if (isOpeningPreroll() || m_decodeRoute != DecodeRoute::Hardware) return source;
+    if (!m_cachedFrame && m_sandImage == EGL_NO_IMAGE) return source;
+
+    source.type = DirectSourceType::Sand128;
+    source.texture = m_cachedFrame ? m_cachedFrame->textures[0] : m_sandTexture;
+    source.layout = glm::ivec4(m_sandLayout.viewWidth, m_sandLayout.columnHeight, m_sandLayout.lumaHeight, m_sandLayout.stripCount);
+    source.size = glm::vec2(float(m_width), float(m_height));
+    return source;
+}
+
+void VideoPlayer::renderSinglePass()
+{
+    if (m_cachedFrame) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_cachedFrame->textures[0]);
+    }
+    else {
+        bindSandImage();
+    }
+
+    m_sandShader->activate();
+    m_sandShader->bindUniformLocation("inputTexture", 0);
+    m_sandShader->setValue("viewWidth", m_sandLayout.viewWidth);
+    m_sandShader->setValue("columnHeight", m_sandLayout.columnHeight);
+    m_sandShader->setValue("lumaHeight", m_sandLayout.lumaHeight);
+    m_sandShader->setValue("stripCount", m_sandLayout.stripCount);
+    m_sandShader->setValue("videoHeight", float(m_height));
+
+    glBindVertexArray(m_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+    m_sandShader->deactivate();
+}
+
+void VideoPlayer::uploadSoftwareFrame(int slot)
+{
+    const AVFrame* frame = m_softwareFrames.frame(slot);
+    if (!frame || !frame->data[0]) return;
+
+    // One R8 texture per plane, the rows keep the decoder's padding (linesize)
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < 3; ++i) {
+        int width = (i == 0) ? frame->width : (frame->width + 1) / 2;
+        int height = (i == 0) ? frame->height : (frame->height + 1) / 2;
+
+        glBindTexture(GL_TEXTURE_2D, m_softwareTextures[i]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, frame->linesize[i]);
+        if (width != m_softwareTextureWidths[i] || height != m_softwareTextureHeights[i]) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, frame->data[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            m_softwareTextureWidths[i] = width;
+            m_softwareTextureHeights[i] = height;
+        }
+        else {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, frame->data[i]);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     glBindTexture(GL_TEXTURE_2D, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    m_hasSoftwareFrame = true;
+}
+
+void VideoPlayer::renderSoftware()
+{
+    if (!m_hasSoftwareFrame && !m_cachedFrame) return;
+
+    static const char* samplers[3] = { "textureY", "textureU", "textureV" };
+    const GLuint* textures = m_cachedFrame ? m_cachedFrame->textures.data() : m_softwareTextures;
+
+    m_yuvShader->activate();
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        m_yuvShader->bindUniformLocation(samplers[i], i);
+    }
+
+    glBindVertexArray(m_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+
+    for (int i = 2; i >= 0; --i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    m_yuvShader->deactivate();
+}
+
+const VideoPlayer::ImageCacheEntry* VideoPlayer::getOrCreateImages(const VideoFrame& videoFrame)
+{
+    // TODO: Support for multiple planes and images (see older version)
+    if (videoFrame.planeCount < 1) return nullptr;
+    const VideoPlane& plane = videoFrame.planes[0];
+
+    m_imageCacheStats.frames++;
+
+    // A new frames context means a new buffer pool, none of the old images can be hit again
+    if (videoFrame.framesContextId != m_imageCacheFramesContextId) {
+        if (!m_imageCache.empty()) m_imageCacheStats.invalidations++;
+        clearImageCache();
+        m_imageCacheFramesContextId = videoFrame.framesContextId;
+    }
+
+    ImageCacheEntry* entry = nullptr;
+    for (auto& cachedEntry : m_imageCache) {
+        if (cachedEntry.bufferId == plane.bufferId && cachedEntry.offset == plane.offset && cachedEntry.format == plane.format) {
+            entry = &cachedEntry;
+            break;
+        }
+    }
+
+    if (entry) {
+        m_imageCacheStats.hits++;
+    }
+    else {
+        m_imageCacheStats.misses++;
+
+        // Evict the least recently used buffer when the pool turns out to be larger than expected
+        if (m_imageCache.size() >= MAX_IMAGE_CACHE_ENTRIES) {
+            EGLDisplay display = eglGetCurrentDisplay();
+            auto lru = std::min_element(m_imageCache.begin(), m_imageCache.end(), [](const auto& a, const auto& b) {
+                return a.lastUsedFrame < b.lastUsedFrame;
+            });
+            for (auto image : lru->images) {
+                if (image != EGL_NO_IMAGE) eglDestroyImage(display, image);
+            }
+            if (lru->sandImage != EGL_NO_IMAGE) eglDestroyImage(display, lru->sandImage);
+            m_imageCache.erase(lru);
+
+            // Destroyed handles may be handed out again, so force the textures to be retargeted
+            std::fill(m_boundImages.begin(), m_boundImages.end(), EGL_NO_IMAGE);
+            m_boundSandImage = EGL_NO_IMAGE;
+        }
+
+        ImageCacheEntry newEntry;
+        newEntry.bufferId = plane.bufferId;
+        newEntry.offset = plane.offset;
+        newEntry.format = plane.format;
+        newEntry.images.resize(m_yuvImages.size(), EGL_NO_IMAGE);
+        m_imageCache.push_back(std::move(newEntry));
+        entry = &m_imageCache.back();
+    }
+    entry->lastUsedFrame = m_imageCacheStats.frames;
+
+    // Only the images of the active conversion path are created, the other ones on demand after switching.
+    // Planes sampling the player directly and loop recording (from the first frame of a pass) always
+    // need the single pass image.
+    bool isRecordingLoop = isLoopCacheable() && (m_loopCache.isRecording() || videoFrame.isFirstFrame);
+    bool needsSandImage = m_useSinglePass || !m_isRgbOutputRequired || isRecordingLoop;
+    if (needsSandImage && entry->sandImage == EGL_NO_IMAGE) {
+        createSandImage(*entry, plane);
+    }
+    if ((!m_useSinglePass || entry->sandImage == EGL_NO_IMAGE) && entry->images[0] == EGL_NO_IMAGE) {
+        createStripImages(*entry, plane);
+    }
+
+    return entry;
+}
+
+void VideoPlayer::createStripImages(ImageCacheEntry& entry, const VideoPlane& plane)
+{
+    EGLDisplay display = eglGetCurrentDisplay();
+    int height = plane.height + (plane.height / 2);
+    for (size_t i = 0; i < entry.images.size(); ++i) {
+        EGLAttrib img_attr[] = {
+            EGL_LINUX_DRM_FOURCC_EXT,      plane.format,
+            EGL_WIDTH,                     128,
+            EGL_HEIGHT,                    height,
+            EGL_DMA_BUF_PLANE0_FD_EXT,     plane.fd,
+            EGL_DMA_BUF_PLANE0_OFFSET_EXT, static_cast<int>(plane.offset) + static_cast<int>(i) * 128 * height,
+            EGL_DMA_BUF_PLANE0_PITCH_EXT,  128,
+            EGL_NONE
+        };
+        
+        entry.images[i] = eglCreateImage(display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, img_attr);
+        m_imageCacheStats.createdImages++;
+    }
+}
+
+bool VideoPlayer::computeSandLayout(const VideoPlane& plane, SandLayout& layout) const
+{
+    // The columns are stored back to back, so the buffer is one linear block of
+    // stripCount * 128 * columnHeight bytes. View it with the widest row that divides
+    // it evenly and still fits into a texture (2048x1530 for 1080p).
+    layout.lumaHeight = plane.height;
+    layout.columnHeight = plane.height + (plane.height / 2);
+    layout.stripCount = (plane.width + 127) / 128;
+
+    int rows = layout.stripCount * layout.columnHeight;
+    for (int columnsPerRow = 16; columnsPerRow >= 1; columnsPerRow /= 2) {
+        if (rows % columnsPerRow != 0) continue;
+
+        layout.viewWidth = 128 * columnsPerRow;
+        layout.viewHeight = rows / columnsPerRow;
+        if (layout.viewWidth <= m_maxTextureSize && layout.viewHeight <= m_maxTextureSize) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void VideoPlayer::createSandImage(ImageCacheEntry& entry, const VideoPlane& plane)
+{
+    if (!computeSandLayout(plane, entry.sandLayout)) {
+        if (!m_hasLoggedSandLayout) {
+            SDL_Log("SAND128 buffer of %dx%d does not fit into a single texture, using strips", plane.width, plane.height);
+            m_hasLoggedSandLayout = true;
+        }
+        return;
+    }
+
+    EGLAttrib img_attr[] = {
+        EGL_LINUX_DRM_FOURCC_EXT,      plane.format,
+        EGL_WIDTH,                     entry.sandLayout.viewWidth,
+        EGL_HEIGHT,                    entry.sandLayout.viewHeight,
+        EGL_DMA_BUF_PLANE0_FD_EXT,     plane.fd,
+        EGL_DMA_BUF_PLANE0_OFFSET_EXT, static_cast<int>(plane.offset),
+        EGL_DMA_BUF_PLANE0_PITCH_EXT,  entry.sandLayout.viewWidth,
+        EGL_NONE
+    };
+
+    entry.sandImage = eglCreateImage(eglGetCurrentDisplay(), EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, img_attr);
+    m_imageCacheStats.createdImages++;
+}
+
+void VideoPlayer::clearImageCache()
+{
+    EGLDisplay display = eglGetCurrentDisplay();
+    for (auto& entry : m_imageCache) {
+        for (auto image : entry.images) {
+            if (image != EGL_NO_IMAGE) eglDestroyImage(display, image);
+        }
+        if (entry.sandImage != EGL_NO_IMAGE) eglDestroyImage(display, entry.sandImage);
+    }
+    m_imageCache.clear();
+
+    for (size_t i = 0; i < m_yuvImages.size(); ++i) {
+        m_yuvImages[i] = EGL_NO_IMAGE;
+        m_boundImages[i] = EGL_NO_IMAGE;
+    }
+    m_sandImage = EGL_NO_IMAGE;
+    m_boundSandImage = EGL_NO_IMAGE;
 }
 
 void VideoPlayer::update()
 {
-    if (!m_isRunning || m_isPaused) return;
+    if (!m_isRunning || m_isPaused || m_isHeld) return;
     
     EGLDisplay display = eglGetCurrentDisplay();
 
@@ -368,69 +779,285 @@ void VideoPlayer::update()
     eglDestroySync(display, m_fence);
     m_fence = EGL_NO_SYNC;
 
-    // TODO: Can EGLImages be reused? It seems like the DRM-Buf FDs change very often.
-    for (auto& yuvImage : m_yuvImages ) {
-        if (yuvImage != nullptr) {
-            eglDestroyImage(display, yuvImage);
-            yuvImage = nullptr;
-        }
-    }
+    updateDecoderLoad();
+    updateLoopCache();
 
+    alloccounter::Scope allocationScope;
     VideoFrame videoFrame;
     
     bool processVideoFrame = true;
-    if (m_videoQueue.peekFrame(videoFrame)) {
-        if (videoFrame.isFirstFrame) m_startTime = SDL_GetTicks();
+    if (m_isPlayingFromCache) {
+        // The decoder is parked, frames it pushed before are of no use
+        discardDecodedFrames(false);
+        bool isLoopBoundary = m_nextCachedFrame >= m_loopCache.frameCount();
+        processVideoFrame = presentCachedFrame();
+        if (processVideoFrame) notePresentedFrame(isLoopBoundary);
+    }
+    else {
+        if (m_isAwaitingRestart) discardDecodedFrames(true);
 
-        double pts = videoFrame.pts;
-        double now = (double)(SDL_GetTicks() - m_startTime) / 1000.0;
-        
-        // Do not pop and display frame when PTS is ahead 
-        if (now < (pts - 0.001)) processVideoFrame = false; 
-    }
-
-    if (processVideoFrame && m_videoQueue.popFrame(videoFrame)) {
-        // Create EGL images here in the main thread
-        // TODO: Support for multiple planes and images (see older version)
-        for (size_t i = 0; i < m_yuvImages.size(); ++i) {
-            if (videoFrame.formats.size() > 0) {
-                int j = 0;
-                int height = videoFrame.heights[j] + (videoFrame.heights[j] / 2);
-                EGLAttrib img_attr[] = {
-                    EGL_LINUX_DRM_FOURCC_EXT,      videoFrame.formats[j],
-                    EGL_WIDTH,                     128,
-                    EGL_HEIGHT,                    height,
-                    EGL_DMA_BUF_PLANE0_FD_EXT,     videoFrame.fds[j],
-                    EGL_DMA_BUF_PLANE0_OFFSET_EXT, static_cast<int>(i) * 128 * height,
-                    EGL_DMA_BUF_PLANE0_PITCH_EXT,  128,
-                    EGL_NONE
-                };
-                
-                EGLImage image = eglCreateImage(display, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT, NULL, img_attr);
-                if (image != EGL_NO_IMAGE) {
-                    m_yuvImages[i] = image;
+        if (const VideoFrame* nextFrame = m_videoQueue.peekFrame()) {
+            if (nextFrame->isFirstFrame) m_startTime = SDL_GetTicks();
+
+            double pts = nextFrame->pts;
+            double now = (double)(SDL_GetTicks() - m_startTime) / 1000.0;
+            
+            // Do not pop and display frame when PTS is ahead 
+            if (now < (pts - 0.001)) processVideoFrame = false; 
+        }
+
+        if (processVideoFrame && !m_isAwaitingRestart && m_videoQueue.popFrame(videoFrame)) {
+            m_renderAllocations.add(allocationScope.count());
+            m_hasPresentedFrame = true;
+
+            if (m_decodeRoute == DecodeRoute::Software) {
+                // Invisible players skip the upload, the slot goes back to the decoder either way
+                if (m_isVisible) uploadSoftwareFrame(videoFrame.index);
+                m_softwareFrames.release(videoFrame.index);
+            }
+            // Look up (or create) the EGL images here in the main thread
+            else if (const ImageCacheEntry* entry = getOrCreateImages(videoFrame)) {
+                for (size_t i = 0; i < m_yuvImages.size(); ++i) {
+                    m_yuvImages[i] = entry->images[i];
                 }
+                m_sandImage = entry->sandImage;
+                m_sandLayout = entry->sandLayout;
+            }
+
+            if (videoFrame.isFirstFrame && m_loopCache.isRecording() && m_loopCache.frameCount() > 0) {
+                // The decoder is back at the in point, so the whole loop is resident now
+                startLoopCachePlayback();
+                presentCachedFrame();
+            }
+            else {
+                if (videoFrame.isFirstFrame) m_loopCacheStats.decodedPasses++;
+                recordLoopFrame(videoFrame);
             }
+            notePresentedFrame(videoFrame.isFirstFrame);
         }
     }
 
     if (m_audio) {
         AudioFrame audioFrame;
-        while (m_audioQueue.peekFrame(audioFrame)) {
-            if (m_audioQueue.popFrame(audioFrame)) {
-                m_audio->putData(audioFrame.data);
-            }
+        while (m_audioQueue.popFrame(audioFrame)) {
+            m_audio->putData(audioFrame.data);
         }
     }
 
-    if (processVideoFrame) {
+    if (!m_isVisible) {
+        // Nothing of this player reaches an output, the frame only advances
+        m_isRgbOutputValid = false;
+    }
+    else if (isDirectOutput()) {
+        // The planes sample the SAND128 buffer themselves, no RGB pass needed
+        if (!m_cachedFrame) bindSandImage();
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_isRgbOutputValid = false;
+    }
+    else if (processVideoFrame || !m_isRgbOutputValid) {
         render();
+    }
+
+    if (processVideoFrame) {
         // m_currentTime = m_firstPts + videoFrame.pts;
-        m_currentTime = videoFrame.absolutePts;
+        m_currentTime = m_cachedFrame ? m_cachedFrame->absolutePts : videoFrame.absolutePts;
         m_fence = eglCreateSync(display, EGL_SYNC_FENCE, NULL);
     }
 }
 
+void VideoPlayer::updateLoopCache()
+{
+    // In and out point are set every frame, any edit starts a new region
+    if (m_inPoint != m_loopCacheInPoint || m_outPoint != m_loopCacheOutPoint) {
+        m_loopCacheInPoint = m_inPoint;
+        m_loopCacheOutPoint = m_outPoint;
+        m_isLoopCacheRejected = false;
+        clearLoopCache();
+    }
+    else if (!m_useLoopCache || !m_isLooping) {
+        clearLoopCache();
+    }
+}
+
+bool VideoPlayer::isLoopCacheable() const
+{
+    if (!m_useLoopCache || !m_isLooping || m_isLoopCacheRejected || !m_isVisible) return false;
+    // The audio comes from the decoder, clips with sound keep decoding
+    return !(m_audio && m_audioStream >= 0);
+}
+
+bool VideoPlayer::beginLoopRecording()
+{
+    if (!isLoopCacheable()) return false;
+
+    double loopEnd = (m_outPoint > 0.0 && m_outPoint < m_duration) ? m_outPoint : m_duration;
+    double loopLength = loopEnd - m_inPoint;
+    if (m_fps <= 0.0 || !(loopLength > 0.0)) {
+        m_isLoopCacheRejected = true;
+        return false;
+    }
+    size_t maxFrames = size_t(std::ceil(loopLength * m_fps)) + LOOP_CACHE_SPARE_FRAMES;
+
+    LoopPlaneSize planes[LoopFrame::MAX_PLANES];
+    int planeCount = 0;
+    if (m_decodeRoute == DecodeRoute::Software) {
+        if (!m_hasSoftwareFrame) return false;
+        for (int i = 0; i < 3; ++i) {
+            planes[i] = { m_softwareTextureWidths[i], m_softwareTextureHeights[i] };
+        }
+        planeCount = 3;
+    }
+    else {
+        if (m_sandImage == EGL_NO_IMAGE) return false;
+        planes[0] = { m_sandLayout.viewWidth, m_sandLayout.viewHeight };
+        planeCount = 1;
+        m_loopCacheLayout = m_sandLayout;
+    }
+
+    if (!m_loopCache.begin(planes, planeCount, maxFrames)) {
+        SDL_Log("Loop of %.2f s (%zu frames) does not fit into the loop cache, %zu of %zu MB in use\n",
+                loopLength, maxFrames,
+                LoopCacheBudget::instance().usedBytes() >> 20, LoopCacheBudget::instance().limit() >> 20);
+        m_isLoopCacheRejected = true;
+        return false;
+    }
+    return true;
+}
+
+void VideoPlayer::recordLoopFrame(const VideoFrame& videoFrame)
+{
+    if (videoFrame.isFirstFrame) {
+        // A pass that was only partly recorded (e.g. while invisible) starts over
+        clearLoopCache();
+        beginLoopRecording();
+    }
+    if (!m_loopCache.isRecording()) return;
+
+    if (!m_isVisible) {
+        clearLoopCache();
+        return;
+    }
+
+    bool isRecorded = false;
+    if (m_decodeRoute == DecodeRoute::Software) {
+        isRecorded = m_hasSoftwareFrame && m_loopCache.record(m_softwareTextures, videoFrame.pts, videoFrame.absolutePts);
+    }
+    else if (m_sandImage != EGL_NO_IMAGE &&
+             m_sandLayout.viewWidth == m_loopCacheLayout.viewWidth &&
+             m_sandLayout.viewHeight == m_loopCacheLayout.viewHeight) {
+        bindSandImage();
+        isRecorded = m_loopCache.record(&m_sandTexture, videoFrame.pts, videoFrame.absolutePts);
+    }
+
+    if (!isRecorded) {
+        // Longer than the frame rate predicted or out of memory, this region keeps decoding
+        SDL_Log("Loop cache gave up after %zu frames\n", m_loopCache.frameCount());
+        m_isLoopCacheRejected = true;
+        clearLoopCache();
+    }
+}
+
+void VideoPlayer::startLoopCachePlayback()
+{
+    const LoopFrame& lastFrame = m_loopCache.frame(m_loopCache.frameCount() - 1);
+    double frameDuration = (m_fps > 0.0) ? 1.0 / m_fps : 0.0;
+    m_loopCache.finish(lastFrame.pts + frameDuration);
+
+    SDL_Log("Playing loop of %zu frames (%zu MB) from the loop cache\n",
+            m_loopCache.frameCount(), m_loopCache.residentBytes() >> 20);
+
+    m_isPlayingFromCache = true;
+    m_isDecoderParked = true;
+    m_nextCachedFrame = 0;
+    m_sandLayout = m_loopCacheLayout;
+    m_loopCacheStats.cachedPasses++;
+}
+
+void VideoPlayer::clearLoopCache()
+{
+    if (m_isPlayingFromCache) {
+        // The decoder continues where it was parked, so it has to start the loop over
+        m_isPlayingFromCache = false;
+        m_cachedFrame = nullptr;
+        m_isAwaitingRestart = true;
+        m_isRestartRequested = true;
+        m_isDecoderParked = false;
+        m_isRgbOutputValid = false;
+    }
+    m_loopCache.clear();
+}
+
+bool VideoPlayer::presentCachedFrame()
+{
+    if (m_nextCachedFrame >= m_loopCache.frameCount()) {
+        double now = (double)(SDL_GetTicks() - m_startTime) / 1000.0;
+        if (now < (m_loopCache.passDuration() - 0.001)) return false;
+
+        m_nextCachedFrame = 0;
+        m_startTime = SDL_GetTicks();
+        m_loopCacheStats.cachedPasses++;
+    }
+
+    const LoopFrame& frame = m_loopCache.frame(m_nextCachedFrame);
+    double now = (double)(SDL_GetTicks() - m_startTime) / 1000.0;
+    if (now < (frame.pts - 0.001)) return false;
+
+    m_cachedFrame = &frame;
+    m_nextCachedFrame++;
+    return true;
+}
+
+void VideoPlayer::discardDecodedFrames(bool untilLoopStart)
+{
+    VideoFrame videoFrame;
+    while (const VideoFrame* nextFrame = m_videoQueue.peekFrame()) {
+        if (untilLoopStart && nextFrame->isFirstFrame) {
+            m_isAwaitingRestart = false;
+            return;
+        }
+        if (!m_videoQueue.popFrame(videoFrame)) return;
+        if (m_decodeRoute == DecodeRoute::Software) m_softwareFrames.release(videoFrame.index);
+    }
+}
+
+void VideoPlayer::notePresentedFrame(bool isLoopBoundary)
+{
+    Uint64 now = SDL_GetTicksNS();
+    if (m_lastPresentNs != 0) {
+        double intervalMs = double(now - m_lastPresentNs) / 1000000.0;
+        LoopCacheStats& stats = m_loopCacheStats;
+        if (isLoopBoundary) {
+            stats.boundaries++;
+            stats.lastBoundaryMs = intervalMs;
+            stats.worstBoundaryMs = std::max(stats.worstBoundaryMs, intervalMs);
+            stats.averageBoundaryMs += (intervalMs - stats.averageBoundaryMs) / double(stats.boundaries);
+        }
+        else {
+            stats.averageFrameMs = (stats.averageFrameMs == 0.0) ? intervalMs : stats.averageFrameMs * 0.95 + intervalMs * 0.05;
+        }
+    }
+    m_lastPresentNs = now;
+}
+
+void VideoPlayer::updateDecoderLoad()
+{
+    Uint64 now = SDL_GetTicksNS();
+    uint64_t idleNs = m_decoderIdleNs;
+    m_loopCacheStats.decodedFrames = m_decodedFrames;
+    if (m_loadWindowStartNs == 0) {
+        m_loadWindowStartNs = now;
+        m_loadWindowIdleNs = idleNs;
+        return;
+    }
+
+    Uint64 windowNs = now - m_loadWindowStartNs;
+    if (windowNs < 1000000000) return;
+    double idleShare = double(idleNs - m_loadWindowIdleNs) / double(windowNs);
+    m_loopCacheStats.decoderLoad = std::clamp(1.0 - idleShare, 0.0, 1.0);
+    m_loadWindowStartNs = now;
+    m_loadWindowIdleNs = idleNs;
+}
+
 static SDL_AudioFormat GetAudioFormat(int format)
 {
     switch (format) {
@@ -474,6 +1101,9 @@ void VideoPlayer::handleAudioFrame(AVFrame *frame)
         m_firstAudioPts = pts;
     }
     pts -= m_firstAudioPts;
+
+    // Nobody drains the queue of a held player, a full one would keep the first video frame from coming
+    if (m_isHeld) return;
     
     AudioFrame audioFrame;
     audioFrame.pts = pts;
@@ -498,7 +1128,7 @@ void VideoPlayer::handleAudioFrame(AVFrame *frame)
         SDL_memcpy(&(audioFrame.data[0]), frame->data[0], framesize);
     }
 
-    m_audioQueue.pushFrame(audioFrame);
+    m_audioQueue.pushFrame(std::move(audioFrame));
 }
 
 void VideoPlayer::seekToInPoint(bool backward) {
@@ -508,28 +1138,105 @@ void VideoPlayer::seekToInPoint(bool backward) {
     const double loop_start_s = double(m_inPoint);
     
     int64_t loop_start_pts = llround(loop_start_s / av_q2d(stream->time_base));
-    
-    int flags = AVSEEK_FLAG_BACKWARD;
-    if (av_seek_frame(m_formatContext, m_videoStream, loop_start_pts, flags) >= 0) {
+
+    // Frames before the in point are decoded but dropped, see run()
+    m_seekStartNs = SDL_GetTicksNS();
+    m_seekTargetPts = loop_start_pts;
+    m_discardedSinceSeek = 0;
+    m_predictedDiscards = 0;
+    m_isIndexedSeek = false;
+
+    const KeyframeEntry* keyframe = m_useKeyframeIndex ? m_keyframeIndex.find(loop_start_pts) : nullptr;
+    bool isIndexedSeek = false;
+
+    // Runs on the demux thread, the only one reading the format context
+    int result = m_demuxThread.seek([&](AVFormatContext* formatContext) {
+        if (keyframe) {
+            // Demuxers without an index of their own (MPEG-TS, raw streams) would have to search
+            // for the timestamp, so they jump to the keyframe's byte offset instead
+            bool useBytePosition = keyframe->position >= 0 &&
+                                   !(formatContext->iformat->flags & AVFMT_NO_BYTE_SEEK) &&
+                                   avformat_index_get_entries_count(stream) == 0;
+            int indexedResult = useBytePosition ?
+                av_seek_frame(formatContext, m_videoStream, keyframe->position, AVSEEK_FLAG_BYTE) :
+                av_seek_frame(formatContext, m_videoStream, keyframe->pts, AVSEEK_FLAG_BACKWARD);
+            if (indexedResult >= 0) {
+                isIndexedSeek = true;
+                return indexedResult;
+            }
+        }
+
+        int flags = AVSEEK_FLAG_BACKWARD;
+        return av_seek_frame(formatContext, m_videoStream, loop_start_pts, flags);
+    });
+
+    if (isIndexedSeek) {
+        m_isIndexedSeek = true;
+        m_predictedDiscards = m_keyframeIndex.framesToDiscard(*keyframe, loop_start_pts);
+    }
+    if (result >= 0) {
         avcodec_flush_buffers(m_videoContext);
     }
 }
 
+void VideoPlayer::finishSeek()
+{
+    double latencyMs = double(SDL_GetTicksNS() - m_seekStartNs) / 1000000.0;
+    if (m_isIndexedSeek) {
+        m_seekStats.indexedSeeks++;
+        m_seekStats.lastIndexedMs = latencyMs;
+        m_seekStats.averageIndexedMs = m_seekStats.averageIndexedMs + (latencyMs - m_seekStats.averageIndexedMs) / double(m_seekStats.indexedSeeks);
+        m_seekStats.predictedFrames += uint64_t(m_predictedDiscards);
+        m_seekStats.indexedDiscardedFrames += uint64_t(m_discardedSinceSeek);
+    }
+    else {
+        m_seekStats.searchedSeeks++;
+        m_seekStats.lastSearchedMs = latencyMs;
+        m_seekStats.averageSearchedMs = m_seekStats.averageSearchedMs + (latencyMs - m_seekStats.averageSearchedMs) / double(m_seekStats.searchedSeeks);
+        m_seekStats.searchedDiscardedFrames += uint64_t(m_discardedSinceSeek);
+    }
+    m_seekTargetPts = AV_NOPTS_VALUE;
+}
+
+void VideoPlayer::cancelSeek()
+{
+    if (m_seekTargetPts == AV_NOPTS_VALUE) return;
+
+    if (m_isIndexedSeek) m_seekStats.unfinishedIndexedSeeks++;
+    else m_seekStats.unfinishedSearchedSeeks++;
+    m_seekTargetPts = AV_NOPTS_VALUE;
+}
+
 void VideoPlayer::run() {
+    m_demuxThread.start(m_formatContext);
     if (m_inPoint > 0.0) seekToInPoint();
 
     while (m_isRunning) {
-            if (m_isPaused) {
+            if (m_isRestartRequested.exchange(false)) {
+                // Playback from the loop cache ended, continue decoding from the in point
+                m_firstPts = -1.0;
+                seekToInPoint();
+                if (m_audioContext) avcodec_flush_buffers(m_audioContext);
+                if (m_videoContext) avcodec_flush_buffers(m_videoContext);
+            }
+            if (m_isPaused || m_isDecoderParked) {
+                Uint64 idleStartNs = SDL_GetTicksNS();
                 std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                m_decoderIdleNs += SDL_GetTicksNS() - idleStartNs;
                 continue;
             }
             if (!m_isFlushing) {
             // Read and decode frames
-            int result = av_read_frame(m_formatContext, m_packet);
+            int result = m_demuxThread.readPacket(m_packet, m_isRunning);
+            if (result == AVERROR_EXIT) continue;
             if (result < 0) {
                 if (m_isLooping) {
                     m_firstPts = -1.0;      
+                    // An in point behind the last frame is never reached, show from its keyframe then
+                    bool isSeekPending = m_seekTargetPts != AV_NOPTS_VALUE;
+                    cancelSeek();
                     seekToInPoint();
+                    if (isSeekPending) cancelSeek();
                     SDL_Log("End of stream, restart (looping)\n");
                 }
                 else {
@@ -630,6 +1337,15 @@ void VideoPlayer::run() {
         // Process decoded frames
         if (m_videoContext) { 
             while (avcodec_receive_frame(m_videoContext, m_frame) >= 0) {
+                m_decodedFrames++;
+                if (m_seekTargetPts != AV_NOPTS_VALUE) {
+                    if (m_frame->pts != AV_NOPTS_VALUE && m_frame->pts < m_seekTargetPts) {
+                        m_discardedSinceSeek++;
+                        continue;
+                    }
+                    finishSeek();
+                }
+
                 double pts = ((double)m_frame->pts * m_videoContext->pkt_timebase.num) / m_videoContext->pkt_timebase.den;
                 bool firstFrame = false;
                 if (m_firstPts < 0.0) {
@@ -637,18 +1353,39 @@ void VideoPlayer::run() {
                     firstFrame = true;
                 }
 
+                alloccounter::Scope allocationScope;
                 VideoFrame frame;
-                if (getTextureForDRMFrame(m_frame, frame)) {
+                bool hasFrame = false;
+                if (m_decodeRoute == DecodeRoute::Software) {
+                    frame.index = m_softwareFrames.store(m_frame, m_isRunning);
+                    hasFrame = frame.index >= 0;
+                }
+                else {
+                    hasFrame = getTextureForDRMFrame(m_frame, frame);
+                }
+                if (hasFrame) {
                     frame.isFirstFrame = firstFrame;
                     frame.pts = pts - m_firstPts;
                     frame.absolutePts = pts;
-                    m_videoQueue.pushFrame(frame);
+                    // Waiting for the main thread doesn't count as decoder load
+                    Uint64 idleStartNs = SDL_GetTicksNS();
+                    m_videoQueue.pushFrame(std::move(frame));
+                    m_decodeAllocations.add(allocationScope.count());
+
+                    // A pre-rolled player keeps its first frame until it is triggered
+                    while (m_isHeld && m_isRunning) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                    m_decoderIdleNs += SDL_GetTicksNS() - idleStartNs;
                 }
+                // The main thread plays the loop from its cache now
+                if (m_isDecoderParked) break;
             }
         }
 
         if (m_isFlushing) m_isRunning = false;
     }
+    m_demuxThread.stop();
 }
 
 bool VideoPlayer::getTextureForDRMFrame(AVFrame* frame, VideoFrame& dstFrame)
@@ -656,9 +1393,15 @@ bool VideoPlayer::getTextureForDRMFrame(AVFrame* frame, VideoFrame& dstFrame)
     AVHWFramesContext *frames = (AVHWFramesContext *)(frame->hw_frames_ctx ? frame->hw_frames_ctx->data : NULL);
     const AVDRMFrameDescriptor *desc = (const AVDRMFrameDescriptor *)frame->data[0];
 
+    // Let the main thread know when the decoder switched to a new buffer pool
+    if (frames != m_lastFramesContext) {
+        m_lastFramesContext = frames;
+        m_framesContextId++;
+    }
+    dstFrame.framesContextId = m_framesContextId;
+
     //printf("%dx%d\n", frames->width, frames->height);
 
-    int imageIndex = 0;
     for (int i = 0; i < desc->nb_layers; ++i) {
         const AVDRMLayerDescriptor *layer = &desc->layers[i];
         for (int j = 0; j < layer->nb_planes; ++j) {
@@ -667,13 +1410,22 @@ bool VideoPlayer::getTextureForDRMFrame(AVFrame* frame, VideoFrame& dstFrame)
             const AVDRMObjectDescriptor *object = &desc->objects[plane->object_index];
             
             // Store DRM frame info instead of creating EGL image
-            dstFrame.formats.push_back(formats[j]);
-            dstFrame.widths.push_back(frames->width);
-            dstFrame.heights.push_back(frames->height);
-            dstFrame.fds.push_back(object->fd);
-            dstFrame.offsets.push_back(plane->offset);
-            dstFrame.pitches.push_back(frames->width);
-            imageIndex++;
+            VideoPlane videoPlane;
+            videoPlane.format = formats[j % 2];
+            videoPlane.width = frames->width;
+            videoPlane.height = frames->height;
+            videoPlane.fd = object->fd;
+            videoPlane.offset = plane->offset;
+            videoPlane.pitch = frames->width;
+
+            struct stat bufferStat;
+            if (fstat(object->fd, &bufferStat) == 0) {
+                videoPlane.bufferId = uint64_t(bufferStat.st_ino);
+            }
+            if (!dstFrame.addPlane(videoPlane)) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "DRM frame has more than %d planes", VIDEO_FRAME_MAX_PLANES);
+                return dstFrame.planeCount > 0;
+            }
         }
     }
     return true;
@@ -11,6 +11,13 @@
 
 #include "source/MediaPlayer.h"
 #include "source/Shader.h"
+#include "source/AllocationCounter.h"
+#include "source/GpuTimer.h"
+#include "source/SoftwareDecode.h"
+#include "source/KeyframeIndex.h"
+#include "source/LoopFrameCache.h"
+#include "source/ReadAheadFile.h"
+#include "source/DemuxThread.h"
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_render.h>
@@ -36,6 +43,45 @@ extern "C"
 }
 
 
+struct ImageCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;
+    uint64_t createdImages = 0;
+    uint64_t frames = 0;
+};
+
+// Seeks to the in point, from opening and from looping. Indexed seeks jumped to a
+// keyframe from the clip's KeyframeIndex, searched ones let the demuxer find it.
+// Written by the decoder thread.
+struct SeekStats {
+    std::atomic<uint64_t> indexedSeeks = 0;
+    std::atomic<uint64_t> searchedSeeks = 0;
+    std::atomic<double> lastIndexedMs = 0.0;     // seek -> first frame at the in point
+    std::atomic<double> lastSearchedMs = 0.0;
+    std::atomic<double> averageIndexedMs = 0.0;
+    std::atomic<double> averageSearchedMs = 0.0;
+    std::atomic<uint64_t> predictedFrames = 0;   // frames the index expected to drop
+    std::atomic<uint64_t> indexedDiscardedFrames = 0;
+    std::atomic<uint64_t> searchedDiscardedFrames = 0;
+    std::atomic<uint64_t> unfinishedIndexedSeeks = 0;    // the stream ended before the in point was reached
+    std::atomic<uint64_t> unfinishedSearchedSeeks = 0;
+};
+
+// Playback of looped regions, with the loop cache on or off. Frame intervals are
+// measured between the presented frames, the boundary ones across the loop point.
+struct LoopCacheStats {
+    uint64_t decodedPasses = 0;
+    uint64_t cachedPasses = 0;      // played from the LoopFrameCache
+    uint64_t boundaries = 0;
+    double lastBoundaryMs = 0.0;
+    double worstBoundaryMs = 0.0;
+    double averageBoundaryMs = 0.0;
+    double averageFrameMs = 0.0;    // smoothed, within the loop
+    uint64_t decodedFrames = 0;
+    double decoderLoad = 0.0;       // busy share of the decoder thread over the last second
+};
+
 SDL_PixelFormat getTextureFormat(enum AVPixelFormat format);
 bool isSupportedPixelFormat(enum AVPixelFormat format);
 enum AVPixelFormat getSupportedPixelFormat(AVCodecContext* s, const enum AVPixelFormat* pix_fmts);
@@ -56,18 +102,100 @@ public:
 
     bool openFile(const std::string& fileName, AudioStream* audioStream = nullptr) override;
     void close() override;
+
+    // Opens the file and decodes its first frame on the decoder thread, which then holds
+    // until startPrerolled(). In and out point and looping have to be set before.
+    void preroll(const std::string& fileName, AudioStream* audioStream = nullptr);
+    void startPrerolled() { m_isHeld = false; }
+    // The decoder thread still writes the stream state, its getters return defaults until then
+    bool isOpeningPreroll() const { return m_isHeld && !m_isPrerollOpened; }
+    bool isPrerollReady() const { return m_isHeld && m_isPrerollOpened && m_videoQueue.isFrameReady(); }
+    bool hasPrerollFailed() const { return m_hasPrerollFailed; }
+    // A frame was shown since play() or preroll()
+    bool hasPresentedFrame() const { return m_hasPresentedFrame; }
     void setLooping(bool looping);
     void update() override;
     void pause(bool isPaused) override;
+    const ImageCacheStats& imageCacheStats() const { return m_imageCacheStats; }
+
+    // Switches between one draw per SAND128 column and a single detiling pass
+    void setSinglePassConversion(bool enabled) { m_useSinglePass = enabled; }
+    bool isSinglePassConversion() const { return m_useSinglePass; }
+    void setMeasureGpuTime(bool enabled) { m_measureGpuTime = enabled; }
+    const GpuTimer& conversionTimer(bool singlePass) const { return singlePass ? m_singlePassTimer : m_stripTimer; }
+
+    DecodeRoute decodeRoute() const { return isOpeningPreroll() ? DecodeRoute::None : m_decodeRoute; }
+    // Threads granted by the DecodeBudget, 0 for a clip decoded single threaded
+    int softwareDecodeThreads() const { return isOpeningPreroll() ? 0 : m_softwareThreads; }
+    const SoftwareFrameStats& softwareFrameStats() const { return m_softwareFrames.stats(); }
+
+    void setUseKeyframeIndex(bool enabled) { m_useKeyframeIndex = enabled; }
+    bool hasKeyframeIndex() const { return !isOpeningPreroll() && m_keyframeIndex.isValid(); }
+    const SeekStats& seekStats() const { return m_seekStats; }
+
+    // Keeps the decoded frames of a looped region resident when it fits into the LoopCacheBudget
+    void setUseLoopCache(bool enabled) { m_useLoopCache = enabled; }
+    bool isPlayingFromLoopCache() const { return m_isPlayingFromCache; }
+    const LoopFrameCache& loopCache() const { return m_loopCache; }
+    const LoopCacheStats& loopCacheStats() const { return m_loopCacheStats; }
+
+    bool isReadingAhead() const { return m_readAheadFile.isOpen(); }
+    const ReadAheadStats& readAheadStats() const { return m_readAheadFile.stats(); }
+    const DemuxStats& demuxStats() const { return m_demuxThread.stats(); }
     
 private:
+    // Linear R8 view of a whole SAND128 buffer (all columns in one image)
+    struct SandLayout {
+        int viewWidth = 0;
+        int viewHeight = 0;
+        int columnHeight = 0;
+        int lumaHeight = 0;
+        int stripCount = 0;
+    };
+
+    // Prebuilt images for one DRM PRIME buffer of the decoder pool
+    struct ImageCacheEntry {
+        uint64_t bufferId = 0;
+        uint32_t offset = 0;
+        uint32_t format = 0;
+        uint64_t lastUsedFrame = 0;
+        std::vector<EGLImage> images;
+        EGLImage sandImage = EGL_NO_IMAGE;
+        SandLayout sandLayout;
+    };
+
+    const ImageCacheEntry* getOrCreateImages(const VideoFrame& videoFrame);
+    void createStripImages(ImageCacheEntry& entry, const VideoPlane& plane);
+    void createSandImage(ImageCacheEntry& entry, const VideoPlane& plane);
+    bool computeSandLayout(const VideoPlane& plane, SandLayout& layout) const;
+    void clearImageCache();
+
     void reset() override;
     void loadShaders() override;
     void run() override;
     void render();
+    void renderStrips();
+    void renderSinglePass();
+    void bindSandImage();
+    void renderSoftware();
+    void uploadSoftwareFrame(int slot);
+    DirectSource nativeSource() const override;
     void seekToInPoint(bool backward = false);
+    void finishSeek();
+    void cancelSeek();
+    void updateLoopCache();
+    bool isLoopCacheable() const;
+    bool beginLoopRecording();
+    void recordLoopFrame(const VideoFrame& videoFrame);
+    void startLoopCachePlayback();
+    void clearLoopCache();
+    bool presentCachedFrame();
+    void discardDecodedFrames(bool untilLoopStart);
+    void notePresentedFrame(bool isLoopBoundary);
+    void updateDecoderLoad();
     
 
+    bool openStreams(const std::string& fileName, AudioStream* audioStream);
     AVCodecContext* openVideoStream();
     AVCodecContext* openAudioStream();
     void handleAudioFrame(AVFrame* frame);
@@ -89,6 +217,8 @@ private:
     double m_fps = -1.0;
     double m_currentTime = 0; // in seconds
     AVFormatContext* m_formatContext = nullptr;
+    ReadAheadFile m_readAheadFile;
+    DemuxThread m_demuxThread;      // reads m_formatContext while the decoder thread runs
     //AVDictionary* m_options = nullptr;
     const AVCodec* m_audioCodec = nullptr;
     const AVCodec* m_videoCodec = nullptr;
@@ -100,7 +230,81 @@ private:
     int m_audioStream = -1;
     bool m_foundKeyframe = false;
 
+    // EGL image cache (main thread only)
+    static constexpr size_t MAX_IMAGE_CACHE_ENTRIES = 24;
+    std::vector<ImageCacheEntry> m_imageCache;
+    std::vector<EGLImage> m_boundImages;
+    uint32_t m_imageCacheFramesContextId = 0;
+    ImageCacheStats m_imageCacheStats;
+
+    // Single pass SAND128 conversion
+    std::shared_ptr<Shader> m_sandShader = std::make_shared<Shader>();
+    GLuint m_sandTexture = 0;
+    EGLImage m_sandImage = EGL_NO_IMAGE;
+    EGLImage m_boundSandImage = EGL_NO_IMAGE;
+    SandLayout m_sandLayout;
+    GLint m_maxTextureSize = 0;
+    bool m_useSinglePass = true;
+    bool m_hasLoggedSandLayout = false;
+    bool m_measureGpuTime = false;
+    GpuTimer m_stripTimer;
+    GpuTimer m_singlePassTimer;
+
+    // Software decoding (see SoftwareDecode.h)
+    static constexpr int SOFTWARE_DECODE_THREADS = 2;   // per clip, if the budget allows
+    DecodeRoute m_decodeRoute = DecodeRoute::None;
+    int m_softwareThreads = 0;
+    SoftwareFramePool m_softwareFrames;
+    std::shared_ptr<Shader> m_yuvShader = std::make_shared<Shader>();
+    GLuint m_softwareTextures[3] = {};
+    int m_softwareTextureWidths[3] = {};
+    int m_softwareTextureHeights[3] = {};
+    bool m_hasSoftwareFrame = false;
+
+    // Exact seeking (decoder thread)
+    KeyframeIndex m_keyframeIndex;
+    std::atomic<bool> m_useKeyframeIndex = true;
+    int64_t m_seekTargetPts = AV_NOPTS_VALUE;   // frames before it are dropped
+    Uint64 m_seekStartNs = 0;
+    bool m_isIndexedSeek = false;
+    int m_predictedDiscards = 0;
+    int m_discardedSinceSeek = 0;
+    SeekStats m_seekStats;
+
+    // Loop cache (main thread, see LoopFrameCache.h)
+    static constexpr size_t LOOP_CACHE_SPARE_FRAMES = 2;   // on top of the frames the frame rate predicts
+    LoopFrameCache m_loopCache;
+    bool m_useLoopCache = true;
+    double m_loopCacheInPoint = 0.0;
+    double m_loopCacheOutPoint = -1.0;
+    bool m_isLoopCacheRejected = false;     // not retried until the region changes
+    SandLayout m_loopCacheLayout;
+    bool m_isPlayingFromCache = false;
+    const LoopFrame* m_cachedFrame = nullptr;   // shown instead of a decoded frame
+    size_t m_nextCachedFrame = 0;
+    bool m_isAwaitingRestart = false;       // decoded frames are dropped until the loop restarted
+    std::atomic<bool> m_isDecoderParked = false;
+    std::atomic<bool> m_isRestartRequested = false;
+    LoopCacheStats m_loopCacheStats;
+    Uint64 m_lastPresentNs = 0;
+    std::atomic<uint64_t> m_decoderIdleNs = 0;
+    std::atomic<uint64_t> m_decodedFrames = 0;
+    Uint64 m_loadWindowStartNs = 0;
+    uint64_t m_loadWindowIdleNs = 0;
+
+    // Decoder thread
+    const void* m_lastFramesContext = nullptr;
+    uint32_t m_framesContextId = 0;
+
     // State
     std::atomic<bool> m_isLooping = false;
     std::atomic<bool> m_isFlushing = false;
+    std::atomic<bool> m_isHeld = false;             // pre-rolled, waiting for the trigger
+    std::atomic<bool> m_isPrerollOpened = false;
+    std::atomic<bool> m_hasPrerollFailed = false;
+    bool m_hasPresentedFrame = false;
+
+    // Heap allocations of the decoder -> render handoff (debug builds only)
+    alloccounter::FrameStats m_decodeAllocations;
+    alloccounter::FrameStats m_renderAllocations;
 };
\ No newline at end of file
@@ -45,7 +45,7 @@ WebcamPlayer::WebcamPlayer()
 {
     loadShaders();
     createVertexBuffers();
-    initializeFramebufferAndTextures();
+    initializeInputTextures();
     glGenTextures(1, &m_nonZeroCopyTextureId);
 }
 
@@ -257,9 +257,9 @@ int WebcamPlayer::dequeueBuffer(int fd)
 
 void WebcamPlayer::loadShaders()
 {
-    m_shader.load("shaders/pass.vert", "shaders/camera.frag");
-    m_webcamShader.load("shaders/pass.vert", "shaders/webcam.frag");
-    m_nonZeroCopyWebcamShader.load("shaders/pass.vert", "shaders/webcam_non_zero_copy.frag");
+    m_shader = ShaderLibrary::instance().load("shaders/pass.vert", "shaders/camera.frag");
+    m_webcamShader = ShaderLibrary::instance().load("shaders/pass.vert", "shaders/webcam.frag");
+    m_nonZeroCopyWebcamShader = ShaderLibrary::instance().load("shaders/pass.vert", "shaders/webcam_non_zero_copy.frag");
 }
 
 static std::vector<CameraMode> listCameraModes(int fd) 
@@ -477,8 +477,7 @@ void WebcamPlayer::run()
         lockBuffer();
         Buffer* buffer = getBuffer();
         if (buffer) {
-            VideoFrame frame = createFrameFromBuffer(buffer);
-            m_videoQueue.pushFrame(frame);
+            m_videoQueue.pushFrame(createFrameFromBuffer(buffer));
             unlockBuffer();
         }
         SDL_Delay(1);
@@ -512,13 +511,13 @@ void WebcamPlayer::activateShader()
 {
     switch (m_captureType) {
         case CaptureType::CT_CSI:
-            m_shader.activate();
+            m_shader->activate();
             break;
         case CaptureType::CT_WEBCAM:
-            m_webcamShader.activate();
+            m_webcamShader->activate();
             break;
         case CaptureType::CT_WEBCAM_NON_ZERO:
-            m_nonZeroCopyWebcamShader.activate();
+            m_nonZeroCopyWebcamShader->activate();
             break;
         default:
             break;
@@ -529,13 +528,13 @@ void WebcamPlayer::deactivateShader()
 {
     switch (m_captureType) {
         case CaptureType::CT_CSI:
-            m_shader.deactivate();
+            m_shader->deactivate();
             break;
         case CaptureType::CT_WEBCAM:
-            m_webcamShader.deactivate();
+            m_webcamShader->deactivate();
             break;
         case CaptureType::CT_WEBCAM_NON_ZERO:
-            m_nonZeroCopyWebcamShader.deactivate();
+            m_nonZeroCopyWebcamShader->deactivate();
             break;
         default:
             break;
@@ -544,8 +543,10 @@ void WebcamPlayer::deactivateShader()
 
 void WebcamPlayer::render()
 {
+    if (!acquireRenderTarget()) return;
+
     glViewport(0, 0, 1920, 1080);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_renderTarget->frameBuffer);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
@@ -553,23 +554,18 @@ void WebcamPlayer::render()
 
     glBindVertexArray(m_vao);
 
-    glActiveTexture(GL_TEXTURE0);
     if (m_captureType == CaptureType::CT_CSI || m_captureType == CaptureType::CT_WEBCAM) {
-        glBindTexture(GL_TEXTURE_2D, m_yuvTextures[0]);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        GLHelper::glEGLImageTargetTexture2DOESFunc(GL_TEXTURE_2D, m_yuvImages[0]);
+        bindCaptureImage();
     }
     else {
+        glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, m_nonZeroCopyTextureId);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     }
-    m_shader.bindUniformLocation("inputTexture", 0);
+    m_shader->bindUniformLocation("inputTexture", 0);
 
     glDrawArrays(GL_TRIANGLES, 0, 6);
 
@@ -580,6 +576,37 @@ void WebcamPlayer::render()
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void WebcamPlayer::bindCaptureImage()
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, m_yuvTextures[0]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GLHelper::glEGLImageTargetTexture2DOESFunc(GL_TEXTURE_2D, m_yuvImages[0]);
+}
+
+DirectSource WebcamPlayer::nativeSource() const
+{
+    DirectSource source;
+    if (m_yuvImages.empty() || m_yuvImages[0] == EGL_NO_IMAGE) return source;
+
+    // Non zero copy frames are uploaded as RGBA and always go through the RGB pass
+    if (m_captureType == CaptureType::CT_CSI) {
+        source.type = DirectSourceType::Uyvy;
+    }
+    else if (m_captureType == CaptureType::CT_WEBCAM) {
+        source.type = DirectSourceType::Yuyv;
+    }
+    else {
+        return source;
+    }
+    source.texture = m_yuvTextures[0];
+    source.size = glm::vec2(float(m_fmt.fmt.pix.width), float(m_fmt.fmt.pix.height));
+    return source;
+}
+
 void WebcamPlayer::update()
 {
     if (!m_isRunning) return;
@@ -629,7 +656,19 @@ void WebcamPlayer::update()
         }
     }
 
-    render();
+    // Invisible webcams still dequeue above so the capture buffers keep cycling
+    if (!m_isVisible) {
+        return;
+    }
+
+    if (isDirectOutput()) {
+        // The planes sample the capture image themselves, no RGB pass needed
+        bindCaptureImage();
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    else {
+        render();
+    }
 
     // Create fence for current frame
     m_fence = eglCreateSync(display, EGL_SYNC_FENCE, NULL);
@@ -51,6 +51,8 @@ private:
     void loadShaders() override;
     void run() override;
     void render();
+    void bindCaptureImage();
+    DirectSource nativeSource() const override;
 
     void lockBuffer();
     Buffer* getBuffer();
@@ -70,8 +72,8 @@ private:
     CaptureType m_captureType = CaptureType::CT_WEBCAM_NON_ZERO;
     std::string m_devicePath;
 
-    Shader m_webcamShader;
-    Shader m_nonZeroCopyWebcamShader;
+    std::shared_ptr<Shader> m_webcamShader = std::make_shared<Shader>();
+    std::shared_ptr<Shader> m_nonZeroCopyWebcamShader = std::make_shared<Shader>();
     GLuint m_nonZeroCopyTextureId;
 
     int m_port = -1;
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "SyntheticClip.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include <cstdio>
+
+static void fillFrame(AVFrame* frame, int index)
+{
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(AVPixelFormat(frame->format));
+    uint32_t seed = 0x9e3779b9u * uint32_t(index + 1);
+    for (int y = 0; y < frame->height; ++y) {
+        uint8_t* row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < frame->width; ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            row[x] = uint8_t(((x + y + index * 4) & 0xff) / 2 + ((seed >> 24) & 0x3f));
+        }
+    }
+    int chromaWidth = AV_CEIL_RSHIFT(frame->width, desc->log2_chroma_w);
+    int chromaHeight = AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h);
+    for (int y = 0; y < chromaHeight; ++y) {
+        uint8_t* u = frame->data[1] + y * frame->linesize[1];
+        uint8_t* v = frame->data[2] + y * frame->linesize[2];
+        for (int x = 0; x < chromaWidth; ++x) {
+            u[x] = uint8_t(128 + ((x + index) & 0x3f) - 32);
+            v[x] = uint8_t(128 + ((y - index) & 0x3f) - 32);
+        }
+    }
+}
+
+static bool writeFrames(AVCodecContext* encoder, AVFrame* frame, AVFormatContext* output, AVStream* stream)
+{
+    if (avcodec_send_frame(encoder, frame) < 0) return false;
+
+    AVPacket* packet = av_packet_alloc();
+    while (avcodec_receive_packet(encoder, packet) >= 0) {
+        av_packet_rescale_ts(packet, encoder->time_base, stream->time_base);
+        packet->stream_index = stream->index;
+        av_interleaved_write_frame(output, packet);
+    }
+    av_packet_free(&packet);
+    return true;
+}
+
+bool createSyntheticClip(const std::string& fileName, const SyntheticClipOptions& options)
+{
+    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    if (!codec) {
+        printf("No H.264 encoder in this libav build\n");
+        return false;
+    }
+
+    AVFormatContext* output = nullptr;
+    if (avformat_alloc_output_context2(&output, nullptr, options.muxer, fileName.c_str()) < 0) return false;
+
+    AVCodecContext* encoder = avcodec_alloc_context3(codec);
+    encoder->width = options.width;
+    encoder->height = options.height;
+    encoder->pix_fmt = options.format;
+    encoder->time_base = AVRational{ 1, options.frameRate };
+    encoder->framerate = AVRational{ options.frameRate, 1 };
+    encoder->gop_size = options.gopSize;
+    if (options.isFixedGop) encoder->keyint_min = options.gopSize;
+    encoder->max_b_frames = 2;
+    encoder->bit_rate = options.bitRate;
+    if (output->oformat->flags & AVFMT_GLOBALHEADER) encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    av_opt_set(encoder->priv_data, "preset", "ultrafast", 0);
+    if (options.isFixedGop) av_opt_set(encoder->priv_data, "x264-params", "scenecut=0", 0);
+
+    bool isOk = avcodec_open2(encoder, codec, nullptr) >= 0;
+    if (!isOk) {
+        printf("%s can't encode %s\n", codec->name, av_get_pix_fmt_name(options.format));
+    }
+
+    AVStream* stream = isOk ? avformat_new_stream(output, nullptr) : nullptr;
+    if (stream) {
+        stream->time_base = encoder->time_base;
+        avcodec_parameters_from_context(stream->codecpar, encoder);
+        isOk = avio_open(&output->pb, fileName.c_str(), AVIO_FLAG_WRITE) >= 0 &&
+               avformat_write_header(output, nullptr) >= 0;
+    }
+
+    AVFrame* frame = av_frame_alloc();
+    frame->format = encoder->pix_fmt;
+    frame->width = encoder->width;
+    frame->height = encoder->height;
+    isOk = isOk && stream && av_frame_get_buffer(frame, 0) >= 0;
+
+    for (int i = 0; isOk && i < options.frames; ++i) {
+        av_frame_make_writable(frame);
+        fillFrame(frame, i);
+        frame->pts = i;
+        isOk = writeFrames(encoder, frame, output, stream);
+    }
+    if (isOk) {
+        writeFrames(encoder, nullptr, output, stream);
+        av_write_trailer(output);
+    }
+
+    av_frame_free(&frame);
+    avcodec_free_context(&encoder);
+    if (output->pb) avio_closep(&output->pb);
+    avformat_free_context(output);
+    return isOk;
+}
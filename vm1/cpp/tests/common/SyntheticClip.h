@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+}
+
+#include <cstdint>
+#include <string>
+
+struct SyntheticClipOptions {
+    const char* muxer = "matroska";
+    AVPixelFormat format = AV_PIX_FMT_YUV420P;
+    int width = 1280;
+    int height = 720;
+    int frameRate = 60;
+    int frames = 600;
+    int gopSize = 60;
+    bool isFixedGop = false;    // no extra keyframes at scene cuts
+    int64_t bitRate = 8000000;
+};
+
+// Encodes moving gradients with some noise as H.264, so the encoder can't reduce
+// them to nothing. False without an encoder for the pixel format.
+bool createSyntheticClip(const std::string& fileName, const SyntheticClipOptions& options);
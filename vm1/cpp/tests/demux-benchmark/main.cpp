@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "DemuxThread.h"
+#include "FrameRing.h"
+#include "ReadAheadFile.h"
+#include "SyntheticClip.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static const int FRAME_RATE = 60;
+
+// Plays the file at 60 Hz through a FrameRing, like VideoPlayer and the main thread
+static void playFile(const std::string& fileName, const ReadThrottle& throttle, bool useDemuxThread)
+{
+    ReadAheadFile file;
+    if (!file.open(fileName)) {
+        printf("Couldn't open %s\n", fileName.c_str());
+        return;
+    }
+    file.setThrottle(throttle);
+
+    AVFormatContext* input = avformat_alloc_context();
+    input->pb = file.ioContext();
+    input->flags |= AVFMT_FLAG_CUSTOM_IO;
+    if (avformat_open_input(&input, fileName.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(input, nullptr) < 0) {
+        printf("Couldn't demux %s\n", fileName.c_str());
+        avformat_close_input(&input);
+        return;
+    }
+
+    int streamIndex = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    const AVCodec* codec = streamIndex >= 0 ? avcodec_find_decoder(input->streams[streamIndex]->codecpar->codec_id) : nullptr;
+    AVCodecContext* decoder = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (decoder) {
+        avcodec_parameters_to_context(decoder, input->streams[streamIndex]->codecpar);
+        decoder->pkt_timebase = input->streams[streamIndex]->time_base;
+        decoder->thread_count = 2;
+    }
+    if (!decoder || avcodec_open2(decoder, codec, nullptr) < 0) {
+        printf("Couldn't open the decoder\n");
+        avcodec_free_context(&decoder);
+        avformat_close_input(&input);
+        return;
+    }
+
+    DemuxThread demuxThread;
+    if (useDemuxThread) demuxThread.start(input);
+
+    FrameRing<int64_t> frames;
+    std::atomic<bool> isRunning = true;
+    std::atomic<bool> isDecoding = true;
+    std::thread decoderThread([&]() {
+        AVPacket* packet = av_packet_alloc();
+        AVFrame* frame = av_frame_alloc();
+        int64_t index = 0;
+        auto receiveFrames = [&]() {
+            while (avcodec_receive_frame(decoder, frame) >= 0) {
+                av_frame_unref(frame);
+                int64_t value = index++;
+                frames.pushFrame(value);
+            }
+        };
+
+        while (isRunning) {
+            int result = useDemuxThread ? demuxThread.readPacket(packet, isRunning) : av_read_frame(input, packet);
+            if (result < 0) break;
+            if (packet->stream_index == streamIndex) {
+                avcodec_send_packet(decoder, packet);
+                receiveFrames();
+            }
+            av_packet_unref(packet);
+        }
+        avcodec_send_packet(decoder, nullptr);
+        receiveFrames();
+
+        av_frame_free(&frame);
+        av_packet_free(&packet);
+        isDecoding = false;
+    });
+
+    // The clock starts with the first frame, like a triggered clip
+    while (!frames.isFrameReady() && isDecoding) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const auto period = std::chrono::microseconds(1000000 / FRAME_RATE);
+    auto nextTick = Clock::now();
+    auto lastFrameTime = nextTick;
+    int shownFrames = 0;
+    int lateTicks = 0;
+    double longestGapMs = 0.0;
+    while (isDecoding || frames.isFrameReady()) {
+        std::this_thread::sleep_until(nextTick);
+        nextTick += period;
+
+        int64_t index = 0;
+        if (frames.popFrame(index)) {
+            auto now = Clock::now();
+            if (shownFrames > 0) {
+                longestGapMs = std::max(longestGapMs, std::chrono::duration<double, std::milli>(now - lastFrameTime).count());
+            }
+            lastFrameTime = now;
+            shownFrames++;
+        }
+        else if (isDecoding) {
+            lateTicks++;
+        }
+    }
+
+    isRunning = false;
+    frames.setActive(false);
+    decoderThread.join();
+    demuxThread.stop();
+
+    printf("%-12s latency: %4ld ms  frames: %4d  late ticks: %4d  longest gap: %6.1f ms  chunk reads: %3lu  slowest read: %6.1f ms",
+           useDemuxThread ? "demux thread" : "inline",
+           long(std::chrono::duration_cast<std::chrono::milliseconds>(throttle.latency).count()),
+           shownFrames,
+           lateTicks,
+           longestGapMs,
+           (unsigned long)file.stats().chunkReads,
+           double(file.stats().slowestReadMs));
+    if (useDemuxThread) printf("  underruns: %lu", (unsigned long)demuxThread.stats().underruns);
+    printf("\n");
+
+    avcodec_free_context(&decoder);
+    avformat_close_input(&input);
+    file.close();
+}
+
+int main(int argc, char** argv)
+{
+    av_log_set_level(AV_LOG_ERROR);
+
+    std::string fileName = "/tmp/vm1-demux-benchmark.mkv";
+    bool isOwnFile = argc > 1;
+    if (isOwnFile) {
+        fileName = argv[1];
+    }
+    else {
+        printf("Encoding 600 frames 1280x720 H.264 at 25 Mbit/s\n");
+        SyntheticClipOptions options;
+        options.frameRate = FRAME_RATE;
+        options.frames = 600;
+        options.bitRate = 25000000;
+        if (!createSyntheticClip(fileName, options)) {
+            printf("No clip could be encoded, pass an existing file instead\n");
+            return 1;
+        }
+    }
+
+    // Roughly an SD card that is busy with other players: slow chunk reads at 20 MB/s
+    const int latencies[] = { 0, 50, 150 };
+    for (int latency : latencies) {
+        ReadThrottle throttle;
+        throttle.latency = std::chrono::milliseconds(latency);
+        throttle.bytesPerSecond = 20 * 1024 * 1024;
+        playFile(fileName, throttle, false);
+        playFile(fileName, throttle, true);
+    }
+
+    if (!isOwnFile) std::remove(fileName.c_str());
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "ThreadableQueue.h"
+#include "FrameRing.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Same layout as the VideoFrame the players exchanged when the ring was introduced
+struct BenchFrame {
+    bool isFirstFrame = false;
+    double pts = 0.0;
+    double absolutePts = 0.0;
+    int index = -1;
+
+    std::vector<uint32_t> formats;
+    std::vector<int> widths;
+    std::vector<int> heights;
+    std::vector<int> fds;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> pitches;
+};
+
+static void fillFrame(BenchFrame& frame, int index)
+{
+    // Mirrors VideoPlayer::getTextureForDRMFrame (one layer, two planes)
+    for (int j = 0; j < 2; ++j) {
+        frame.formats.push_back(j == 0 ? 0x20203852 : 0x38385247);
+        frame.widths.push_back(1920);
+        frame.heights.push_back(1080);
+        frame.fds.push_back(42);
+        frame.offsets.push_back(j * 1920 * 1088);
+        frame.pitches.push_back(1920);
+    }
+    frame.index = index;
+    frame.pts = index / 60.0;
+    frame.absolutePts = frame.pts;
+}
+
+struct Result {
+    uint64_t frames = 0;
+    double handoffNsTotal = 0.0;
+    double handoffNsMax = 0.0;
+};
+
+// Adapters so both queues can be driven by the same player loop
+struct OldQueue {
+    ThreadableQueue<BenchFrame> queue;
+    void push(BenchFrame& frame) { queue.pushFrame(frame); }
+    bool peekPts(double& pts) {
+        BenchFrame frame;
+        if (!queue.peekFrame(frame)) return false;
+        pts = frame.pts;
+        return true;
+    }
+    bool pop(BenchFrame& frame) { return queue.popFrame(frame); }
+    void stop() { queue.setActive(false); }
+};
+
+struct NewQueue {
+    FrameRing<BenchFrame> queue;
+    void push(BenchFrame& frame) { queue.pushFrame(std::move(frame)); }
+    bool peekPts(double& pts) {
+        const BenchFrame* frame = queue.peekFrame();
+        if (!frame) return false;
+        pts = frame->pts;
+        return true;
+    }
+    bool pop(BenchFrame& frame) { return queue.popFrame(frame); }
+    void stop() { queue.setActive(false); }
+};
+
+template<typename Queue>
+static Result runPlayer(Queue& queue, std::atomic<bool>& isRunning, bool paced)
+{
+    Result result;
+    std::thread producer([&]() {
+        int index = 0;
+        while (isRunning) {
+            BenchFrame frame;
+            fillFrame(frame, index++);
+            queue.push(frame);
+        }
+    });
+
+    const auto frameTime = std::chrono::microseconds(16667);
+    auto nextTick = Clock::now();
+    while (isRunning) {
+        auto start = Clock::now();
+        double pts = 0.0;
+        BenchFrame frame;
+        if (queue.peekPts(pts) && queue.pop(frame)) {
+            auto end = Clock::now();
+            double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            result.handoffNsTotal += ns;
+            result.handoffNsMax = std::max(result.handoffNsMax, ns);
+            result.frames++;
+        }
+        else if (!paced) {
+            std::this_thread::yield();
+        }
+
+        if (paced) {
+            nextTick += frameTime;
+            std::this_thread::sleep_until(nextTick);
+        }
+    }
+
+    queue.stop();
+    BenchFrame frame;
+    while (queue.pop(frame)) {}
+    producer.join();
+
+    return result;
+}
+
+static double cpuSeconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+template<typename Queue>
+static void runBenchmark(const char* name, int players, int seconds, bool paced)
+{
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<Result> results(players);
+    std::vector<std::thread> threads;
+    std::atomic<bool> isRunning = true;
+
+    for (int i = 0; i < players; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    double cpuStart = cpuSeconds();
+    auto wallStart = Clock::now();
+    for (int i = 0; i < players; ++i) {
+        threads.emplace_back([&, i]() { results[i] = runPlayer(*queues[i], isRunning, paced); });
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    isRunning = false;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double wall = std::chrono::duration<double>(Clock::now() - wallStart).count();
+    double cpu = cpuSeconds() - cpuStart;
+
+    Result total;
+    for (const auto& result : results) {
+        total.frames += result.frames;
+        total.handoffNsTotal += result.handoffNsTotal;
+        total.handoffNsMax = std::max(total.handoffNsMax, result.handoffNsMax);
+    }
+
+    double avgNs = total.frames ? total.handoffNsTotal / double(total.frames) : 0.0;
+    printf("%-16s %-8s frames: %9lu  fps/player: %10.1f  handoff avg: %8.1f ns  max: %10.1f ns  cpu: %6.1f%%\n",
+           name,
+           paced ? "60fps" : "unpaced",
+           (unsigned long)total.frames,
+           double(total.frames) / wall / players,
+           avgNs,
+           total.handoffNsMax,
+           100.0 * cpu / wall);
+}
+
+int main(int argc, char** argv)
+{
+    int players = argc > 1 ? std::atoi(argv[1]) : 10;
+    int seconds = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    printf("Players: %d, duration: %ds per run\n", players, seconds);
+    runBenchmark<OldQueue>("ThreadableQueue", players, seconds, true);
+    runBenchmark<NewQueue>("FrameRing", players, seconds, true);
+    runBenchmark<OldQueue>("ThreadableQueue", players, seconds, false);
+    runBenchmark<NewQueue>("FrameRing", players, seconds, false);
+
+    return 0;
+}
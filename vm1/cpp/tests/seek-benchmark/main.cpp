@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "KeyframeIndex.h"
+#include "SyntheticClip.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const int FRAME_RATE = 60;
+static const int SEEK_COUNT = 50;
+
+static double millisecondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct SeekResult {
+    double milliseconds = 0.0;
+    int droppedFrames = 0;
+    int predictedFrames = 0;
+    bool isExact = false;
+};
+
+struct SeekSummary {
+    double totalMs = 0.0;
+    double worstMs = 0.0;
+    uint64_t droppedFrames = 0;
+    uint64_t predictedFrames = 0;
+    int exactSeeks = 0;
+    int seeks = 0;
+
+    void add(const SeekResult& result)
+    {
+        totalMs += result.milliseconds;
+        worstMs = std::max(worstMs, result.milliseconds);
+        droppedFrames += result.droppedFrames;
+        predictedFrames += result.predictedFrames;
+        exactSeeks += result.isExact ? 1 : 0;
+        seeks++;
+    }
+};
+
+// Decodes from the current position and drops frames until the target, like VideoPlayer::run()
+static void decodeToTarget(AVFormatContext* input, AVCodecContext* decoder, int streamIndex, int64_t target, SeekResult& result)
+{
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    bool isFound = false;
+    bool isEndOfFile = false;
+    while (!isFound) {
+        if (av_read_frame(input, packet) < 0) {
+            isEndOfFile = true;
+            avcodec_send_packet(decoder, nullptr);
+        }
+        else {
+            if (packet->stream_index == streamIndex) avcodec_send_packet(decoder, packet);
+            av_packet_unref(packet);
+        }
+
+        while (!isFound && avcodec_receive_frame(decoder, frame) >= 0) {
+            if (frame->pts != AV_NOPTS_VALUE && frame->pts < target) {
+                result.droppedFrames++;
+            }
+            else {
+                isFound = true;
+                result.isExact = frame->pts == target;
+            }
+            av_frame_unref(frame);
+        }
+        if (isEndOfFile) break;
+    }
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+}
+
+static SeekResult seekSearched(AVFormatContext* input, AVCodecContext* decoder, int streamIndex, int64_t target)
+{
+    SeekResult result;
+    auto start = Clock::now();
+    if (av_seek_frame(input, streamIndex, target, AVSEEK_FLAG_BACKWARD) >= 0) {
+        avcodec_flush_buffers(decoder);
+        decodeToTarget(input, decoder, streamIndex, target, result);
+    }
+    result.milliseconds = millisecondsSince(start);
+    return result;
+}
+
+// Same policy as VideoPlayer::seekToInPoint()
+static SeekResult seekIndexed(AVFormatContext* input, AVCodecContext* decoder, const KeyframeIndex& index, int64_t target)
+{
+    int streamIndex = index.streamIndex();
+    AVStream* stream = input->streams[streamIndex];
+
+    SeekResult result;
+    auto start = Clock::now();
+    const KeyframeEntry* keyframe = index.find(target);
+    if (!keyframe) return seekSearched(input, decoder, streamIndex, target);
+
+    bool useBytePosition = keyframe->position >= 0 &&
+                           !(input->iformat->flags & AVFMT_NO_BYTE_SEEK) &&
+                           avformat_index_get_entries_count(stream) == 0;
+    int seekResult = useBytePosition ?
+        av_seek_frame(input, streamIndex, keyframe->position, AVSEEK_FLAG_BYTE) :
+        av_seek_frame(input, streamIndex, keyframe->pts, AVSEEK_FLAG_BACKWARD);
+    if (seekResult >= 0) {
+        result.predictedFrames = index.framesToDiscard(*keyframe, target);
+        avcodec_flush_buffers(decoder);
+        decodeToTarget(input, decoder, streamIndex, target, result);
+    }
+    result.milliseconds = millisecondsSince(start);
+    return result;
+}
+
+static void printSummary(const char* name, const SeekSummary& summary, bool showPrediction)
+{
+    if (summary.seeks == 0) return;
+    printf("  %-8s avg: %6.2f ms  worst: %6.2f ms  dropped/seek: %5.1f",
+           name,
+           summary.totalMs / summary.seeks,
+           summary.worstMs,
+           double(summary.droppedFrames) / summary.seeks);
+    if (showPrediction) printf(" (predicted %5.1f)", double(summary.predictedFrames) / summary.seeks);
+    printf("  exact: %d/%d\n", summary.exactSeeks, summary.seeks);
+}
+
+static void benchmarkFile(const std::string& fileName)
+{
+    printf("\n%s\n", fileName.c_str());
+
+    KeyframeIndex index;
+    auto buildStart = Clock::now();
+    if (!index.build(fileName)) {
+        printf("  Couldn't index\n");
+        return;
+    }
+    printf("  index: %zu keyframes, built in %.1f ms\n", index.size(), millisecondsSince(buildStart));
+
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, fileName.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(input, nullptr) < 0) {
+        printf("  Couldn't open\n");
+        return;
+    }
+
+    int streamIndex = index.streamIndex();
+    AVStream* stream = input->streams[streamIndex];
+    const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    AVCodecContext* decoder = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (decoder) {
+        avcodec_parameters_to_context(decoder, stream->codecpar);
+        decoder->pkt_timebase = stream->time_base;
+        // One thread, so the frame threading delay doesn't hide the dropped frames
+        decoder->thread_count = 1;
+    }
+    if (!decoder || avcodec_open2(decoder, codec, nullptr) < 0) {
+        printf("  Couldn't open the decoder\n");
+        avcodec_free_context(&decoder);
+        avformat_close_input(&input);
+        return;
+    }
+
+    // Whole frames from the start of the stream, the same targets for both runs
+    AVRational frameRate = stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate : AVRational{ FRAME_RATE, 1 };
+    int64_t startPts = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    int64_t duration = input->duration > 0 ? av_rescale_q(input->duration, AV_TIME_BASE_Q, av_inv_q(frameRate)) : 0;
+    if (duration < 2) {
+        printf("  Unknown duration\n");
+        avcodec_free_context(&decoder);
+        avformat_close_input(&input);
+        return;
+    }
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int64_t> frames(0, duration - 2);
+    std::vector<int64_t> targets;
+    for (int i = 0; i < SEEK_COUNT; ++i) {
+        targets.push_back(startPts + av_rescale_q(frames(random), av_inv_q(frameRate), stream->time_base));
+    }
+
+    SeekSummary searched;
+    for (int64_t target : targets) {
+        searched.add(seekSearched(input, decoder, streamIndex, target));
+    }
+    SeekSummary indexed;
+    for (int64_t target : targets) {
+        indexed.add(seekIndexed(input, decoder, index, target));
+    }
+    printSummary("searched", searched, false);
+    printSummary("indexed", indexed, true);
+
+    avcodec_free_context(&decoder);
+    avformat_close_input(&input);
+}
+
+int main(int argc, char** argv)
+{
+    av_log_set_level(AV_LOG_ERROR);
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            benchmarkFile(argv[i]);
+        }
+        return 0;
+    }
+
+    const int frames = 600;
+    const int gopSizes[] = { 12, 60, 250 };
+    struct Container { const char* muxer; const char* extension; };
+    const Container containers[] = {
+        { "matroska", "mkv" },
+        { "mp4", "mp4" },
+        { "mpegts", "ts" },     // no index in the container, byte seeks
+    };
+
+    bool hasClip = false;
+    for (int gopSize : gopSizes) {
+        for (const auto& container : containers) {
+            std::string fileName = "/tmp/vm1-seek-benchmark-gop" + std::to_string(gopSize) + "." + container.extension;
+            SyntheticClipOptions options;
+            options.muxer = container.muxer;
+            options.frameRate = FRAME_RATE;
+            options.frames = frames;
+            options.gopSize = gopSize;
+            options.isFixedGop = true;
+            if (!createSyntheticClip(fileName, options)) continue;
+            hasClip = true;
+            benchmarkFile(fileName);
+            std::remove(fileName.c_str());
+        }
+    }
+
+    if (!hasClip) {
+        printf("No clip could be encoded, pass existing files instead\n");
+        return 1;
+    }
+    return 0;
+}
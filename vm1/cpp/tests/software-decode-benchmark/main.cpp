@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "SoftwareDecode.h"
+#include "SyntheticClip.h"
+
+extern "C"
+{
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double cpuSeconds()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+static AVPixelFormat getDrmFormat(AVCodecContext*, const AVPixelFormat* formats)
+{
+    for (const AVPixelFormat* format = formats; *format != AV_PIX_FMT_NONE; ++format) {
+        if (*format == AV_PIX_FMT_DRM_PRIME) return *format;
+    }
+    return AV_PIX_FMT_NONE;
+}
+
+// Same setup as VideoPlayer::openVideoStream(), nullptr without a DRM device
+static AVCodecContext* openHardwareDecoder(const AVStream* stream)
+{
+    const AVCodec* codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (!codec) return nullptr;
+
+    AVCodecContext* context = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(context, stream->codecpar);
+    context->pkt_timebase = stream->time_base;
+    if (av_hwdevice_ctx_create(&context->hw_device_ctx, AV_HWDEVICE_TYPE_DRM, nullptr, nullptr, 0) < 0) {
+        avcodec_free_context(&context);
+        return nullptr;
+    }
+    context->get_format = getDrmFormat;
+    if (avcodec_open2(context, codec, nullptr) < 0) {
+        avcodec_free_context(&context);
+        return nullptr;
+    }
+    return context;
+}
+
+// Decodes the whole file as fast as possible. The pool is released right after
+// storing, like a main thread that uploads every frame immediately.
+static void runBenchmark(const std::string& fileName, DecodeRoute route, int threads)
+{
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, fileName.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(input, nullptr) < 0) {
+        printf("Couldn't open %s\n", fileName.c_str());
+        return;
+    }
+
+    int streamIndex = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (streamIndex < 0) {
+        avformat_close_input(&input);
+        return;
+    }
+    AVStream* stream = input->streams[streamIndex];
+
+    AVCodecContext* decoder = (route == DecodeRoute::Hardware) ? openHardwareDecoder(stream) : openSoftwareDecoder(stream, threads);
+    if (!decoder) {
+        printf("%-8s unavailable\n", decodeRouteName(route));
+        avformat_close_input(&input);
+        return;
+    }
+
+    SoftwareFramePool pool;
+    std::atomic<bool> isRunning = true;
+    AVPacket* packet = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    uint64_t frames = 0;
+
+    auto receiveFrames = [&]() {
+        while (avcodec_receive_frame(decoder, frame) >= 0) {
+            if (route == DecodeRoute::Software) {
+                int slot = pool.store(frame, isRunning);
+                pool.release(slot);
+            }
+            av_frame_unref(frame);
+            frames++;
+        }
+    };
+
+    double cpuStart = cpuSeconds();
+    auto wallStart = Clock::now();
+    while (av_read_frame(input, packet) >= 0) {
+        if (packet->stream_index == streamIndex) {
+            avcodec_send_packet(decoder, packet);
+            receiveFrames();
+        }
+        av_packet_unref(packet);
+    }
+    avcodec_send_packet(decoder, nullptr);
+    receiveFrames();
+    double wall = std::chrono::duration<double>(Clock::now() - wallStart).count();
+    double cpu = cpuSeconds() - cpuStart;
+
+    printf("%-8s threads: %2d  %-8s frames: %5lu  fps: %7.1f  converted: %5lu  cpu: %6.1f%%\n",
+           decodeRouteName(route),
+           route == DecodeRoute::Software ? decoder->thread_count : 0,
+           av_get_pix_fmt_name(AVPixelFormat(stream->codecpar->format)),
+           (unsigned long)frames,
+           double(frames) / wall,
+           (unsigned long)pool.stats().convertedFrames,
+           100.0 * cpu / wall);
+
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&decoder);
+    avformat_close_input(&input);
+}
+
+static void benchmarkFile(const std::string& fileName)
+{
+    AVFormatContext* input = nullptr;
+    if (avformat_open_input(&input, fileName.c_str(), nullptr, nullptr) < 0 ||
+        avformat_find_stream_info(input, nullptr) < 0) {
+        printf("Couldn't open %s\n", fileName.c_str());
+        return;
+    }
+    int streamIndex = av_find_best_stream(input, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    DecodeRoute route = streamIndex >= 0 ? selectDecodeRoute(input->streams[streamIndex]->codecpar) : DecodeRoute::None;
+    avformat_close_input(&input);
+
+    printf("\n%s: the player would use the %s route\n", fileName.c_str(), decodeRouteName(route));
+    if (route == DecodeRoute::None) return;
+
+    // Hardware route files are measured both ways, software ones can't take the hardware route
+    if (route == DecodeRoute::Hardware) runBenchmark(fileName, DecodeRoute::Hardware, 0);
+
+    int cores = int(std::thread::hardware_concurrency());
+    std::vector<int> threadCounts = { 1, DecodeBudget::instance().threadLimit() };
+    if (cores > threadCounts.back()) threadCounts.push_back(cores);
+    for (int threads : threadCounts) {
+        runBenchmark(fileName, DecodeRoute::Software, threads);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    av_log_set_level(AV_LOG_ERROR);
+
+    // Own files (e.g. a 1080p HEVC clip for the hardware route) or the synthetic clips
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            benchmarkFile(argv[i]);
+        }
+        return 0;
+    }
+
+    const int frames = 300;
+    struct Clip { const char* fileName; AVPixelFormat format; };
+    const Clip clips[] = {
+        { "/tmp/vm1-decode-benchmark-420.mkv", AV_PIX_FMT_YUV420P },
+        { "/tmp/vm1-decode-benchmark-422.mkv", AV_PIX_FMT_YUV422P },   // goes through swscale
+    };
+
+    bool hasClip = false;
+    for (const auto& clip : clips) {
+        printf("Encoding %d frames 1920x1080 %s H.264\n", frames, av_get_pix_fmt_name(clip.format));
+        SyntheticClipOptions options;
+        options.format = clip.format;
+        options.width = 1920;
+        options.height = 1080;
+        options.frames = frames;
+        options.bitRate = 20000000;
+        if (!createSyntheticClip(clip.fileName, options)) continue;
+        hasClip = true;
+        benchmarkFile(clip.fileName);
+        std::remove(clip.fileName);
+    }
+
+    if (!hasClip) {
+        printf("No clip could be encoded, pass existing files instead\n");
+        return 1;
+    }
+    return 0;
+}
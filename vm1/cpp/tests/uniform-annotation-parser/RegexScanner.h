@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#pragma once
+
+#include <regex>
+#include <string>
+#include <vector>
+
+// The std::regex scan Shader::extractUniformMetadata() used before scanUniformAnnotations()
+struct RegexAnnotation {
+    std::string type;
+    std::string name;
+    std::string json;
+};
+
+inline std::vector<RegexAnnotation> regexScanUniformAnnotations(const std::string& source)
+{
+    static std::regex uniform_regex(R"(^\s*(?:uniform\s+)?(\w+)\s+(\w+)\s*;\s*//\s*(\{.*\}))", std::regex::multiline);
+
+    std::vector<RegexAnnotation> annotations;
+    std::sregex_iterator next(source.begin(), source.end(), uniform_regex);
+    std::sregex_iterator end;
+    while (next != end) {
+        std::smatch match = *next;
+        annotations.push_back({match[1].str(), match[2].str(), match[3].str()});
+        next++;
+    }
+    return annotations;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "UniformAnnotationParser.h"
+#include "RegexScanner.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+struct ShaderSource {
+    std::string name;
+    std::string source;
+};
+
+static bool readFile(const fs::path& path, std::string& content)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+static void replaceAll(std::string& source, const std::string& from, const std::string& to)
+{
+    size_t pos = 0;
+    while ((pos = source.find(from, pos)) != std::string::npos) {
+        source.replace(pos, from.size(), to);
+        pos += to.size();
+    }
+}
+
+static std::vector<fs::path> fragFiles(const fs::path& directory)
+{
+    std::vector<fs::path> files;
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(directory, error)) {
+        if (entry.path().extension() == ".frag") files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// The sources Shader::load() scans: the plane shader with every effect spliced in and the generative shaders
+static std::vector<ShaderSource> shippedSources(const fs::path& internalDir, const fs::path& userDir)
+{
+    std::vector<ShaderSource> sources;
+
+    std::string planeSource;
+    if (readFile(internalDir / "plane_with_effects.frag", planeSource)) {
+        sources.push_back({"plane_with_effects.frag", planeSource});
+        for (const fs::path& effectPath : fragFiles(userDir / "effect")) {
+            std::string effectSource;
+            if (!readFile(effectPath, effectSource)) continue;
+            std::string source = planeSource;
+            replaceAll(source, "//###EXT_MAIN_DEF###", effectSource);
+            replaceAll(source, "//###EXT_MAIN_USE###", "extMain(color, coord);");
+            sources.push_back({"plane + " + effectPath.filename().string(), source});
+        }
+    }
+
+    for (const fs::path& generativePath : fragFiles(userDir / "generative")) {
+        std::string source;
+        if (readFile(generativePath, source)) sources.push_back({generativePath.filename().string(), source});
+    }
+
+    return sources;
+}
+
+template<typename Function>
+static double measureUs(int iterations, Function function)
+{
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        function();
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    fs::path internalDir = argc > 2 ? argv[2] : "../../shaders";
+    fs::path userDir = argc > 3 ? argv[3] : "../../../shaders";
+
+    std::vector<ShaderSource> sources = shippedSources(internalDir, userDir);
+    if (sources.empty()) {
+        printf("No shaders found in %s and %s\n", internalDir.c_str(), userDir.c_str());
+        return 1;
+    }
+
+    printf("Iterations: %d per source (microseconds per load)\n", iterations);
+    printf("%-40s %6s %12s %12s %12s %12s\n", "source", "annot.", "regex", "scanner", "regex+json", "cached");
+
+    double totals[4] = {0.0, 0.0, 0.0, 0.0};
+    size_t sink = 0;
+    for (const ShaderSource& shader : sources) {
+        std::vector<UniformAnnotation> annotations;
+        scanUniformAnnotations(shader.source, annotations);
+        if (annotations.size() != regexScanUniformAnnotations(shader.source).size()) {
+            printf("Scanner and regex disagree on %s\n", shader.name.c_str());
+            return 1;
+        }
+
+        double regexUs = measureUs(iterations, [&]() {
+            sink += regexScanUniformAnnotations(shader.source).size();
+        });
+
+        double scannerUs = measureUs(iterations, [&]() {
+            std::vector<UniformAnnotation> result;
+            sink += scanUniformAnnotations(shader.source, result);
+        });
+
+        // Full metadata pass before (regex + json per annotation) and on a cache hit now
+        double regexJsonUs = measureUs(iterations, [&]() {
+            for (const RegexAnnotation& annotation : regexScanUniformAnnotations(shader.source)) {
+                sink += json::parse(annotation.json).size();
+            }
+        });
+
+        std::unordered_map<size_t, std::shared_ptr<std::vector<json>>> cache;
+        auto parsed = std::make_shared<std::vector<json>>();
+        for (const UniformAnnotation& annotation : annotations) {
+            parsed->push_back(json::parse(annotation.json.begin(), annotation.json.end(), nullptr, false));
+        }
+        cache[std::hash<std::string>{}(shader.source)] = parsed;
+        double cachedUs = measureUs(iterations, [&]() {
+            auto it = cache.find(std::hash<std::string>{}(shader.source));
+            sink += it->second->size();
+        });
+
+        printf("%-40s %6zu %12.1f %12.1f %12.1f %12.1f\n", shader.name.c_str(), annotations.size(), regexUs, scannerUs, regexJsonUs, cachedUs);
+        totals[0] += regexUs;
+        totals[1] += scannerUs;
+        totals[2] += regexJsonUs;
+        totals[3] += cachedUs;
+    }
+
+    printf("%-40s %6s %12.1f %12.1f %12.1f %12.1f\n", "total", "", totals[0], totals[1], totals[2], totals[3]);
+    printf("Scanner speedup over regex: %.1fx, cached metadata over regex+json: %.1fx (checksum %zu)\n",
+           totals[0] / std::max(totals[1], 1e-9), totals[2] / std::max(totals[3], 1e-9), sink);
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023-2026 Nils Zweiling & Julian Jungel
+ *
+ * This file is part of VM-1 which is released under the MIT license.
+ * See file LICENSE or go to https://github.com/zwodev/vm1-video-mixer/tree/master/LICENSE
+ * for full license details.
+ */
+
+#include "UniformAnnotationParser.h"
+#include "RegexScanner.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Fragments annotated declarations are made of, including the broken variants
+static const std::vector<std::string> s_tokens = {
+    "uniform", "uniform", "float", "int", "vec2", "uint", "ChromaKey_Enable", "iTime", "x", "_a1",
+    " ", " ", "  ", "\t", "\n", "\r\n", "\r", "\v", "\f",
+    ";", ";", "//", "//", "/", "/*", "*/",
+    "{", "{", "}", "}", "{}", "{ \"name\": \"Gain\", \"min\": 0.0, \"max\": 1.0 }",
+    "\"", "\"group\"", ":", ",", "[0.5, 0.5]", "-1.0", "1e9", "null", "true", "\\", "\\u00", "[", "]",
+    "\xc3\xa4", "\xff", std::string(1, '\0'),
+};
+
+static const std::vector<std::string> s_validLines = {
+    "uniform float ChromaKey_Threshold; // { \"name\": \"Threshold\", \"group\": \"Chroma Key\", \"min\": 0.0, \"max\": 1.0 }\n",
+    "\tfloat ColorCorrection_Gamma;\t  // { \"name\": \"Gamma\", \"group\": \"Color Correction\", \"default\": 1.0 }\n",
+    "uniform vec2 offset; // { \"name\": \"Offset\", \"min\": [0.0, 0.0], \"max\": [1.0, 1.0] }\n",
+    "uniform int mode; // { \"name\": \"Mode\", \"min\": 0, \"max\": 3 } // trailing }\n",
+    "void main() { gl_FragColor = vec4(1.0); }\n",
+};
+
+static std::string randomSource(std::mt19937& random)
+{
+    std::string source;
+    int parts = std::uniform_int_distribution<int>(1, 24)(random);
+    for (int i = 0; i < parts; ++i) {
+        int kind = std::uniform_int_distribution<int>(0, 9)(random);
+        if (kind < 6) {
+            source += s_tokens[std::uniform_int_distribution<size_t>(0, s_tokens.size() - 1)(random)];
+        }
+        else if (kind < 8) {
+            source += s_validLines[std::uniform_int_distribution<size_t>(0, s_validLines.size() - 1)(random)];
+        }
+        else {
+            source += char(std::uniform_int_distribution<int>(0, 255)(random));
+        }
+    }
+
+    // Mutate a few bytes of the assembled source
+    int mutations = std::uniform_int_distribution<int>(0, 3)(random);
+    for (int i = 0; i < mutations && !source.empty(); ++i) {
+        size_t pos = std::uniform_int_distribution<size_t>(0, source.size() - 1)(random);
+        switch (std::uniform_int_distribution<int>(0, 2)(random)) {
+            case 0: source.erase(pos, 1); break;
+            case 1: source.insert(pos, 1, char(std::uniform_int_distribution<int>(0, 255)(random))); break;
+            default: source[pos] = char(std::uniform_int_distribution<int>(0, 255)(random)); break;
+        }
+    }
+    return source;
+}
+
+static void printEscaped(const std::string& text)
+{
+    for (unsigned char c : text) {
+        if (c == '\n') printf("\\n");
+        else if (c == '\r') printf("\\r");
+        else if (c == '\t') printf("\\t");
+        else if (c < 0x20 || c >= 0x7f) printf("\\x%02x", c);
+        else putchar(c);
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 100000;
+    unsigned seed = argc > 2 ? unsigned(std::strtoul(argv[2], nullptr, 10)) : std::random_device{}();
+    printf("Iterations: %d, seed: %u\n", iterations, seed);
+
+    std::mt19937 random(seed);
+    size_t annotationCount = 0;
+    size_t malformedCount = 0;
+    for (int i = 0; i < iterations; ++i) {
+        std::string source = randomSource(random);
+
+        // The scanner has to find exactly what the regex found
+        std::vector<UniformAnnotation> annotations;
+        scanUniformAnnotations(source, annotations);
+        std::vector<RegexAnnotation> expected = regexScanUniformAnnotations(source);
+
+        bool isEqual = annotations.size() == expected.size();
+        for (size_t j = 0; isEqual && j < annotations.size(); ++j) {
+            isEqual = annotations[j].type == expected[j].type &&
+                      annotations[j].name == expected[j].name &&
+                      annotations[j].json == expected[j].json;
+        }
+        if (!isEqual) {
+            printf("Mismatch in iteration %d (scanner: %zu, regex: %zu annotations), source:\n", i, annotations.size(), expected.size());
+            printEscaped(source);
+            return 1;
+        }
+
+        // Malformed JSON must be rejected without throwing, as Shader does it
+        for (const UniformAnnotation& annotation : annotations) {
+            json data = json::parse(annotation.json.begin(), annotation.json.end(), nullptr, false);
+            if (data.is_discarded()) malformedCount++;
+            annotationCount++;
+        }
+    }
+
+    printf("OK: %zu annotations compared, %zu with malformed JSON rejected\n", annotationCount, malformedCount);
+    return 0;
+}
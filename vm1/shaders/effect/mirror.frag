@@ -7,9 +7,13 @@
  */
 
 
-uniform int enabled;        // { "name": "Enabled", "group": "Mirror", "default": 1, "min": 0, "max": 1 }
-uniform int axis;           // { "name": "Horizontal/Vertical", "group": "Mirror", "default": 0, "min": 0, "max": 1, "step": 1 }
-uniform float axisPos;      // { "name": "Axis Position", "group": "Mirror", "default": 0.5, "min": 0.0, "max": 1.0, "step": 0.01 }
+// Parameters in a std140 block are uploaded as one buffer, plain uniforms work as well.
+// Block names have to be unique across the effect shaders.
+layout(std140) uniform MirrorParams {
+    int enabled;        // { "name": "Enabled", "group": "Mirror", "default": 1, "min": 0, "max": 1 }
+    int axis;           // { "name": "Horizontal/Vertical", "group": "Mirror", "default": 0, "min": 0, "max": 1, "step": 1 }
+    float axisPos;      // { "name": "Axis Position", "group": "Mirror", "default": 0.5, "min": 0.0, "max": 1.0, "step": 0.01 }
+};
 
 
 void extMain(inout vec4 color, in vec2 coord)
@@ -13,8 +13,7 @@ precision mediump float;
 in vec2 texCoord;
 out vec4 fragColor;
 
-const vec2 OUT_TEX_SIZE = vec2(1920.0f, 1080.0f);
-// uniform vec2 iResolution;
+uniform vec2 iResolution;    // render target size, see ShaderPlayer::render()
 uniform float iTime;    // { "name": "Elapsed Time", "default": 0.0, "min": 0.0, "max": 1000000.0, "step": 0.01 }
 uniform float analog0;
 uniform float analog1;
@@ -33,7 +32,6 @@ float circle( in vec2 p, in float r )
 
 void main() {
 	vec2 fragCoord = gl_FragCoord.xy;
-	vec2 iResolution = OUT_TEX_SIZE;
 
     vec2 p = (2.0*fragCoord-iResolution.xy)/iResolution.y;
     p.x -= offsetX;
@@ -7,7 +7,7 @@ precision mediump float;
 in vec2 texCoord;
 out vec4 fragColor;
 
-const vec2 OUT_TEX_SIZE = vec2(1920.0f, 1080.0f);
+uniform vec2 iResolution;    // render target size, see ShaderPlayer::render()
 uniform float iTime;
 uniform float analog0;
 uniform float analog1;
@@ -58,7 +58,6 @@ float fbm(vec2 n) {
 
 void main() {
 	vec2 fragCoord = gl_FragCoord.xy;
-	vec2 iResolution = OUT_TEX_SIZE;
 	
 	vec2 p = fragCoord.xy / iResolution.xy;
 	vec2 uv = p*vec2(iResolution.x/iResolution.y,1.0);    
@@ -13,8 +13,7 @@ precision mediump float;
 in vec2 texCoord;
 out vec4 fragColor;
 
-const vec2 OUT_TEX_SIZE = vec2(1920.0f, 1080.0f);
-// uniform vec2 iResolution;
+uniform vec2 iResolution;    // render target size, see ShaderPlayer::render()
 uniform float iTime;
 uniform float analog0;
 uniform float analog1;
@@ -28,7 +27,6 @@ uniform float alpha; // { "name": "Transparency", "default": 1.0, "min": 0.0, "m
 
 void main() {
 	vec2 fragCoord = gl_FragCoord.xy;
-	vec2 iResolution = OUT_TEX_SIZE;
 
 	fragColor = vec4(red, green, blue, alpha);
 }
\ No newline at end of file
@@ -11,7 +11,7 @@ precision mediump float;
 in vec2 texCoord;
 out vec4 fragColor;
 
-const vec2 OUT_TEX_SIZE = vec2(1920.0f, 1080.0f);
+uniform vec2 iResolution;    // render target size, see ShaderPlayer::render()
 uniform float iTime;
 uniform float analog0;
 uniform float analog1;
@@ -22,7 +22,7 @@ uniform float speed;    // { "name": "Speed", "default": 1.0, "min": 0.01, "max"
 
 void main() {
 	vec2 fragCoord = gl_FragCoord.xy;
-	vec2 r = OUT_TEX_SIZE;
+	vec2 r = iResolution;
 
 	vec3 c;
 	float l,z = iTime * speed;
@@ -7,7 +7,7 @@ precision mediump float;
 in vec2 texCoord;
 out vec4 fragColor;
 
-const vec2 OUT_TEX_SIZE = vec2(1920.0f, 1080.0f);
+uniform vec2 iResolution;    // render target size, see ShaderPlayer::render()
 uniform float iTime;
 uniform float analog0;
 uniform float analog1;
@@ -35,7 +35,6 @@ vec3 hsv2rgb(vec3 c)
 
 void main() {
 	vec2 fragCoord = gl_FragCoord.xy;
-	vec2 iResolution = OUT_TEX_SIZE;
 	
     float aspect = iResolution.y/iResolution.x;
     float value;
@@ -7,7 +7,7 @@ precision mediump float;
 in vec2 texCoord;
 out vec4 fragColor;
 
-const vec2 OUT_TEX_SIZE = vec2(1920.0f, 1080.0f);
+uniform vec2 iResolution;    // render target size, see ShaderPlayer::render()
 uniform float iTime;
 uniform float analog0;
 uniform float analog1;
@@ -20,7 +20,7 @@ uniform float size;     // { "name": "Size", "default": 1.0, "min": 0.01, "max":
 
 void main() {
 	vec2 fragCoord = gl_FragCoord.xy;
-	vec2 R = OUT_TEX_SIZE;
+	vec2 R = iResolution;
 
     // Normalize & Fix aspect-ratio + Diagonal scroll
     vec2 p = fragCoord/R.y + iTime*.1;